@@ -6,6 +6,51 @@
 //          http://www.boost.org/LICENSE_1_0.txt)
 
 #include <cstddef>
+#include <detail/api_string_hash.hpp>
+
+/**
+    `SPEUDO_STD_IS_CONSTANT_EVALUATED()` tells whether the current call is
+    being evaluated at compile time. When it is not available, the constexpr
+    functions below always call the runtime functions, and so can not be
+    constant evaluated.
+*/
+#if defined(__has_builtin)
+#  if __has_builtin(__builtin_is_constant_evaluated)
+#    define SPEUDO_STD_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#  endif
+#endif
+#if ! defined(SPEUDO_STD_IS_CONSTANT_EVALUATED)
+#  if (defined(__GNUC__) && ! defined(__clang__) && __GNUC__ >= 9) \
+   || (defined(_MSC_VER) && _MSC_VER >= 1925)
+#    define SPEUDO_STD_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#  endif
+#endif
+
+/**
+    `basic_api_string` has a non-trivial destructor, so it can only be a
+    literal type since C++20 ( that allows constexpr destructors ).
+    `SPEUDO_STD_CONSTEXPR_API_STRING` is `constexpr` in this case and
+    is used by the functions that return a `basic_api_string`.
+*/
+#if defined(__cpp_constexpr) && __cpp_constexpr >= 201907L
+#  define SPEUDO_STD_CONSTEXPR_API_STRING constexpr
+#else
+#  define SPEUDO_STD_CONSTEXPR_API_STRING
+#endif
+
+/**
+    `SPEUDO_STD_CONSTINIT` requires a variable to be initialized at compile
+    time, like C++20 `constinit`, using compiler extensions where available.
+*/
+#if defined(__cpp_constinit)
+#  define SPEUDO_STD_CONSTINIT constinit
+#elif defined(__clang__)
+#  define SPEUDO_STD_CONSTINIT [[clang::require_constant_initialization]]
+#elif defined(__GNUC__) && __GNUC__ >= 10
+#  define SPEUDO_STD_CONSTINIT __constinit
+#else
+#  define SPEUDO_STD_CONSTINIT
+#endif
 
 namespace speudo_std {
 
@@ -15,6 +60,15 @@ namespace api_string_test {
 std::size_t allocations_count();
 std::size_t deallocations_count();
 void reset();
+
+/**
+    Restricts the instruction set used by the vectorized functions ( find,
+    hash, UTF validation and transcoding ): 0 for the portable code, 1 for SSE2,
+    2 for AVX2, and -1 to restore the automatic selection. Returns the
+    level actually used, which is lower than the requested one when the
+    processor does not support it.
+*/
+int force_find_isa(int level);
 } // namespace api_string_test
 
 #endif // defined(API_STRING_TEST_MODE)
@@ -23,12 +77,30 @@ namespace abi {
 
 struct api_string_mem_base;
 
+/**
+    An object that a memory manager keeps alongside the memory block,
+    to cache data computed from the content ( see `api_string_func_table::set_aux` ).
+    The manager calls `destroy` when the block is deallocated.
+*/
+struct api_string_aux
+{
+    void (*destroy)(speudo_std::abi::api_string_aux*);
+
+    // Identifies the type of the object. The values below 0x10000 are
+    // reserved to this library.
+    unsigned long kind;
+};
+
 struct api_string_func_table
 {
     typedef std::size_t (*func_size)(speudo_std::abi::api_string_mem_base*);
     typedef void        (*func_void)(speudo_std::abi::api_string_mem_base*);
     typedef bool        (*func_bool)(speudo_std::abi::api_string_mem_base*);
     typedef std::byte*  (*func_ptr) (speudo_std::abi::api_string_mem_base*);
+    typedef void        (*func_void_n)(speudo_std::abi::api_string_mem_base*, std::size_t);
+    typedef speudo_std::abi::api_string_aux* (*func_aux)(speudo_std::abi::api_string_mem_base*);
+    typedef speudo_std::abi::api_string_aux* (*func_set_aux)
+        (speudo_std::abi::api_string_mem_base*, speudo_std::abi::api_string_aux*);
 
     unsigned long abi_version = 0;
     func_size acquire = nullptr;
@@ -36,6 +108,20 @@ struct api_string_func_table
     func_bool unique  = nullptr;
     func_ptr  begin   = nullptr;
     func_ptr  end     = nullptr;
+
+    // only present if abi_version >= 1
+    func_void weak_acquire = nullptr;
+    func_void weak_release = nullptr;
+    func_bool try_acquire  = nullptr;
+
+    // only present if abi_version >= 2
+    func_void_n acquire_n = nullptr;
+    func_void_n release_n = nullptr;
+
+    // only present if abi_version >= 3
+    func_aux     get_aux  = nullptr; // returns the auxiliary object, or null
+    func_set_aux set_aux  = nullptr; // installs it if there is none yet, and returns the installed one
+    func_void    drop_aux = nullptr; // destroys it; only called while the block is unique
 };
 
 struct api_string_mem_base
@@ -47,6 +133,45 @@ struct api_string_mem_base
     bool unique()         { return func_table->unique(this); }
     std::byte* begin()    { return func_table->begin(this); }
     std::byte* end()      { return func_table->end(this); }
+
+    bool supports_weak()  { return func_table->abi_version >= 1; }
+    void weak_acquire()   { func_table->weak_acquire(this); }
+    void weak_release()   { func_table->weak_release(this); }
+    bool try_acquire()    { return func_table->try_acquire(this); }
+
+    void acquire_n(std::size_t n)
+    {
+        if (func_table->abi_version >= 2) {
+            func_table->acquire_n(this, n);
+        } else {
+            for(; n != 0; --n) acquire();
+        }
+    }
+    void release_n(std::size_t n)
+    {
+        if (func_table->abi_version >= 2) {
+            func_table->release_n(this, n);
+        } else {
+            for(; n != 0; --n) release();
+        }
+    }
+
+    bool supports_aux() { return func_table->abi_version >= 3; }
+    api_string_aux* get_aux()
+    {
+        return supports_aux() ? func_table->get_aux(this) : nullptr;
+    }
+    // Returns null if not supported, in which case `aux` is not taken over
+    api_string_aux* set_aux(api_string_aux* aux)
+    {
+        return supports_aux() ? func_table->set_aux(this, aux) : nullptr;
+    }
+    void drop_aux()
+    {
+        if (supports_aux()) {
+            func_table->drop_aux(this);
+        }
+    }
 };
 
 
@@ -166,7 +291,131 @@ int str_compare
     , const char32_t* rhs
     , std::size_t rhs_len);
 
+/**
+    `lanes_hash`, vectorized
+*/
+std::uint64_t str_hash(const char* str, std::size_t len);
+std::uint64_t str_hash(const wchar_t* str, std::size_t len);
+std::uint64_t str_hash(const char16_t* str, std::size_t len);
+std::uint64_t str_hash(const char32_t* str, std::size_t len);
+
+/**
+    The find functions of `basic_api_string` and `basic_string`, with
+    the semantics of the ones of `std::basic_string_view`. They are
+    vectorized, with the instruction set selected at run time, and
+    only defined for `char`, `wchar_t`, `char16_t` and `char32_t`.
+*/
+template <typename CharT>
+std::size_t str_find
+    ( const CharT* str, std::size_t len
+    , const CharT* s, std::size_t pos, std::size_t count ) noexcept;
+
+template <typename CharT>
+std::size_t str_find
+    ( const CharT* str, std::size_t len
+    , CharT ch, std::size_t pos ) noexcept;
+
+template <typename CharT>
+std::size_t str_rfind
+    ( const CharT* str, std::size_t len
+    , const CharT* s, std::size_t pos, std::size_t count ) noexcept;
+
+template <typename CharT>
+std::size_t str_rfind
+    ( const CharT* str, std::size_t len
+    , CharT ch, std::size_t pos ) noexcept;
+
+template <typename CharT>
+std::size_t str_find_first_of
+    ( const CharT* str, std::size_t len
+    , const CharT* s, std::size_t pos, std::size_t count ) noexcept;
+
+template <typename CharT>
+std::size_t str_find_first_not_of
+    ( const CharT* str, std::size_t len
+    , const CharT* s, std::size_t pos, std::size_t count ) noexcept;
+
+template <typename CharT>
+std::size_t str_find_last_of
+    ( const CharT* str, std::size_t len
+    , const CharT* s, std::size_t pos, std::size_t count ) noexcept;
+
+template <typename CharT>
+std::size_t str_find_last_not_of
+    ( const CharT* str, std::size_t len
+    , const CharT* s, std::size_t pos, std::size_t count ) noexcept;
+
 void throw_std_out_of_range(const char*);
+void throw_std_invalid_argument(const char*);
+
+// `std::char_traits<char>` compares characters as `unsigned char`
+constexpr unsigned char char_value(char ch) noexcept
+{
+    return static_cast<unsigned char>(ch);
+}
+
+template <typename CharT>
+constexpr CharT char_value(CharT ch) noexcept
+{
+    return ch;
+}
+
+/**
+    The functions below are usable in constant expressions, and call
+    the out-of-line functions above when evaluated at run time.
+*/
+template <typename CharT>
+constexpr std::size_t constexpr_str_length(const CharT* str) noexcept
+{
+#if defined(SPEUDO_STD_IS_CONSTANT_EVALUATED)
+    if (SPEUDO_STD_IS_CONSTANT_EVALUATED())
+    {
+        std::size_t len = 0;
+        while (str[len] != CharT{})
+        {
+            ++len;
+        }
+        return len;
+    }
+#endif
+    return speudo_std::_detail::str_length(str);
+}
+
+template <typename CharT>
+constexpr int constexpr_str_compare
+    ( const CharT* lhs
+    , std::size_t lhs_len
+    , const CharT* rhs
+    , std::size_t rhs_len ) noexcept
+{
+#if defined(SPEUDO_STD_IS_CONSTANT_EVALUATED)
+    if (SPEUDO_STD_IS_CONSTANT_EVALUATED())
+    {
+        std::size_t min_len = lhs_len < rhs_len ? lhs_len : rhs_len;
+        for (std::size_t i = 0; i < min_len; ++i)
+        {
+            if (lhs[i] != rhs[i])
+            {
+                return char_value(lhs[i]) < char_value(rhs[i]) ? -1 : +1;
+            }
+        }
+        return lhs_len == rhs_len ? 0 : (lhs_len < rhs_len ? -1 : +1);
+    }
+#endif
+    return speudo_std::_detail::str_compare(lhs, lhs_len, rhs, rhs_len);
+}
+
+template <typename CharT>
+constexpr std::uint64_t constexpr_str_hash(const CharT* str, std::size_t len) noexcept
+{
+#if defined(SPEUDO_STD_IS_CONSTANT_EVALUATED)
+    if (SPEUDO_STD_IS_CONSTANT_EVALUATED())
+    {
+        return speudo_std::_detail::lanes_hash(str, len);
+    }
+#endif
+    return speudo_std::_detail::str_hash(str, len);
+}
 
 struct api_string_ref_tag {};
 
@@ -175,6 +424,296 @@ struct api_string_ref_tag {};
 
 template <typename CharT> class basic_api_string;
 
+namespace _detail {
+
+template <typename T> struct type_identity
+{
+    using type = T;
+};
+
+template <typename T> using type_identity_t = typename type_identity<T>::type;
+
+} // namespace _detail
+
+/**
+    A non-owning reference to a string, like `std::basic_string_view`.
+    It is trivially copyable: creating, copying and destroying a view
+    never touches any reference counter.
+
+    When created from a managed `basic_api_string`, the view also keeps
+    a pointer to its memory manager ( without acquiring it ), so that
+    `to_api_string()` can create a `basic_api_string` that shares the same
+    memory, instead of copying the characters. This is only possible while
+    the view covers a suffix of the original string, since a
+    `basic_api_string` must be null terminated. Otherwise, and when the
+    view is created from anything else, `to_api_string()` copies the
+    characters.
+
+    Like `std::basic_string_view`, a view must not outlive the string
+    it references.
+*/
+template <typename CharT> class basic_api_string_view
+{
+public:
+
+    using value_type = CharT;
+    using pointer = const CharT*;
+    using const_pointer = const CharT*;
+    using reference = const CharT&;
+    using const_reference = const CharT&;
+    using const_iterator = const CharT*;
+    using iterator = const CharT*;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+
+    constexpr static size_type npos = static_cast<size_type>(-1);
+
+    constexpr basic_api_string_view() noexcept = default;
+
+    constexpr basic_api_string_view(const CharT* str, size_type len) noexcept
+        : _str(str)
+        , _len(len)
+    {
+    }
+
+    constexpr basic_api_string_view(const CharT* str) noexcept
+        : _str(str)
+        , _len(speudo_std::_detail::constexpr_str_length(str))
+    {
+    }
+
+    constexpr basic_api_string_view(const speudo_std::basic_api_string<CharT>& str) noexcept;
+
+    // capacity
+
+    constexpr bool empty() const noexcept
+    {
+        return _len == 0;
+    }
+    constexpr size_type size() const noexcept
+    {
+        return _len;
+    }
+    constexpr size_type length() const noexcept
+    {
+        return _len;
+    }
+
+    // element access
+
+    constexpr const_pointer data() const noexcept
+    {
+        return _str;
+    }
+    constexpr const_iterator begin() const noexcept
+    {
+        return _str;
+    }
+    constexpr const_iterator cbegin() const noexcept
+    {
+        return _str;
+    }
+    constexpr const_iterator end() const noexcept
+    {
+        return _str + _len;
+    }
+    constexpr const_iterator cend() const noexcept
+    {
+        return _str + _len;
+    }
+    constexpr const_reference operator[](size_type pos) const noexcept
+    {
+        return _str[pos];
+    }
+    constexpr const_reference at(size_type pos) const
+    {
+        if (pos >= _len)
+        {
+            speudo_std::_detail::throw_std_out_of_range("basic_api_string_view::at() out of range");
+        }
+        return _str[pos];
+    }
+    constexpr const_reference front() const noexcept
+    {
+        return _str[0];
+    }
+    constexpr const_reference back() const noexcept
+    {
+        return _str[_len - 1];
+    }
+
+    // modifiers
+
+    constexpr void remove_prefix(size_type n) noexcept
+    {
+        _str += n;
+        _len -= n;
+    }
+    constexpr void remove_suffix(size_type n) noexcept
+    {
+        _len -= n;
+        if (n != 0)
+        {
+            _manager = nullptr;
+        }
+    }
+    constexpr void swap(basic_api_string_view& other) noexcept
+    {
+        basic_api_string_view tmp = other;
+        other = *this;
+        *this = tmp;
+    }
+
+    // operations
+
+    constexpr basic_api_string_view substr(size_type pos = 0, size_type count = npos) const
+    {
+        if (pos > _len)
+        {
+            speudo_std::_detail::throw_std_out_of_range("basic_api_string_view::substr() out of range");
+        }
+        basic_api_string_view v = *this;
+        v.remove_prefix(pos);
+        if (count < v._len)
+        {
+            v.remove_suffix(v._len - count);
+        }
+        return v;
+    }
+
+    constexpr int compare(basic_api_string_view other) const noexcept
+    {
+        return speudo_std::_detail::constexpr_str_compare(_str, _len, other._str, other._len);
+    }
+
+    constexpr bool starts_with(basic_api_string_view x) const noexcept
+    {
+        return x._len <= _len
+            && 0 == speudo_std::_detail::constexpr_str_compare(_str, x._len, x._str, x._len);
+    }
+    constexpr bool starts_with(CharT x) const noexcept
+    {
+        return _len != 0 && _str[0] == x;
+    }
+    constexpr bool starts_with(const CharT* x) const noexcept
+    {
+        return starts_with(basic_api_string_view(x));
+    }
+
+    constexpr bool ends_with(basic_api_string_view x) const noexcept
+    {
+        return x._len <= _len
+            && 0 == speudo_std::_detail::constexpr_str_compare
+                ( _str + (_len - x._len), x._len, x._str, x._len );
+    }
+    constexpr bool ends_with(CharT x) const noexcept
+    {
+        return _len != 0 && _str[_len - 1] == x;
+    }
+    constexpr bool ends_with(const CharT* x) const noexcept
+    {
+        return ends_with(basic_api_string_view(x));
+    }
+
+    // search
+
+    size_type find(basic_api_string_view v, size_type pos = 0) const noexcept
+    {
+        return speudo_std::_detail::str_find(_str, _len, v._str, pos, v._len);
+    }
+    size_type find(const CharT* s, size_type pos, size_type count) const noexcept
+    {
+        return speudo_std::_detail::str_find(_str, _len, s, pos, count);
+    }
+    size_type find(CharT ch, size_type pos = 0) const noexcept
+    {
+        return speudo_std::_detail::str_find(_str, _len, ch, pos);
+    }
+
+    size_type rfind(basic_api_string_view v, size_type pos = npos) const noexcept
+    {
+        return speudo_std::_detail::str_rfind(_str, _len, v._str, pos, v._len);
+    }
+    size_type rfind(const CharT* s, size_type pos, size_type count) const noexcept
+    {
+        return speudo_std::_detail::str_rfind(_str, _len, s, pos, count);
+    }
+    size_type rfind(CharT ch, size_type pos = npos) const noexcept
+    {
+        return speudo_std::_detail::str_rfind(_str, _len, ch, pos);
+    }
+
+    size_type find_first_of(basic_api_string_view v, size_type pos = 0) const noexcept
+    {
+        return speudo_std::_detail::str_find_first_of(_str, _len, v._str, pos, v._len);
+    }
+    size_type find_first_of(const CharT* s, size_type pos, size_type count) const noexcept
+    {
+        return speudo_std::_detail::str_find_first_of(_str, _len, s, pos, count);
+    }
+    size_type find_first_of(CharT ch, size_type pos = 0) const noexcept
+    {
+        return speudo_std::_detail::str_find_first_of(_str, _len, &ch, pos, 1);
+    }
+
+    size_type find_first_not_of(basic_api_string_view v, size_type pos = 0) const noexcept
+    {
+        return speudo_std::_detail::str_find_first_not_of(_str, _len, v._str, pos, v._len);
+    }
+    size_type find_first_not_of(const CharT* s, size_type pos, size_type count) const noexcept
+    {
+        return speudo_std::_detail::str_find_first_not_of(_str, _len, s, pos, count);
+    }
+    size_type find_first_not_of(CharT ch, size_type pos = 0) const noexcept
+    {
+        return speudo_std::_detail::str_find_first_not_of(_str, _len, &ch, pos, 1);
+    }
+
+    size_type find_last_of(basic_api_string_view v, size_type pos = npos) const noexcept
+    {
+        return speudo_std::_detail::str_find_last_of(_str, _len, v._str, pos, v._len);
+    }
+    size_type find_last_of(const CharT* s, size_type pos, size_type count) const noexcept
+    {
+        return speudo_std::_detail::str_find_last_of(_str, _len, s, pos, count);
+    }
+    size_type find_last_of(CharT ch, size_type pos = npos) const noexcept
+    {
+        return speudo_std::_detail::str_find_last_of(_str, _len, &ch, pos, 1);
+    }
+
+    size_type find_last_not_of(basic_api_string_view v, size_type pos = npos) const noexcept
+    {
+        return speudo_std::_detail::str_find_last_not_of(_str, _len, v._str, pos, v._len);
+    }
+    size_type find_last_not_of(const CharT* s, size_type pos, size_type count) const noexcept
+    {
+        return speudo_std::_detail::str_find_last_not_of(_str, _len, s, pos, count);
+    }
+    size_type find_last_not_of(CharT ch, size_type pos = npos) const noexcept
+    {
+        return speudo_std::_detail::str_find_last_not_of(_str, _len, &ch, pos, 1);
+    }
+
+    /**
+        Returns a `basic_api_string` with the same content, that shares the
+        memory of the original string when possible ( see above ), and
+        otherwise copies the characters.
+    */
+    SPEUDO_STD_CONSTEXPR_API_STRING speudo_std::basic_api_string<CharT> to_api_string() const;
+
+private:
+
+    const CharT* _str = nullptr;
+    size_type _len = 0;
+    speudo_std::abi::api_string_mem_base* _manager = nullptr;
+};
+
+using api_string_view    = basic_api_string_view<char>;
+using api_u16string_view = basic_api_string_view<char16_t>;
+using api_u32string_view = basic_api_string_view<char32_t>;
+using api_wstring_view   = basic_api_string_view<wchar_t>;
+
 namespace _detail{
 template <typename CharT>
 inline basic_api_string<CharT> api_string_ref(const CharT* str, std::size_t len);
@@ -194,18 +733,20 @@ public:
     using size_type = std::size_t;
     using difference_type = std::ptrdiff_t;
 
+    constexpr static size_type npos = static_cast<size_type>(-1);
+
     constexpr basic_api_string() noexcept
     {
         speudo_std::abi::reset(_data);
     }
 
-    basic_api_string(const basic_api_string& other) noexcept
+    constexpr basic_api_string(const basic_api_string& other) noexcept
         : _data(other._data)
     {
         _acquire();
     }
 
-    basic_api_string(basic_api_string&& other) noexcept
+    constexpr basic_api_string(basic_api_string&& other) noexcept
         : _data(other._data)
     {
         if (_is_managed())
@@ -224,7 +765,7 @@ public:
     {
     }
 
-    ~basic_api_string()
+    SPEUDO_STD_CONSTEXPR_API_STRING ~basic_api_string()
     {
         _release();
     }
@@ -233,7 +774,7 @@ public:
 
     basic_api_string& operator=(const basic_api_string& other) noexcept
     {
-        if(_data.big.str != other._data.big.str)
+        if(this != &other)
         {
             basic_api_string tmp{other};
             swap(tmp);
@@ -243,7 +784,7 @@ public:
 
     basic_api_string& operator=(basic_api_string&& other) noexcept
     {
-        if(_data.big.str != other._data.big.str)
+        if(this != &other)
         {
             basic_api_string tmp{static_cast<basic_api_string&&>(other)};
             swap(tmp);
@@ -290,27 +831,27 @@ public:
 
     // element access
 
-    const_pointer data() const noexcept
+    constexpr const_pointer data() const noexcept
     {
         return _big() ? _data.big.str : _data.small.str;
     }
-    const_pointer c_str() const noexcept
+    constexpr const_pointer c_str() const noexcept
     {
         return data();
     }
-    const_iterator cbegin() const noexcept
+    constexpr const_iterator cbegin() const noexcept
     {
         return const_iterator{data()};
     }
-    const_iterator begin() const noexcept
+    constexpr const_iterator begin() const noexcept
     {
         return const_iterator{data()};
     }
-    const_iterator cend() const noexcept
+    constexpr const_iterator cend() const noexcept
     {
         return const_iterator{_data_end()};
     }
-    const_iterator end() const noexcept
+    constexpr const_iterator end() const noexcept
     {
         return const_iterator{_data_end()};
     }
@@ -338,9 +879,9 @@ public:
 
     // Comparison
 
-    int compare(const basic_api_string& s) const
+    constexpr int compare(const basic_api_string& s) const noexcept
     {
-        return speudo_std::_detail::str_compare
+        return speudo_std::_detail::constexpr_str_compare
             ( data()
             , size()
             , s.data()
@@ -357,7 +898,7 @@ public:
         {
             count1 = max_count;
         }
-        return speudo_std::_detail::str_compare
+        return speudo_std::_detail::constexpr_str_compare
             ( &at(pos1)
             , count1
             , s.data()
@@ -378,13 +919,13 @@ public:
     //         , std::min(count2, s.size() - pos2) );
     // }
 
-    constexpr int compare(const CharT* s) const
+    constexpr int compare(const CharT* s) const noexcept
     {
-        return speudo_std::_detail::str_compare
+        return speudo_std::_detail::constexpr_str_compare
             ( data()
             , size()
             , s
-            , speudo_std::_detail::str_length(s) );
+            , speudo_std::_detail::constexpr_str_length(s) );
     }
 
     // constexpr int compare
@@ -414,30 +955,129 @@ public:
 
     // todo
 
-    bool starts_with(const basic_api_string& x) const noexcept
+    constexpr bool starts_with(speudo_std::basic_api_string_view<CharT> x) const noexcept
     {
-        size_type xlen = x.size();
-        return x <= size() && 0 == str_compare(data(), xlen, x.data(), xlen);
+        return speudo_std::basic_api_string_view<CharT>(data(), size()).starts_with(x);
     }
-    bool starts_with(CharT x) const noexcept
+    constexpr bool starts_with(CharT x) const noexcept
     {
         return _data.big.len != 0 && *data() == x;
     }
-    // bool starts_with(const CharT* x) const
-    // {
-    //     size_type xlen = str_length(x);
-    //     return x <= size() && 0 == str_compare(data(), xlen, x, xlen);
-    // }
-    //   bool ends_with(const basic_api_string_view& x) const noexcept;
-    //   bool ends_with(CharT x) const noexcept;
-    //   bool ends_with(const CharT* x) const;
+    constexpr bool starts_with(const CharT* x) const noexcept
+    {
+        return starts_with(speudo_std::basic_api_string_view<CharT>(x));
+    }
+    constexpr bool ends_with(speudo_std::basic_api_string_view<CharT> x) const noexcept
+    {
+        return speudo_std::basic_api_string_view<CharT>(data(), size()).ends_with(x);
+    }
+    constexpr bool ends_with(CharT x) const noexcept
+    {
+        return _data.big.len != 0 && *(_data_end() - 1) == x;
+    }
+    constexpr bool ends_with(const CharT* x) const noexcept
+    {
+        return ends_with(speudo_std::basic_api_string_view<CharT>(x));
+    }
+
+    // search
+
+    size_type find
+        ( speudo_std::basic_api_string_view<CharT> str
+        , size_type pos = 0 ) const noexcept
+    {
+        return speudo_std::_detail::str_find(data(), size(), str.data(), pos, str.size());
+    }
+    size_type find(const CharT* s, size_type pos, size_type count) const noexcept
+    {
+        return speudo_std::_detail::str_find(data(), size(), s, pos, count);
+    }
+    size_type find(CharT ch, size_type pos = 0) const noexcept
+    {
+        return speudo_std::_detail::str_find(data(), size(), ch, pos);
+    }
+
+    size_type rfind
+        ( speudo_std::basic_api_string_view<CharT> str
+        , size_type pos = npos ) const noexcept
+    {
+        return speudo_std::_detail::str_rfind(data(), size(), str.data(), pos, str.size());
+    }
+    size_type rfind(const CharT* s, size_type pos, size_type count) const noexcept
+    {
+        return speudo_std::_detail::str_rfind(data(), size(), s, pos, count);
+    }
+    size_type rfind(CharT ch, size_type pos = npos) const noexcept
+    {
+        return speudo_std::_detail::str_rfind(data(), size(), ch, pos);
+    }
+
+    size_type find_first_of
+        ( speudo_std::basic_api_string_view<CharT> str
+        , size_type pos = 0 ) const noexcept
+    {
+        return speudo_std::_detail::str_find_first_of(data(), size(), str.data(), pos, str.size());
+    }
+    size_type find_first_of(const CharT* s, size_type pos, size_type count) const noexcept
+    {
+        return speudo_std::_detail::str_find_first_of(data(), size(), s, pos, count);
+    }
+    size_type find_first_of(CharT ch, size_type pos = 0) const noexcept
+    {
+        return speudo_std::_detail::str_find_first_of(data(), size(), &ch, pos, 1);
+    }
+
+    size_type find_first_not_of
+        ( speudo_std::basic_api_string_view<CharT> str
+        , size_type pos = 0 ) const noexcept
+    {
+        return speudo_std::_detail::str_find_first_not_of(data(), size(), str.data(), pos, str.size());
+    }
+    size_type find_first_not_of(const CharT* s, size_type pos, size_type count) const noexcept
+    {
+        return speudo_std::_detail::str_find_first_not_of(data(), size(), s, pos, count);
+    }
+    size_type find_first_not_of(CharT ch, size_type pos = 0) const noexcept
+    {
+        return speudo_std::_detail::str_find_first_not_of(data(), size(), &ch, pos, 1);
+    }
+
+    size_type find_last_of
+        ( speudo_std::basic_api_string_view<CharT> str
+        , size_type pos = npos ) const noexcept
+    {
+        return speudo_std::_detail::str_find_last_of(data(), size(), str.data(), pos, str.size());
+    }
+    size_type find_last_of(const CharT* s, size_type pos, size_type count) const noexcept
+    {
+        return speudo_std::_detail::str_find_last_of(data(), size(), s, pos, count);
+    }
+    size_type find_last_of(CharT ch, size_type pos = npos) const noexcept
+    {
+        return speudo_std::_detail::str_find_last_of(data(), size(), &ch, pos, 1);
+    }
+
+    size_type find_last_not_of
+        ( speudo_std::basic_api_string_view<CharT> str
+        , size_type pos = npos ) const noexcept
+    {
+        return speudo_std::_detail::str_find_last_not_of(data(), size(), str.data(), pos, str.size());
+    }
+    size_type find_last_not_of(const CharT* s, size_type pos, size_type count) const noexcept
+    {
+        return speudo_std::_detail::str_find_last_not_of(data(), size(), s, pos, count);
+    }
+    size_type find_last_not_of(CharT ch, size_type pos = npos) const noexcept
+    {
+        return speudo_std::_detail::str_find_last_not_of(data(), size(), &ch, pos, 1);
+    }
 
 private:
 
-    basic_api_string
+    constexpr basic_api_string
         ( speudo_std::_detail::api_string_ref_tag
         , const CharT* str
-        , std::size_t len )
+        , std::size_t len ) noexcept
     {
         _data.big.len = len;
         _data.big.mem_manager = nullptr;
@@ -445,21 +1085,24 @@ private:
     }
 
     template <typename C>
-    friend basic_api_string<C> api_string_ref(const C* str, std::size_t);
+    friend SPEUDO_STD_CONSTEXPR_API_STRING
+    basic_api_string<C> api_string_ref(const C* str, std::size_t) noexcept;
 
-    const_pointer _data_end() const
+    friend class speudo_std::basic_api_string_view<CharT>;
+
+    constexpr const_pointer _data_end() const
     {
         return _big()
             ? (_data.big.str + _data.big.len)
             : (_data.small.str + _data.small.len);
     }
 
-    bool _is_managed()
+    constexpr bool _is_managed() const noexcept
     {
         return _big() && _data.big.mem_manager != nullptr;
     }
 
-    void _acquire()
+    constexpr void _acquire()
     {
         if(_is_managed())
         {
@@ -467,7 +1110,7 @@ private:
         }
     }
 
-    void _release()
+    constexpr void _release()
     {
         if(_is_managed())
         {
@@ -497,32 +1140,86 @@ using api_u32string = basic_api_string<char32_t>;
 using api_wstring   = basic_api_string<wchar_t>;
 
 template <typename CharT>
-inline basic_api_string<CharT> api_string_ref(const CharT* str, std::size_t len)
+constexpr basic_api_string_view<CharT>::basic_api_string_view
+    ( const speudo_std::basic_api_string<CharT>& str ) noexcept
+    : _str(str.data())
+    , _len(str.size())
+    , _manager(str._big() ? str._data.big.mem_manager : nullptr)
+{
+}
+
+template <typename CharT>
+SPEUDO_STD_CONSTEXPR_API_STRING
+speudo_std::basic_api_string<CharT> basic_api_string_view<CharT>::to_api_string() const
+{
+    if (_manager == nullptr)
+    {
+        return {_str, _len};
+    }
+    _manager->acquire();
+    speudo_std::basic_api_string<CharT> s{speudo_std::_detail::api_string_ref_tag{}, _str, _len};
+    s._data.big.mem_manager = _manager;
+    return s;
+}
+
+/**
+    Creates a `basic_api_string` that references `str` without managing
+    its lifetime. Since C++20, it is usable in constant expressions, so
+    that a string with static storage duration can be constant-initialized:
+
+        SPEUDO_STD_CONSTINIT speudo_std::api_string greeting = "hello"_as;
+*/
+template <typename CharT>
+SPEUDO_STD_CONSTEXPR_API_STRING
+basic_api_string<CharT> api_string_ref(const CharT* str, std::size_t len) noexcept
 {
     return {speudo_std::_detail::api_string_ref_tag{}, str, len};
 }
 
 template <typename CharT>
-inline speudo_std::basic_api_string<CharT> api_string_ref(const CharT* str)
+SPEUDO_STD_CONSTEXPR_API_STRING
+speudo_std::basic_api_string<CharT> api_string_ref(const CharT* str) noexcept
 {
-    return speudo_std::api_string_ref(str, _detail::str_length(str));
+    return speudo_std::api_string_ref(str, speudo_std::_detail::constexpr_str_length(str));
 }
 
+/**
+    Hash function object, usable in constant expressions. The code units
+    are accumulated by blocks of 32 bytes into four independent lanes,
+    which are then mixed together ( see `_detail::lanes_hash` ). The run
+    time implementation is vectorized, and returns the same result as the
+    compile time one.
+
+    The result is not meant to be persisted nor exchanged between
+    processes: it may change between versions of this library. The
+    string tables of `api_string_table.hpp` and `api_string_switch.hpp`
+    use the 64 bits FNV-1a instead.
+*/
+struct api_string_hash
+{
+    template <typename CharT>
+    constexpr std::size_t operator()(const speudo_std::basic_api_string<CharT>& s) const noexcept
+    {
+        return static_cast<std::size_t>
+            ( speudo_std::_detail::constexpr_str_hash(s.data(), s.size()) );
+    }
+};
+
 namespace string_literals {
 
-inline api_string operator ""_as(const char* str, std::size_t len)
+inline SPEUDO_STD_CONSTEXPR_API_STRING api_string operator ""_as(const char* str, std::size_t len) noexcept
 {
     return speudo_std::api_string_ref(str, len);
 }
-inline api_u16string operator ""_as(const char16_t* str, std::size_t len)
+inline SPEUDO_STD_CONSTEXPR_API_STRING api_u16string operator ""_as(const char16_t* str, std::size_t len) noexcept
 {
     return speudo_std::api_string_ref(str, len);
 }
-inline api_u32string operator ""_as(const char32_t* str, std::size_t len)
+inline SPEUDO_STD_CONSTEXPR_API_STRING api_u32string operator ""_as(const char32_t* str, std::size_t len) noexcept
 {
     return speudo_std::api_string_ref(str, len);
 }
-inline api_wstring operator ""_as(const wchar_t* str, std::size_t len)
+inline SPEUDO_STD_CONSTEXPR_API_STRING api_wstring operator ""_as(const wchar_t* str, std::size_t len) noexcept
 {
     return speudo_std::api_string_ref(str, len);
 }
@@ -530,115 +1227,228 @@ inline api_wstring operator ""_as(const wchar_t* str, std::size_t len)
 } // namespace string_literals
 
 template<class CharT>
-bool operator == (const speudo_std::basic_api_string<CharT>& lhs, const speudo_std::basic_api_string<CharT>& rhs)
+constexpr bool operator == (const speudo_std::basic_api_string<CharT>& lhs, const speudo_std::basic_api_string<CharT>& rhs)
 {
     return lhs.size() == rhs.size() && lhs.compare(rhs) == 0;
 }
 
 template<class CharT>
-bool operator != (const speudo_std::basic_api_string<CharT>& lhs, const speudo_std::basic_api_string<CharT>& rhs)
+constexpr bool operator != (const speudo_std::basic_api_string<CharT>& lhs, const speudo_std::basic_api_string<CharT>& rhs)
 {
     return lhs.size() != rhs.size() || lhs.compare(rhs) != 0;
 }
 
 template<class CharT>
-bool operator < (const speudo_std::basic_api_string<CharT>& lhs, const speudo_std::basic_api_string<CharT>& rhs)
+constexpr bool operator < (const speudo_std::basic_api_string<CharT>& lhs, const speudo_std::basic_api_string<CharT>& rhs)
 {
     return lhs.compare(rhs) < 0;
 }
 
 template<class CharT>
-bool operator <= (const speudo_std::basic_api_string<CharT>& lhs, const speudo_std::basic_api_string<CharT>& rhs)
+constexpr bool operator <= (const speudo_std::basic_api_string<CharT>& lhs, const speudo_std::basic_api_string<CharT>& rhs)
 {
     return lhs.compare(rhs) <= 0;
 }
 
 template<class CharT>
-bool operator > (const speudo_std::basic_api_string<CharT>& lhs, const speudo_std::basic_api_string<CharT>& rhs)
+constexpr bool operator > (const speudo_std::basic_api_string<CharT>& lhs, const speudo_std::basic_api_string<CharT>& rhs)
 {
     return lhs.compare(rhs) > 0;
 }
 
 template<class CharT>
-bool operator >= (const speudo_std::basic_api_string<CharT>& lhs, const speudo_std::basic_api_string<CharT>& rhs)
+constexpr bool operator >= (const speudo_std::basic_api_string<CharT>& lhs, const speudo_std::basic_api_string<CharT>& rhs)
 {
     return lhs.compare(rhs) >= 0;
 }
 
 template<class CharT>
-bool operator == (const CharT* lhs, const speudo_std::basic_api_string<CharT>& rhs)
+constexpr bool operator == (const CharT* lhs, const speudo_std::basic_api_string<CharT>& rhs)
 {
     return speudo_std::api_string_ref(lhs) == rhs;
 }
 
 template<class CharT>
-bool operator == (const speudo_std::basic_api_string<CharT>& lhs, const CharT* rhs)
+constexpr bool operator == (const speudo_std::basic_api_string<CharT>& lhs, const CharT* rhs)
 {
     return lhs == speudo_std::api_string_ref(rhs);
 }
 
 template<class CharT>
-bool operator != (const CharT* lhs, const speudo_std::basic_api_string<CharT>& rhs)
+constexpr bool operator != (const CharT* lhs, const speudo_std::basic_api_string<CharT>& rhs)
 {
     return speudo_std::api_string_ref(lhs) != rhs;
 }
 
 template<class CharT>
-bool operator != (const speudo_std::basic_api_string<CharT>& lhs, const CharT* rhs)
+constexpr bool operator != (const speudo_std::basic_api_string<CharT>& lhs, const CharT* rhs)
 {
     return lhs != speudo_std::api_string_ref(rhs);
 }
 
 template<class CharT>
-bool operator < (const CharT* lhs, const speudo_std::basic_api_string<CharT>& rhs)
+constexpr bool operator < (const CharT* lhs, const speudo_std::basic_api_string<CharT>& rhs)
 {
     return speudo_std::api_string_ref(lhs) < rhs;
 }
 
 template<class CharT>
-bool operator < (const speudo_std::basic_api_string<CharT>& lhs,  const CharT* rhs)
+constexpr bool operator < (const speudo_std::basic_api_string<CharT>& lhs,  const CharT* rhs)
 {
     return lhs < speudo_std::api_string_ref(rhs);
 }
 
 template<class CharT>
-bool operator <= (const CharT* lhs, const speudo_std::basic_api_string<CharT>& rhs)
+constexpr bool operator <= (const CharT* lhs, const speudo_std::basic_api_string<CharT>& rhs)
 {
     return speudo_std::api_string_ref(lhs) <= rhs;
 }
 
 template<class CharT>
-bool operator <= (const speudo_std::basic_api_string<CharT>& lhs, const CharT* rhs)
+constexpr bool operator <= (const speudo_std::basic_api_string<CharT>& lhs, const CharT* rhs)
 {
     return lhs <= speudo_std::api_string_ref(rhs);
 }
 
 template<class CharT>
-bool operator > (const CharT* lhs, const speudo_std::basic_api_string<CharT>& rhs)
+constexpr bool operator > (const CharT* lhs, const speudo_std::basic_api_string<CharT>& rhs)
 {
     return speudo_std::api_string_ref(lhs) > rhs;
 }
 
 template<class CharT>
-bool operator > (const speudo_std::basic_api_string<CharT>& lhs, const CharT* rhs)
+constexpr bool operator > (const speudo_std::basic_api_string<CharT>& lhs, const CharT* rhs)
 {
     return lhs > speudo_std::api_string_ref(rhs);
 }
 
 template<class CharT>
-bool operator >= (const CharT* lhs, const speudo_std::basic_api_string<CharT>& rhs)
+constexpr bool operator >= (const CharT* lhs, const speudo_std::basic_api_string<CharT>& rhs)
 {
     return speudo_std::api_string_ref(lhs) >= rhs;
 }
 
 template<class CharT>
-bool operator >= (const speudo_std::basic_api_string<CharT>& lhs, const CharT* rhs)
+constexpr bool operator >= (const speudo_std::basic_api_string<CharT>& lhs, const CharT* rhs)
 {
     return lhs >= speudo_std::api_string_ref(rhs);
 }
 
 
 
+// The overloads with `type_identity_t` allow comparing a view with anything
+// that is implicitly convertible to it ( like `basic_api_string`, `basic_string`
+// and null terminated strings ), as `std::basic_string_view` does.
+
+template<class CharT>
+constexpr bool operator == (speudo_std::basic_api_string_view<CharT> lhs, speudo_std::basic_api_string_view<CharT> rhs) noexcept
+{
+    return lhs.size() == rhs.size() && lhs.compare(rhs) == 0;
+}
+
+template<class CharT>
+constexpr bool operator == (speudo_std::basic_api_string_view<CharT> lhs, speudo_std::_detail::type_identity_t<speudo_std::basic_api_string_view<CharT>> rhs) noexcept
+{
+    return lhs.size() == rhs.size() && lhs.compare(rhs) == 0;
+}
+
+template<class CharT>
+constexpr bool operator == (speudo_std::_detail::type_identity_t<speudo_std::basic_api_string_view<CharT>> lhs, speudo_std::basic_api_string_view<CharT> rhs) noexcept
+{
+    return lhs.size() == rhs.size() && lhs.compare(rhs) == 0;
+}
+
+template<class CharT>
+constexpr bool operator != (speudo_std::basic_api_string_view<CharT> lhs, speudo_std::basic_api_string_view<CharT> rhs) noexcept
+{
+    return lhs.size() != rhs.size() || lhs.compare(rhs) != 0;
+}
+
+template<class CharT>
+constexpr bool operator != (speudo_std::basic_api_string_view<CharT> lhs, speudo_std::_detail::type_identity_t<speudo_std::basic_api_string_view<CharT>> rhs) noexcept
+{
+    return lhs.size() != rhs.size() || lhs.compare(rhs) != 0;
+}
+
+template<class CharT>
+constexpr bool operator != (speudo_std::_detail::type_identity_t<speudo_std::basic_api_string_view<CharT>> lhs, speudo_std::basic_api_string_view<CharT> rhs) noexcept
+{
+    return lhs.size() != rhs.size() || lhs.compare(rhs) != 0;
+}
+
+template<class CharT>
+constexpr bool operator < (speudo_std::basic_api_string_view<CharT> lhs, speudo_std::basic_api_string_view<CharT> rhs) noexcept
+{
+    return lhs.compare(rhs) < 0;
+}
+
+template<class CharT>
+constexpr bool operator < (speudo_std::basic_api_string_view<CharT> lhs, speudo_std::_detail::type_identity_t<speudo_std::basic_api_string_view<CharT>> rhs) noexcept
+{
+    return lhs.compare(rhs) < 0;
+}
+
+template<class CharT>
+constexpr bool operator < (speudo_std::_detail::type_identity_t<speudo_std::basic_api_string_view<CharT>> lhs, speudo_std::basic_api_string_view<CharT> rhs) noexcept
+{
+    return lhs.compare(rhs) < 0;
+}
+
+template<class CharT>
+constexpr bool operator <= (speudo_std::basic_api_string_view<CharT> lhs, speudo_std::basic_api_string_view<CharT> rhs) noexcept
+{
+    return lhs.compare(rhs) <= 0;
+}
+
+template<class CharT>
+constexpr bool operator <= (speudo_std::basic_api_string_view<CharT> lhs, speudo_std::_detail::type_identity_t<speudo_std::basic_api_string_view<CharT>> rhs) noexcept
+{
+    return lhs.compare(rhs) <= 0;
+}
+
+template<class CharT>
+constexpr bool operator <= (speudo_std::_detail::type_identity_t<speudo_std::basic_api_string_view<CharT>> lhs, speudo_std::basic_api_string_view<CharT> rhs) noexcept
+{
+    return lhs.compare(rhs) <= 0;
+}
+
+template<class CharT>
+constexpr bool operator > (speudo_std::basic_api_string_view<CharT> lhs, speudo_std::basic_api_string_view<CharT> rhs) noexcept
+{
+    return lhs.compare(rhs) > 0;
+}
+
+template<class CharT>
+constexpr bool operator > (speudo_std::basic_api_string_view<CharT> lhs, speudo_std::_detail::type_identity_t<speudo_std::basic_api_string_view<CharT>> rhs) noexcept
+{
+    return lhs.compare(rhs) > 0;
+}
+
+template<class CharT>
+constexpr bool operator > (speudo_std::_detail::type_identity_t<speudo_std::basic_api_string_view<CharT>> lhs, speudo_std::basic_api_string_view<CharT> rhs) noexcept
+{
+    return lhs.compare(rhs) > 0;
+}
+
+template<class CharT>
+constexpr bool operator >= (speudo_std::basic_api_string_view<CharT> lhs, speudo_std::basic_api_string_view<CharT> rhs) noexcept
+{
+    return lhs.compare(rhs) >= 0;
+}
+
+template<class CharT>
+constexpr bool operator >= (speudo_std::basic_api_string_view<CharT> lhs, speudo_std::_detail::type_identity_t<speudo_std::basic_api_string_view<CharT>> rhs) noexcept
+{
+    return lhs.compare(rhs) >= 0;
+}
+
+template<class CharT>
+constexpr bool operator >= (speudo_std::_detail::type_identity_t<speudo_std::basic_api_string_view<CharT>> lhs, speudo_std::basic_api_string_view<CharT> rhs) noexcept
+{
+    return lhs.compare(rhs) >= 0;
+}
+
+
 }// namespace speudo_std
 
 #endif  // API_STRING_HPP
@@ -0,0 +1,323 @@
+#ifndef SPEUDO_STD_API_STRING_ATOMIC_HPP
+#define SPEUDO_STD_API_STRING_ATOMIC_HPP
+
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <api_string.hpp>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+namespace speudo_std {
+
+namespace _detail {
+
+/**
+    The string held by an `atomic_basic_api_string`. Once the node is
+    replaced, `count` receives the local count of the word ( see below ),
+    and is decremented by each reader that has incremented it. It may
+    become negative before the transfer, and the node is deleted by the
+    thread that brings it to zero.
+*/
+template <typename CharT>
+struct atomic_api_string_node
+{
+    std::atomic<std::int64_t> count;
+    speudo_std::basic_api_string<CharT> value;
+};
+
+static_assert(sizeof(void*) <= sizeof(std::uint64_t));
+
+constexpr unsigned atomic_api_string_count_shift = sizeof(void*) == 8 ? 48 : 32;
+constexpr std::uint64_t atomic_api_string_one
+    = std::uint64_t(1) << atomic_api_string_count_shift;
+constexpr std::uint64_t atomic_api_string_ptr_mask = atomic_api_string_one - 1;
+
+} // namespace _detail
+
+/**
+    A `basic_api_string` that can be loaded and replaced concurrently
+    without locks.
+
+    It uses split reference counting: the atomic object holds a 64 bits
+    word that packs a pointer to a heap allocated node, that contains the
+    string, together with a count of the threads that are currently reading
+    the node. A reader increments this local count and the pointer in a
+    single atomic operation, copies the string, and then decrements the
+    local count, unless the node was replaced meanwhile. In that case, the
+    writer has transferred the local count to the node's own counter, and
+    the reader decrements that one instead. So a node is never deleted
+    while a thread is copying its string.
+
+    `load` costs two atomic operations on the word, plus the acquisition
+    of the string. `store` allocates one node.
+
+    The local count uses the 16 most significant bits of the word ( on 64
+    bits platforms ), which limits the number of concurrent `load` calls
+    to 65535. Pointers must fit in the 48 remaining bits, which is the case
+    on the usual 64 bits platforms.
+*/
+template <typename CharT>
+class atomic_basic_api_string
+{
+    using _node = speudo_std::_detail::atomic_api_string_node<CharT>;
+
+public:
+
+    using value_type = speudo_std::basic_api_string<CharT>;
+
+    static constexpr bool is_always_lock_free
+        = std::atomic<std::uint64_t>::is_always_lock_free;
+
+    atomic_basic_api_string() noexcept
+        : _word(0)
+    {
+    }
+
+    explicit atomic_basic_api_string(value_type s)
+        : _word(_pack(_make_node(std::move(s))))
+    {
+    }
+
+    atomic_basic_api_string(const atomic_basic_api_string&) = delete;
+    atomic_basic_api_string& operator=(const atomic_basic_api_string&) = delete;
+
+    ~atomic_basic_api_string()
+    {
+        delete _pointer(_word.load(std::memory_order_acquire));
+    }
+
+    bool is_lock_free() const noexcept
+    {
+        return _word.is_lock_free();
+    }
+
+    value_type load() const;
+
+    void store(value_type s)
+    {
+        exchange(std::move(s));
+    }
+
+    value_type exchange(value_type s);
+
+    /**
+        If the current value is equal to `expected`, replaces it by
+        `desired` and returns `true`. Otherwise, assigns the current value
+        to `expected` and returns `false`.
+    */
+    bool compare_exchange_strong(value_type& expected, value_type desired);
+
+    bool compare_exchange_weak(value_type& expected, value_type desired)
+    {
+        return compare_exchange_strong(expected, std::move(desired));
+    }
+
+    operator value_type() const
+    {
+        return load();
+    }
+
+    atomic_basic_api_string& operator=(value_type s)
+    {
+        store(std::move(s));
+        return *this;
+    }
+
+private:
+
+    mutable std::atomic<std::uint64_t> _word;
+
+    static _node* _make_node(value_type&& s)
+    {
+        return new _node{{0}, std::move(s)};
+    }
+
+    static std::uint64_t _pack(_node* n) noexcept
+    {
+        return static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(n));
+    }
+
+    static _node* _pointer(std::uint64_t word) noexcept
+    {
+        return reinterpret_cast<_node*>
+            ( static_cast<std::uintptr_t>(word & speudo_std::_detail::atomic_api_string_ptr_mask) );
+    }
+
+    static std::int64_t _local_count(std::uint64_t word) noexcept
+    {
+        return static_cast<std::int64_t>(word >> speudo_std::_detail::atomic_api_string_count_shift);
+    }
+
+    static void _release_node(_node* n, std::int64_t count) noexcept
+    {
+        if (n->count.fetch_sub(count, std::memory_order_acq_rel) == count)
+        {
+            delete n;
+        }
+    }
+
+    // Increments the local count, and returns the word before that
+    std::uint64_t _acquire_local() const noexcept
+    {
+        return _word.fetch_add(speudo_std::_detail::atomic_api_string_one, std::memory_order_acquire);
+    }
+
+    // Undoes `_acquire_local`
+    void _release_local(_node* n) const noexcept;
+
+    // Installs `n` in place of the node of word `old`, and transfers the
+    // local count to it. Returns `false` if the word has changed.
+    bool _replace(std::uint64_t& old, _node* n) noexcept;
+};
+
+template <typename CharT>
+void atomic_basic_api_string<CharT>::_release_local(_node* n) const noexcept
+{
+    std::uint64_t cur = _word.load(std::memory_order_relaxed);
+    while (_pointer(cur) == n)
+    {
+        if (_word.compare_exchange_weak
+               ( cur
+               , cur - speudo_std::_detail::atomic_api_string_one
+               , std::memory_order_release
+               , std::memory_order_relaxed ))
+        {
+            return;
+        }
+    }
+    // the node was replaced, and our reference was transferred to its counter
+    if (n != nullptr)
+    {
+        _release_node(n, 1);
+    }
+}
+
+template <typename CharT>
+bool atomic_basic_api_string<CharT>::_replace(std::uint64_t& old, _node* n) noexcept
+{
+    _node* prev = _pointer(old);
+    if ( ! _word.compare_exchange_strong(old, _pack(n), std::memory_order_acq_rel))
+    {
+        return false;
+    }
+    if (prev != nullptr)
+    {
+        // the readers that incremented the local count will decrement
+        // the node counter instead
+        std::int64_t transferred = _local_count(old);
+        if (prev->count.fetch_add(transferred, std::memory_order_acq_rel) == -transferred)
+        {
+            delete prev;
+        }
+    }
+    return true;
+}
+
+template <typename CharT>
+typename atomic_basic_api_string<CharT>::value_type
+atomic_basic_api_string<CharT>::load() const
+{
+    _node* n = _pointer(_acquire_local());
+    value_type s;
+    if (n != nullptr)
+    {
+        s = n->value;
+    }
+    _release_local(n);
+    return s;
+}
+
+template <typename CharT>
+typename atomic_basic_api_string<CharT>::value_type
+atomic_basic_api_string<CharT>::exchange(value_type s)
+{
+    _node* n = _make_node(std::move(s));
+    while (true)
+    {
+        std::uint64_t old = _acquire_local() + speudo_std::_detail::atomic_api_string_one;
+        _node* cur = _pointer(old);
+        while (_pointer(old) == cur)
+        {
+            if (_replace(old, n))
+            {
+                value_type result;
+                if (cur != nullptr)
+                {
+                    result = cur->value;
+                    // our own local reference, now transferred to the node counter
+                    _release_node(cur, 1);
+                }
+                return result;
+            }
+        }
+        // the node was replaced meanwhile, with our reference
+        if (cur != nullptr)
+        {
+            _release_node(cur, 1);
+        }
+    }
+}
+
+template <typename CharT>
+bool atomic_basic_api_string<CharT>::compare_exchange_strong
+    ( value_type& expected
+    , value_type desired )
+{
+    _node* n = nullptr;
+    while (true)
+    {
+        std::uint64_t old = _acquire_local() + speudo_std::_detail::atomic_api_string_one;
+        _node* cur = _pointer(old);
+        bool equal = cur == nullptr ? expected.empty() : cur->value == expected;
+        if ( ! equal)
+        {
+            expected = cur == nullptr ? value_type{} : cur->value;
+            _release_local(cur);
+            if (n != nullptr)
+            {
+                delete n;
+            }
+            return false;
+        }
+        if (n == nullptr)
+        {
+            try
+            {
+                n = _make_node(std::move(desired));
+            }
+            catch (...)
+            {
+                _release_local(cur);
+                throw;
+            }
+        }
+        while (_pointer(old) == cur)
+        {
+            if (_replace(old, n))
+            {
+                if (cur != nullptr)
+                {
+                    _release_node(cur, 1);
+                }
+                return true;
+            }
+        }
+        // the node was replaced meanwhile: check the new value
+        if (cur != nullptr)
+        {
+            _release_node(cur, 1);
+        }
+    }
+}
+
+using atomic_api_string    = atomic_basic_api_string<char>;
+using atomic_api_u16string = atomic_basic_api_string<char16_t>;
+using atomic_api_u32string = atomic_basic_api_string<char32_t>;
+using atomic_api_wstring   = atomic_basic_api_string<wchar_t>;
+
+} // namespace speudo_std
+
+#endif
@@ -0,0 +1,291 @@
+#ifndef SPEUDO_STD_API_STRING_BATCH_BUILDER_HPP
+#define SPEUDO_STD_API_STRING_BATCH_BUILDER_HPP
+
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <detail/api_string_memory.hpp>
+#include <iterator>
+#include <utility>
+#include <string_view> // char_traits
+#include <vector>
+
+namespace speudo_std {
+
+/**
+    Collects several strings into one single memory block, and then
+    creates the `basic_api_string` objects that share it.
+
+    Each string is stored null-terminated inside the block, except the
+    ones that fit in the small string optimization, which are kept
+    aside and copied into their `basic_api_string` objects when `build`
+    is called. The other strings reference the block and share its
+    reference counter. Hence building a batch costs at most one
+    allocation ( when the reserved capacity is enough ), and none when
+    all the strings are small.
+
+    After `build`, the builder is empty and can be reused for the next
+    batch. The capacity of the previous block is used as the initial
+    capacity of the next one.
+*/
+template
+    < typename CharT
+    , typename Traits = std::char_traits<CharT>
+    , typename Allocator = std::allocator<CharT> >
+class basic_api_string_batch_builder
+{
+    using _memory_creator = speudo_std::_detail::api_string_mem<Allocator>;
+
+public:
+
+    using value_type     = CharT;
+    using traits_type    = Traits;
+    using allocator_type = Allocator;
+    using size_type      = std::size_t;
+
+    explicit basic_api_string_batch_builder(const Allocator& a = Allocator())
+        : _allocator(a)
+    {
+    }
+
+    basic_api_string_batch_builder
+        ( size_type chars_capacity
+        , const Allocator& a = Allocator() )
+        : _allocator(a)
+        , _capacity_hint(chars_capacity)
+    {
+    }
+
+    basic_api_string_batch_builder(const basic_api_string_batch_builder&) = delete;
+    basic_api_string_batch_builder& operator=(const basic_api_string_batch_builder&) = delete;
+
+    ~basic_api_string_batch_builder()
+    {
+        _release_memory();
+    }
+
+    /**
+        Ensures that `strings_count` strings whose lengths sum up to
+        `chars_count` ( not counting the null terminators ) can be
+        appended without reallocation.
+    */
+    void reserve(size_type chars_count, size_type strings_count)
+    {
+        size_type required = _used + chars_count + strings_count;
+        if (required > _capacity)
+        {
+            _replace_memory(required);
+        }
+    }
+
+    void append(const CharT* str, size_type count);
+
+    void append(const CharT* str)
+    {
+        append(str, Traits::length(str));
+    }
+
+    void append(const speudo_std::basic_api_string<CharT>& str)
+    {
+        append(str.data(), str.size());
+    }
+
+    /**
+        Number of strings appended since the last call to `build` or `clear`
+    */
+    size_type size() const noexcept
+    {
+        return _entries.size();
+    }
+
+    bool empty() const noexcept
+    {
+        return _entries.empty();
+    }
+
+    void clear() noexcept
+    {
+        _entries.clear();
+        _small_chars.clear();
+        _used = 0;
+    }
+
+    /**
+        Writes into `out` one `basic_api_string` for each string appended,
+        in the same order. The builder becomes empty, even if writing
+        into `out` throws, in which case the strings already written
+        remain valid.
+    */
+    template <typename OutputIt>
+    OutputIt build(OutputIt out);
+
+    std::vector<speudo_std::basic_api_string<CharT>> build()
+    {
+        std::vector<speudo_std::basic_api_string<CharT>> v;
+        v.reserve(_entries.size());
+        build(std::back_inserter(v));
+        return v;
+    }
+
+    allocator_type get_allocator() const
+    {
+        return _allocator;
+    }
+
+private:
+
+    using _data_type = speudo_std::abi::api_string_data<CharT>;
+
+    // `offset` is in `_small_chars` for the small strings,
+    // and in the block for the others
+    struct _entry
+    {
+        size_type offset;
+        size_type len;
+    };
+
+    static bool _is_small(size_type len)
+    {
+        return len <= _data_type::small_capacity();
+    }
+
+    CharT* _pool() const
+    {
+        return reinterpret_cast<CharT*>(_mem.pool);
+    }
+
+    void _replace_memory(size_type min_capacity);
+
+    void _release_memory()
+    {
+        if (_mem.manager != nullptr)
+        {
+            _mem.manager->release();
+            _mem = {};
+            _capacity = 0;
+        }
+    }
+
+    Allocator _allocator;
+    typename _memory_creator::memory _mem = {};
+    size_type _capacity = 0;
+    size_type _used = 0;
+    size_type _capacity_hint = 0;
+    std::vector<_entry> _entries;
+    std::vector<CharT> _small_chars;
+};
+
+template <typename CharT, typename Traits, typename Allocator>
+void basic_api_string_batch_builder<CharT, Traits, Allocator>::append
+    ( const CharT* str
+    , size_type count )
+{
+    if (_is_small(count))
+    {
+        _entries.push_back(_entry{_small_chars.size(), count});
+        _small_chars.insert(_small_chars.end(), str, str + count);
+        return;
+    }
+    if (_used + count + 1 > _capacity)
+    {
+        _replace_memory(2 * (_used + count + 1));
+    }
+    CharT* dest = _pool() + _used;
+    Traits::copy(dest, str, count);
+    Traits::assign(dest[count], CharT{});
+    _entries.push_back(_entry{_used, count});
+    _used += count + 1;
+}
+
+template <typename CharT, typename Traits, typename Allocator>
+template <typename OutputIt>
+OutputIt basic_api_string_batch_builder<CharT, Traits, Allocator>::build(OutputIt out)
+{
+    size_type big_count = 0;
+    for (const auto& e : _entries)
+    {
+        big_count += ! _is_small(e.len);
+    }
+    if (big_count > 1)
+    {
+        _memory_creator::add_references(_mem.manager, big_count - 1);
+    }
+    size_type handed = 0; // the references taken by the big strings
+    try
+    {
+        for (const auto& e : _entries)
+        {
+            if (e.len == 0)
+            {
+                *out = speudo_std::basic_api_string<CharT>{};
+            }
+            else if (_is_small(e.len))
+            {
+                *out = speudo_std::basic_api_string<CharT>(_small_chars.data() + e.offset, e.len);
+            }
+            else
+            {
+                auto s = speudo_std::_detail::basic_string_helper::adopt
+                    ( _mem.manager, _pool() + e.offset, e.len );
+                ++handed;
+                *out = std::move(s);
+            }
+            ++out;
+        }
+    }
+    catch (...)
+    {
+        // The strings already written may reference the block, which
+        // hence can not be reused, unless there is no big string.
+        if (big_count != 0)
+        {
+            if (handed != big_count)
+            {
+                _mem.manager->release_n(big_count - handed);
+            }
+            _mem = {};
+            _capacity = 0;
+        }
+        clear();
+        throw;
+    }
+    if (_capacity > _capacity_hint)
+    {
+        _capacity_hint = _capacity;
+    }
+    if (big_count != 0)
+    {
+        _mem = {};
+        _capacity = 0;
+    }
+    clear();
+    return out;
+}
+
+template <typename CharT, typename Traits, typename Allocator>
+void basic_api_string_batch_builder<CharT, Traits, Allocator>::_replace_memory
+    ( size_type min_capacity )
+{
+    if (min_capacity < _capacity_hint)
+    {
+        min_capacity = _capacity_hint;
+    }
+    auto m = _memory_creator::create(_allocator, min_capacity * sizeof(CharT));
+    if (_used != 0)
+    {
+        Traits::copy(reinterpret_cast<CharT*>(m.pool), _pool(), _used);
+    }
+    _release_memory();
+    _mem = m;
+    _capacity = m.pool_size / sizeof(CharT);
+}
+
+using api_string_batch_builder    = basic_api_string_batch_builder<char>;
+using api_u16string_batch_builder = basic_api_string_batch_builder<char16_t>;
+using api_u32string_batch_builder = basic_api_string_batch_builder<char32_t>;
+using api_wstring_batch_builder   = basic_api_string_batch_builder<wchar_t>;
+
+} // namespace speudo_std
+
+#endif
@@ -0,0 +1,292 @@
+#ifndef SPEUDO_STD_API_STRING_CODE_POINTS_HPP
+#define SPEUDO_STD_API_STRING_CODE_POINTS_HPP
+
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <detail/api_string_memory.hpp>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace speudo_std {
+
+/**
+    A sparse index from the code points of a UTF-8 ( `char` ) or UTF-16
+    ( `char16_t`, or `wchar_t` when it has two bytes ) string to their
+    positions: it holds the position of one code point every `stride`,
+    so that the position of any code point is found in at most
+    `stride - 1` steps.
+
+    The code points are counted as the code units that do not continue
+    a code point ( the continuation bytes in UTF-8 and the low surrogates
+    in UTF-16 ), so that invalid strings are indexed consistently too.
+*/
+template <typename CharT>
+class basic_code_point_index
+{
+    static_assert( sizeof(CharT) <= 2
+                 , "basic_code_point_index supports UTF-8 and UTF-16 strings" );
+
+public:
+
+    using size_type = std::size_t;
+
+    constexpr static size_type stride = 64;
+
+    basic_code_point_index(const CharT* str, size_type len);
+
+    const CharT* data() const noexcept
+    {
+        return _str;
+    }
+
+    size_type code_units_count() const noexcept
+    {
+        return _len;
+    }
+
+    size_type code_points_count() const noexcept
+    {
+        return _count;
+    }
+
+    /**
+        The position of the code point `cp`, or the length of the
+        string if `cp` is not less than the number of code points.
+    */
+    size_type offset_of(size_type cp) const noexcept
+    {
+        if (cp >= _count)
+        {
+            return _len;
+        }
+        return advance(_str, _offsets[cp / stride], cp % stride);
+    }
+
+    static bool starts_code_point(CharT ch) noexcept
+    {
+        if constexpr (sizeof(CharT) == 1)
+        {
+            return (static_cast<unsigned char>(ch) & 0xC0) != 0x80;
+        }
+        else
+        {
+            return (static_cast<std::uint16_t>(ch) & 0xFC00) != 0xDC00;
+        }
+    }
+
+    static size_type count(const CharT* str, size_type len) noexcept
+    {
+        size_type n = 0;
+        for (size_type i = 0; i < len; ++i)
+        {
+            n += starts_code_point(str[i]);
+        }
+        return n;
+    }
+
+    /**
+        The position of the `n`-th code point after the one at `pos`.
+        There must be enough code points in the string.
+    */
+    static size_type advance(const CharT* str, size_type pos, size_type n) noexcept
+    {
+        for (; n != 0; --n)
+        {
+            do
+            {
+                ++pos;
+            }
+            while ( ! starts_code_point(str[pos]));
+        }
+        return pos;
+    }
+
+private:
+
+    const CharT* _str;
+    size_type _len;
+    size_type _count = 0;
+    std::vector<size_type> _offsets;
+};
+
+using code_point_index    = basic_code_point_index<char>;
+using u16code_point_index = basic_code_point_index<char16_t>;
+
+/**
+    The strings shorter than this are scanned instead of indexed.
+*/
+constexpr std::size_t code_point_index_min_length = 1024;
+
+namespace _detail {
+
+template <typename CharT>
+struct code_point_index_aux: speudo_std::abi::api_string_aux
+{
+    constexpr static unsigned long kind_value = 0x100 + sizeof(CharT);
+
+    code_point_index_aux(const CharT* str, std::size_t len)
+        : speudo_std::abi::api_string_aux{destroy_self, kind_value}
+        , index(str, len)
+    {
+    }
+
+    static void destroy_self(speudo_std::abi::api_string_aux* aux)
+    {
+        delete static_cast<code_point_index_aux*>(aux);
+    }
+
+    speudo_std::basic_code_point_index<CharT> index;
+};
+
+/**
+    The index of `s` kept by its memory manager, which is created on the
+    first call, and then shared by all the copies of `s`. Returns null
+    when `s` is shorter than `code_point_index_min_length`, or when the
+    memory manager can not keep it ( see `api_string_mem_base::set_aux` ),
+    or already keeps something else, like the index of another string
+    of the same memory block.
+*/
+template <typename CharT>
+const speudo_std::basic_code_point_index<CharT>* cached_code_point_index
+    ( const speudo_std::basic_api_string<CharT>& s )
+{
+    using aux_type = speudo_std::_detail::code_point_index_aux<CharT>;
+    const auto& data = speudo_std::_detail::basic_string_helper::get_data(s);
+    if ( data.big.str == nullptr
+      || data.big.mem_manager == nullptr
+      || data.big.len < speudo_std::code_point_index_min_length
+      || ! data.big.mem_manager->supports_aux() )
+    {
+        return nullptr;
+    }
+    speudo_std::abi::api_string_aux* aux = data.big.mem_manager->get_aux();
+    if (aux == nullptr)
+    {
+        auto* created = new aux_type(data.big.str, data.big.len);
+        aux = data.big.mem_manager->set_aux(created);
+        if (aux != created)
+        {
+            // another thread was faster
+            created->destroy(created);
+        }
+    }
+    if (aux->kind == aux_type::kind_value)
+    {
+        const auto& index = static_cast<const aux_type*>(aux)->index;
+        if (index.data() == data.big.str && index.code_units_count() == data.big.len)
+        {
+            return &index;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace _detail
+
+/**
+    The number of code points of `s`, in constant time for the strings
+    that have a cached index ( see `code_point_offset` ).
+*/
+template <typename CharT>
+std::size_t code_points_count(const speudo_std::basic_api_string<CharT>& s)
+{
+    if constexpr (sizeof(CharT) == 4)
+    {
+        return s.size();
+    }
+    else if (auto* index = speudo_std::_detail::cached_code_point_index(s))
+    {
+        return index->code_points_count();
+    }
+    else
+    {
+        return speudo_std::basic_code_point_index<CharT>::count(s.data(), s.size());
+    }
+}
+
+/**
+    The position in `s` of the code point `cp`, or `s.size()` if `cp`
+    is not less than the number of code points.
+
+    For the strings of at least `code_point_index_min_length` code units,
+    a `basic_code_point_index` is created on the first call, and kept by
+    the memory manager, so that the following calls on `s` or on any of
+    its copies take constant time.
+*/
+template <typename CharT>
+std::size_t code_point_offset(const speudo_std::basic_api_string<CharT>& s, std::size_t cp)
+{
+    if constexpr (sizeof(CharT) == 4)
+    {
+        return cp < s.size() ? cp : s.size();
+    }
+    else if (auto* index = speudo_std::_detail::cached_code_point_index(s))
+    {
+        return index->offset_of(cp);
+    }
+    else
+    {
+        using index_type = speudo_std::basic_code_point_index<CharT>;
+        std::size_t pos = 0;
+        for (std::size_t n = 0; pos < s.size(); ++pos)
+        {
+            if (index_type::starts_code_point(s[pos]) && n++ == cp)
+            {
+                break;
+            }
+        }
+        return pos;
+    }
+}
+
+/**
+    The substring of `s` of `count` code points starting at the code
+    point `pos` ( or all the remaining ones ). It shares the memory of
+    `s` when it is a suffix of it ( see `basic_api_string_view::to_api_string` ).
+
+    Throws `std::out_of_range` if `pos` is greater than the number of code points.
+*/
+template <typename CharT>
+speudo_std::basic_api_string<CharT> substr_code_points
+    ( const speudo_std::basic_api_string<CharT>& s
+    , std::size_t pos
+    , std::size_t count = static_cast<std::size_t>(-1) )
+{
+    const std::size_t total = speudo_std::code_points_count(s);
+    if (pos > total)
+    {
+        speudo_std::_detail::throw_std_out_of_range("substr_code_points() out of range");
+    }
+    const std::size_t begin = speudo_std::code_point_offset(s, pos);
+    const std::size_t end = count >= total - pos
+                          ? s.size()
+                          : speudo_std::code_point_offset(s, pos + count);
+    return speudo_std::basic_api_string_view<CharT>(s).substr(begin, end - begin).to_api_string();
+}
+
+template <typename CharT>
+basic_code_point_index<CharT>::basic_code_point_index(const CharT* str, size_type len)
+    : _str(str)
+    , _len(len)
+{
+    _offsets.reserve(len / stride + 1);
+    for (size_type i = 0; i < len; ++i)
+    {
+        if (starts_code_point(str[i]))
+        {
+            if (_count % stride == 0)
+            {
+                _offsets.push_back(i);
+            }
+            ++_count;
+        }
+    }
+    _offsets.shrink_to_fit();
+}
+
+} // namespace speudo_std
+
+#endif
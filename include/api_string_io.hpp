@@ -0,0 +1,315 @@
+#ifndef SPEUDO_STD_API_STRING_IO_HPP
+#define SPEUDO_STD_API_STRING_IO_HPP
+
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <string.hpp>
+#include <iosfwd>
+#include <iterator>
+#include <system_error>
+#include <vector>
+#include <sys/uio.h>
+
+namespace speudo_std {
+
+namespace _detail {
+
+/**
+    Writes all the bytes described by `iov[0, count)`, calling `writev`
+    ( or `pwritev` when `offset >= 0` ) as many times as necessary:
+    in chunks of at most `IOV_MAX` elements, and resuming after partial
+    writes and `EINTR`. The elements of `iov` may be modified.
+
+    Returns the number of bytes written. Throws `std::system_error`.
+*/
+std::size_t writev_all(int fd, ::iovec* iov, std::size_t count, long long offset);
+
+template <typename String>
+inline ::iovec to_iovec(const String& s)
+{
+    using char_type = typename String::value_type;
+    return { const_cast<char_type*>(s.data()), s.size() * sizeof(char_type) };
+}
+
+} // namespace _detail
+
+/**
+    Writes the content of the strings in `[first, last)` into `fd` without
+    concatenating them, using the fewest `writev` calls possible.
+    The elements can be `basic_api_string` or `basic_string` objects.
+
+    Returns the number of bytes written. Throws `std::system_error`.
+*/
+template <typename InputIt>
+std::size_t gather_write(int fd, InputIt first, InputIt last)
+{
+    std::vector<::iovec> iov;
+    for (; first != last; ++first)
+    {
+        if ( ! first->empty())
+        {
+            iov.push_back(speudo_std::_detail::to_iovec(*first));
+        }
+    }
+    return speudo_std::_detail::writev_all(fd, iov.data(), iov.size(), -1);
+}
+
+/**
+    Like `gather_write`, but writes at position `offset` of the file
+    ( with `pwritev` ), without changing the file offset.
+*/
+template <typename InputIt>
+std::size_t gather_pwrite(int fd, InputIt first, InputIt last, long long offset)
+{
+    std::vector<::iovec> iov;
+    for (; first != last; ++first)
+    {
+        if ( ! first->empty())
+        {
+            iov.push_back(speudo_std::_detail::to_iovec(*first));
+        }
+    }
+    return speudo_std::_detail::writev_all(fd, iov.data(), iov.size(), offset);
+}
+
+/**
+    A list of fragments to be written together.
+
+    It keeps a copy of each fragment ( which does not copy the characters
+    of managed strings ), so the fragments stay alive until the write
+    completes, even if the caller releases its own references.
+    A `basic_string` moved into the list is converted to
+    `basic_api_string` without copying its content.
+
+    The list can be reused after `clear()`, keeping its capacity.
+*/
+template <typename CharT>
+class basic_api_string_gather_list
+{
+public:
+
+    using value_type = speudo_std::basic_api_string<CharT>;
+    using size_type = std::size_t;
+
+    void push_back(const speudo_std::basic_api_string<CharT>& s)
+    {
+        if ( ! s.empty())
+        {
+            _fragments.push_back(s);
+            _bytes += s.size() * sizeof(CharT);
+        }
+    }
+
+    void push_back(speudo_std::basic_api_string<CharT>&& s)
+    {
+        if ( ! s.empty())
+        {
+            _bytes += s.size() * sizeof(CharT);
+            _fragments.push_back(std::move(s));
+        }
+    }
+
+    template <typename Traits, typename Allocator>
+    void push_back(speudo_std::basic_string<CharT, Traits, Allocator>&& s)
+    {
+        push_back(speudo_std::basic_api_string<CharT>(std::move(s)));
+    }
+
+    template <typename Traits, typename Allocator>
+    void push_back(const speudo_std::basic_string<CharT, Traits, Allocator>& s)
+    {
+        push_back(speudo_std::basic_api_string<CharT>(s));
+    }
+
+    size_type size() const noexcept
+    {
+        return _fragments.size();
+    }
+
+    bool empty() const noexcept
+    {
+        return _fragments.empty();
+    }
+
+    /**
+        Total number of bytes of all fragments
+    */
+    size_type bytes() const noexcept
+    {
+        return _bytes;
+    }
+
+    void clear() noexcept
+    {
+        _fragments.clear();
+        _bytes = 0;
+    }
+
+    const std::vector<::iovec>& iovecs()
+    {
+        _iov.clear();
+        _iov.reserve(_fragments.size());
+        for (const auto& f : _fragments)
+        {
+            _iov.push_back(speudo_std::_detail::to_iovec(f));
+        }
+        return _iov;
+    }
+
+    size_type write(int fd)
+    {
+        iovecs();
+        return speudo_std::_detail::writev_all(fd, _iov.data(), _iov.size(), -1);
+    }
+
+    size_type pwrite(int fd, long long offset)
+    {
+        iovecs();
+        return speudo_std::_detail::writev_all(fd, _iov.data(), _iov.size(), offset);
+    }
+
+private:
+
+    std::vector<speudo_std::basic_api_string<CharT>> _fragments;
+    std::vector<::iovec> _iov;
+    size_type _bytes = 0;
+};
+
+using api_string_gather_list    = basic_api_string_gather_list<char>;
+using api_u16string_gather_list = basic_api_string_gather_list<char16_t>;
+using api_u32string_gather_list = basic_api_string_gather_list<char32_t>;
+using api_wstring_gather_list   = basic_api_string_gather_list<wchar_t>;
+
+enum class file_loader_backend
+{
+    automatic,   // io_uring when available, thread_pool otherwise
+    io_uring,
+    thread_pool
+};
+
+struct file_loader_options
+{
+    file_loader_backend backend = file_loader_backend::automatic;
+
+    // io_uring: maximum number of reads in flight
+    unsigned queue_depth = 64;
+
+    // thread_pool: number of threads. Zero means `std::thread::hardware_concurrency()`
+    unsigned threads = 0;
+};
+
+/**
+    Reads the files whose paths are `paths[0, count)`.
+
+    The content of each file is read directly into a memory block
+    allocated with the size of the file ( plus the null terminator ),
+    which is then referenced by `contents[i]`.
+
+    If `errors` is not null, `errors[i]` receives the error that
+    happened while reading `paths[i]`, or a default constructed
+    `std::error_code` on success. Otherwise, a `std::system_error` is
+    thrown for the first file that fails, after all the others are read.
+
+    With `file_loader_backend::io_uring`, a `std::system_error` is thrown
+    if io_uring is not available. With `file_loader_backend::automatic`,
+    the files that are not loaded because io_uring fails meanwhile are
+    then read by the thread pool.
+*/
+void load_files
+    ( const speudo_std::api_string* paths
+    , std::size_t count
+    , speudo_std::api_string* contents
+    , std::error_code* errors
+    , const speudo_std::file_loader_options& options = {} );
+
+inline std::vector<speudo_std::api_string> load_files
+    ( const std::vector<speudo_std::api_string>& paths
+    , const speudo_std::file_loader_options& options = {} )
+{
+    std::vector<speudo_std::api_string> contents(paths.size());
+    speudo_std::load_files
+        ( paths.data(), paths.size(), contents.data(), nullptr, options );
+    return contents;
+}
+
+/**
+    Reads lines from a file descriptor or from a `std::istream`.
+
+    The input is read in large chunks of memory, and each line is returned
+    as an `api_string` that references the chunk and shares its reference
+    counter: the new line character is replaced by the null terminator
+    in place. Only the lines that cross the end of a chunk are copied
+    ( to the beginning of the next one ), and the lines that fit in the
+    small string optimization are copied into the `api_string` object.
+    A chunk is recycled, instead of allocating a new one, when none of
+    its lines is alive anymore.
+
+    A trailing "\r" is removed from each line. Throws `std::system_error`
+    when the read fails.
+
+    A line is returned as soon as it is received, without waiting for
+    the chunk to be full. When the end of the input is reached, `getline`
+    returns false, but the next calls return the lines that may have
+    been received meanwhile. A last line without a new line character
+    is returned as a whole line, so if the input grows afterwards, what
+    follows is returned as a new line.
+*/
+class api_string_line_reader
+{
+public:
+
+    constexpr static std::size_t default_chunk_size = 1 << 20;
+
+    explicit api_string_line_reader(int fd, std::size_t chunk_size = default_chunk_size);
+
+    explicit api_string_line_reader(std::istream& is, std::size_t chunk_size = default_chunk_size);
+
+    api_string_line_reader(const api_string_line_reader&) = delete;
+    api_string_line_reader& operator=(const api_string_line_reader&) = delete;
+
+    ~api_string_line_reader();
+
+    /**
+        Returns false when there is no more line to read.
+    */
+    bool getline(speudo_std::api_string& line);
+
+private:
+
+    using _read_func = std::size_t (*)(void* source, char* buff, std::size_t count);
+
+    struct _chunk
+    {
+        speudo_std::abi::api_string_mem_base* manager = nullptr;
+        char* begin = nullptr;
+        char* end = nullptr;
+    };
+
+    bool _refill();
+
+    _read_func _read;
+    void* _source;
+    std::size_t _chunk_size;
+    _chunk _current;
+    _chunk _spare; // the previous chunk, reused once no line references it
+    char* _begin = nullptr;
+    char* _end = nullptr;
+};
+
+/**
+    Maps the file at `path` into memory ( read-only ) and returns an
+    `api_string` that references the mapping. The mapping is released
+    when the last copy of the returned object is destroyed.
+
+    The content is always followed by a null character, even when the
+    file size is a multiple of the page size.
+
+    Throws `std::system_error` on failure.
+*/
+speudo_std::api_string map_file(const char* path);
+
+} // namespace speudo_std
+
+#endif
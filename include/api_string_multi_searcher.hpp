@@ -0,0 +1,354 @@
+#ifndef SPEUDO_STD_API_STRING_MULTI_SEARCHER_HPP
+#define SPEUDO_STD_API_STRING_MULTI_SEARCHER_HPP
+
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <api_string.hpp>
+#include <cstdint>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace speudo_std {
+
+/**
+    An occurrence of the pattern of index `pattern` that starts
+    at `position` in the haystack.
+*/
+struct api_string_match
+{
+    std::size_t pattern;
+    std::size_t position;
+
+    friend bool operator==(const api_string_match& a, const api_string_match& b) noexcept
+    {
+        return a.pattern == b.pattern && a.position == b.position;
+    }
+    friend bool operator!=(const api_string_match& a, const api_string_match& b) noexcept
+    {
+        return ! (a == b);
+    }
+};
+
+/**
+    Searches many patterns at once ( Aho-Corasick ). The patterns are
+    compiled into a deterministic automaton, so that the haystack is
+    read once, with one table lookup per character, whatever the number
+    of patterns.
+
+    The table is kept small by mapping the characters to classes: one per
+    character that appears in the patterns, and one for all the others.
+    The states are numbered so that the ones where a pattern ends come
+    last, and the transitions hold the offset of the row of the target
+    state, so that the inner loop is just:
+
+        state = transitions[state + class_of(ch)];
+        if (state >= first_output_state) { report matches }
+
+    Only `char` and `char16_t` ( or any type of at most two bytes ) are
+    supported. Empty patterns never match.
+*/
+template <typename CharT>
+class basic_api_string_multi_searcher
+{
+    static_assert( sizeof(CharT) <= 2
+                 , "basic_api_string_multi_searcher supports characters of up to two bytes" );
+
+public:
+
+    using size_type = std::size_t;
+
+    explicit basic_api_string_multi_searcher
+        ( std::vector<speudo_std::basic_api_string<CharT>> patterns );
+
+    basic_api_string_multi_searcher
+        ( std::initializer_list<speudo_std::basic_api_string_view<CharT>> patterns );
+
+    const std::vector<speudo_std::basic_api_string<CharT>>& patterns() const noexcept
+    {
+        return _patterns;
+    }
+
+    /**
+        The number of states of the automaton
+    */
+    size_type states_count() const noexcept
+    {
+        return _transitions.size() / _classes_count;
+    }
+
+    /**
+        The number of character classes, including the one of the
+        characters that do not appear in any pattern
+    */
+    size_type classes_count() const noexcept
+    {
+        return _classes_count;
+    }
+
+    /**
+        Calls `f(api_string_match)` for each occurrence of each pattern in
+        `haystack`, in the order of their ends, and the longest pattern
+        first for occurrences that end at the same position. If `f` returns
+        a `bool`, the search stops when it returns `false`.
+    */
+    template <typename F>
+    void for_each_match(speudo_std::basic_api_string_view<CharT> haystack, F&& f) const;
+
+    std::vector<speudo_std::api_string_match> find_all
+        ( speudo_std::basic_api_string_view<CharT> haystack ) const
+    {
+        std::vector<speudo_std::api_string_match> matches;
+        for_each_match(haystack, [&](const speudo_std::api_string_match& m)
+        {
+            matches.push_back(m);
+        });
+        return matches;
+    }
+
+    bool found_in(speudo_std::basic_api_string_view<CharT> haystack) const
+    {
+        bool found = false;
+        for_each_match(haystack, [&](const speudo_std::api_string_match&)
+        {
+            found = true;
+            return false;
+        });
+        return found;
+    }
+
+private:
+
+    using _state_type = std::uint32_t;
+    constexpr static _state_type _no_state = static_cast<_state_type>(-1);
+
+    std::uint32_t _class_of(CharT ch) const noexcept
+    {
+        using unsigned_char = typename std::conditional
+            < sizeof(CharT) == 1, unsigned char, std::uint16_t >::type;
+        const auto c = static_cast<unsigned_char>(ch);
+        return _class_pages[(_page_of[c >> 8] << 8) | (c & 0xFF)];
+    }
+
+    void _build();
+
+    std::vector<speudo_std::basic_api_string<CharT>> _patterns;
+
+    // The class of character `c` is `_class_pages[_page_of[c >> 8] * 256 + (c & 0xFF)]`.
+    // The pages where no character appears in the patterns share page 0,
+    // in which all characters are of class 0.
+    std::uint32_t _page_of[256] = {};
+    std::vector<std::uint32_t> _class_pages;
+    size_type _classes_count = 1;
+
+    // `_transitions[offset + class]` is the offset of the next state.
+    // The offset of a state is its number times `_classes_count`.
+    std::vector<_state_type> _transitions;
+    _state_type _first_output_offset = 0;
+
+    // The patterns that end at each state with outputs, indexed by
+    // ( offset - _first_output_offset ) / _classes_count, as ranges of
+    // `_outputs`, which contains pattern indexes.
+    std::vector<_state_type> _outputs_begin;
+    std::vector<_state_type> _outputs;
+};
+
+using api_string_multi_searcher    = basic_api_string_multi_searcher<char>;
+using api_u16string_multi_searcher = basic_api_string_multi_searcher<char16_t>;
+
+template <typename CharT>
+basic_api_string_multi_searcher<CharT>::basic_api_string_multi_searcher
+    ( std::vector<speudo_std::basic_api_string<CharT>> patterns )
+    : _patterns(std::move(patterns))
+{
+    _build();
+}
+
+template <typename CharT>
+basic_api_string_multi_searcher<CharT>::basic_api_string_multi_searcher
+    ( std::initializer_list<speudo_std::basic_api_string_view<CharT>> patterns )
+{
+    _patterns.reserve(patterns.size());
+    for (auto p : patterns)
+    {
+        _patterns.push_back(p.to_api_string());
+    }
+    _build();
+}
+
+template <typename CharT>
+void basic_api_string_multi_searcher<CharT>::_build()
+{
+    // character classes
+    _class_pages.assign(256, 0);
+    for (const auto& p : _patterns)
+    {
+        for (CharT ch : p)
+        {
+            using unsigned_char = typename std::conditional
+                < sizeof(CharT) == 1, unsigned char, std::uint16_t >::type;
+            const auto c = static_cast<unsigned_char>(ch);
+            if (_page_of[c >> 8] == 0)
+            {
+                _page_of[c >> 8] = static_cast<std::uint32_t>(_class_pages.size() / 256);
+                _class_pages.resize(_class_pages.size() + 256, 0);
+            }
+            auto& cls = _class_pages[(_page_of[c >> 8] << 8) | (c & 0xFF)];
+            if (cls == 0)
+            {
+                cls = static_cast<std::uint32_t>(_classes_count++);
+            }
+        }
+    }
+    const size_type classes = _classes_count;
+
+    // trie, with state numbers as transitions
+    std::vector<_state_type> delta(classes, _no_state);
+    std::vector<std::vector<_state_type>> ends(1);
+    for (size_type i = 0; i < _patterns.size(); ++i)
+    {
+        if (_patterns[i].empty())
+        {
+            continue;
+        }
+        _state_type s = 0;
+        for (CharT ch : _patterns[i])
+        {
+            const size_type t = s * classes + _class_of(ch);
+            if (delta[t] == _no_state)
+            {
+                delta[t] = static_cast<_state_type>(ends.size());
+                ends.emplace_back();
+                delta.resize(delta.size() + classes, _no_state);
+            }
+            s = delta[t];
+        }
+        ends[s].push_back(static_cast<_state_type>(i));
+    }
+    const size_type states = ends.size();
+
+    // failure and dictionary suffix links, in breadth first order,
+    // completing the transitions into those of the automaton
+    std::vector<_state_type> fail(states, 0);
+    std::vector<_state_type> dict(states, _no_state);
+    std::vector<_state_type> queue;
+    queue.reserve(states);
+    for (size_type c = 0; c < classes; ++c)
+    {
+        _state_type& t = delta[c];
+        if (t == _no_state)
+        {
+            t = 0;
+        }
+        else
+        {
+            queue.push_back(t);
+        }
+    }
+    for (size_type q = 0; q < queue.size(); ++q)
+    {
+        const _state_type s = queue[q];
+        const _state_type f = fail[s];
+        dict[s] = ends[f].empty() ? dict[f] : f;
+        for (size_type c = 0; c < classes; ++c)
+        {
+            _state_type& t = delta[s * classes + c];
+            if (t == _no_state)
+            {
+                t = delta[f * classes + c];
+            }
+            else
+            {
+                fail[t] = delta[f * classes + c];
+                queue.push_back(t);
+            }
+        }
+    }
+
+    // renumbering: the states with outputs come last
+    std::vector<_state_type> number(states);
+    _state_type next_number = 0;
+    for (int with_output = 0; with_output < 2; ++with_output)
+    {
+        if (with_output)
+        {
+            _first_output_offset = static_cast<_state_type>(next_number * classes);
+        }
+        for (size_type s = 0; s < states; ++s)
+        {
+            const bool has_output = ! ends[s].empty() || dict[s] != _no_state;
+            if (has_output == static_cast<bool>(with_output))
+            {
+                number[s] = next_number++;
+            }
+        }
+    }
+    _transitions.resize(states * classes);
+    std::vector<_state_type> state_of(states);
+    for (size_type s = 0; s < states; ++s)
+    {
+        state_of[number[s]] = static_cast<_state_type>(s);
+        for (size_type c = 0; c < classes; ++c)
+        {
+            _transitions[number[s] * classes + c] =
+                static_cast<_state_type>(number[delta[s * classes + c]] * classes);
+        }
+    }
+
+    // outputs, following the dictionary links
+    const size_type first_output = _first_output_offset / classes;
+    for (size_type n = first_output; n < states; ++n)
+    {
+        _outputs_begin.push_back(static_cast<_state_type>(_outputs.size()));
+        for (_state_type s = state_of[n]; s != _no_state; s = dict[s])
+        {
+            _outputs.insert(_outputs.end(), ends[s].begin(), ends[s].end());
+        }
+    }
+    _outputs_begin.push_back(static_cast<_state_type>(_outputs.size()));
+}
+
+template <typename CharT>
+template <typename F>
+void basic_api_string_multi_searcher<CharT>::for_each_match
+    ( speudo_std::basic_api_string_view<CharT> haystack
+    , F&& f ) const
+{
+    const CharT* str = haystack.data();
+    const size_type len = haystack.size();
+    const _state_type* transitions = _transitions.data();
+    _state_type state = 0;
+    for (size_type i = 0; i < len; ++i)
+    {
+        state = transitions[state + _class_of(str[i])];
+        if (state >= _first_output_offset)
+        {
+            const size_type index = (state - _first_output_offset) / _classes_count;
+            for ( auto o = _outputs_begin[index]
+                ; o != _outputs_begin[index + 1]
+                ; ++o )
+            {
+                const size_type p = _outputs[o];
+                const speudo_std::api_string_match m{p, i + 1 - _patterns[p].size()};
+                if constexpr (std::is_same<decltype(f(m)), bool>::value)
+                {
+                    if ( ! f(m))
+                    {
+                        return;
+                    }
+                }
+                else
+                {
+                    f(m);
+                }
+            }
+        }
+    }
+}
+
+} // namespace speudo_std
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef SPEUDO_STD_API_STRING_PMR_HPP
+#define SPEUDO_STD_API_STRING_PMR_HPP
+
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <string.hpp>
+#include <memory_resource>
+
+namespace speudo_std {
+
+namespace _detail {
+
+extern template class api_string_mem<std::pmr::polymorphic_allocator<char>>;
+extern template class api_string_mem<std::pmr::polymorphic_allocator<char16_t>>;
+extern template class api_string_mem<std::pmr::polymorphic_allocator<char32_t>>;
+extern template class api_string_mem<std::pmr::polymorphic_allocator<wchar_t>>;
+
+void api_string_init
+    ( speudo_std::abi::api_string_data<char>& data
+    , const char* str
+    , std::size_t count
+    , std::pmr::memory_resource* resource );
+
+void api_string_init
+    ( speudo_std::abi::api_string_data<char16_t>& data
+    , const char16_t* str
+    , std::size_t count
+    , std::pmr::memory_resource* resource );
+
+void api_string_init
+    ( speudo_std::abi::api_string_data<char32_t>& data
+    , const char32_t* str
+    , std::size_t count
+    , std::pmr::memory_resource* resource );
+
+void api_string_init
+    ( speudo_std::abi::api_string_data<wchar_t>& data
+    , const wchar_t* str
+    , std::size_t count
+    , std::pmr::memory_resource* resource );
+
+} // namespace _detail
+
+namespace pmr {
+
+template <typename CharT, typename Traits = std::char_traits<CharT>>
+using basic_string = speudo_std::basic_string
+    < CharT, Traits, std::pmr::polymorphic_allocator<CharT> >;
+
+using string    = speudo_std::pmr::basic_string<char>;
+using wstring   = speudo_std::pmr::basic_string<wchar_t>;
+using u16string = speudo_std::pmr::basic_string<char16_t>;
+using u32string = speudo_std::pmr::basic_string<char32_t>;
+
+/**
+    Creates a `basic_api_string` whose memory, if the string does not fit
+    in the small string buffer, is allocated from `resource`, which must
+    outlive it.
+*/
+template <typename CharT>
+speudo_std::basic_api_string<CharT> api_string_init
+    ( std::pmr::memory_resource* resource
+    , const CharT* str
+    , std::size_t count )
+{
+    speudo_std::basic_api_string<CharT> s;
+    speudo_std::_detail::api_string_init
+        ( speudo_std::_detail::basic_string_helper::get_data(s)
+        , str, count, resource );
+    return s;
+}
+
+template <typename CharT>
+speudo_std::basic_api_string<CharT> api_string_init
+    ( std::pmr::memory_resource* resource
+    , const CharT* str )
+{
+    return speudo_std::pmr::api_string_init
+        ( resource, str, std::char_traits<CharT>::length(str) );
+}
+
+} // namespace pmr
+
+} // namespace speudo_std
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef SPEUDO_STD_API_STRING_RANGE_HPP
+#define SPEUDO_STD_API_STRING_RANGE_HPP
+
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <detail/api_string_memory.hpp>
+#include <iterator>
+#include <type_traits>
+
+namespace speudo_std {
+
+namespace _detail {
+
+/**
+    Accumulates reference count updates of consecutive strings that
+    share the same memory manager, so that each group costs one call
+    to `acquire_n` or `release_n`.
+*/
+template <bool Acquire>
+class api_string_refcount_batch
+{
+public:
+
+    api_string_refcount_batch() noexcept = default;
+    api_string_refcount_batch(const api_string_refcount_batch&) = delete;
+
+    ~api_string_refcount_batch()
+    {
+        flush();
+    }
+
+    template <typename CharT>
+    void add(const speudo_std::abi::api_string_data<CharT>& data) noexcept
+    {
+        auto* manager = data.big.mem_manager;
+        if (data.big.str == nullptr || manager == nullptr)
+        {
+            return;
+        }
+        if (manager != _manager)
+        {
+            flush();
+            _manager = manager;
+        }
+        ++_count;
+    }
+
+    void flush() noexcept
+    {
+        if (_count != 0)
+        {
+            if (Acquire)
+            {
+                _manager->acquire_n(_count);
+            }
+            else
+            {
+                _manager->release_n(_count);
+            }
+            _count = 0;
+        }
+        _manager = nullptr;
+    }
+
+private:
+
+    speudo_std::abi::api_string_mem_base* _manager = nullptr;
+    std::size_t _count = 0;
+};
+
+} // namespace _detail
+
+/**
+    Releases the strings in range `[first, last)` and leaves them empty,
+    so that destroying them afterwards does nothing. Consecutive strings
+    that share the same memory manager are released with a single atomic
+    operation ( if the manager supports it, see `abi_version` ), while
+    small and unmanaged strings are skipped.
+
+        speudo_std::release_api_strings(records.begin(), records.end());
+        records.clear();
+*/
+template <typename ForwardIt>
+void release_api_strings(ForwardIt first, ForwardIt last) noexcept
+{
+    speudo_std::_detail::api_string_refcount_batch<false> batch;
+    for (; first != last; ++first)
+    {
+        auto& data = speudo_std::_detail::basic_string_helper::get_data(*first);
+        batch.add(data);
+        speudo_std::abi::reset(data);
+    }
+}
+
+/**
+    Assigns the strings in range `[first, last)` to the range beginning
+    at `d_first`, and returns the end of the destination range. The
+    destination range must already hold as many strings as the source
+    one, since their previous values are released in the same pass:
+    it can not be an output iterator like `std::back_inserter`, so
+    resize the destination first. The reference counters are updated
+    the same way as in `release_api_strings`. The ranges may be equal,
+    but must not overlap otherwise.
+*/
+template <typename ForwardIt1, typename ForwardIt2>
+ForwardIt2 copy_api_strings(ForwardIt1 first, ForwardIt1 last, ForwardIt2 d_first) noexcept
+{
+    static_assert( std::is_lvalue_reference_v<decltype(*d_first)>
+                 , "copy_api_strings: the destination must be a range of existing strings" );
+    using speudo_std::_detail::basic_string_helper;
+    {
+        // acquire everything first, so that no memory is released
+        // while it is still referenced by the source range
+        speudo_std::_detail::api_string_refcount_batch<true> batch;
+        for (ForwardIt1 it = first; it != last; ++it)
+        {
+            batch.add(basic_string_helper::get_data(*it));
+        }
+    }
+    speudo_std::_detail::api_string_refcount_batch<false> batch;
+    for (; first != last; ++first, ++d_first)
+    {
+        auto& dest = basic_string_helper::get_data(*d_first);
+        batch.add(dest);
+        dest = basic_string_helper::get_data(*first);
+    }
+    return d_first;
+}
+
+} // namespace speudo_std
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef SPEUDO_STD_API_STRING_REALLOC_HPP
+#define SPEUDO_STD_API_STRING_REALLOC_HPP
+
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <string.hpp>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace speudo_std {
+
+/**
+    An allocator based on `std::malloc`, `std::realloc` and `std::free`.
+
+    It provides the `reallocate` extension ( see `_detail::has_reallocate` ),
+    so a `basic_string` that uses it grows its memory block with
+    `std::realloc`, which, for large blocks, usually remaps the pages
+    instead of copying them. Only the characters are relocated this way:
+    the header of the block, which holds the reference counters, is
+    destroyed before the call and constructed again afterwards.
+
+    `GrowthPolicy` is the growth policy of the `basic_string`
+    ( see `string_growth_policy` ).
+*/
+template
+    < typename T
+    , typename GrowthPolicy = speudo_std::string_growth_policy<> >
+class realloc_allocator
+{
+public:
+
+    using value_type = T;
+    using growth_policy = GrowthPolicy;
+    using is_always_equal = std::true_type;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = speudo_std::realloc_allocator<U, GrowthPolicy>;
+    };
+
+    realloc_allocator() noexcept = default;
+
+    template <typename U>
+    realloc_allocator(const realloc_allocator<U, GrowthPolicy>&) noexcept
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+        static_assert( alignof(T) <= alignof(std::max_align_t)
+                     , "realloc_allocator does not support over-aligned types" );
+        void* p = std::malloc(n * sizeof(T));
+        if (p == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, std::size_t) noexcept
+    {
+        std::free(p);
+    }
+
+    T* reallocate(T* p, std::size_t, std::size_t new_n) noexcept
+    {
+        return static_cast<T*>(std::realloc(p, new_n * sizeof(T)));
+    }
+};
+
+template <typename T, typename U, typename G>
+bool operator==(const realloc_allocator<T, G>&, const realloc_allocator<U, G>&) noexcept
+{
+    return true;
+}
+
+template <typename T, typename U, typename G>
+bool operator!=(const realloc_allocator<T, G>&, const realloc_allocator<U, G>&) noexcept
+{
+    return false;
+}
+
+} // namespace speudo_std
+
+#endif
@@ -0,0 +1,194 @@
+#ifndef SPEUDO_STD_API_STRING_RECLAIMER_HPP
+#define SPEUDO_STD_API_STRING_RECLAIMER_HPP
+
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+namespace speudo_std {
+
+/**
+    A background thread that deallocates the memory blocks handed to it
+    by `defer`, so that the thread that releases the last reference to a
+    large string does not pay for the deallocation.
+
+    `defer` does not allocate: the pending blocks are linked into a
+    lock-free list through their own ( dead ) memory, and the reclaimer
+    thread is only woken up when the list was empty. On Linux, it is
+    woken up through a futex, so that `defer` never blocks either;
+    elsewhere, `defer` then briefly locks a mutex.
+*/
+class api_string_reclaimer
+{
+public:
+
+    using free_func = void (*)(void* ptr, std::size_t count);
+
+    /**
+        The blocks of at least `min_bytes` bytes are deferred; the smaller
+        ones are deallocated immediately. The default matches the size
+        above which glibc's `malloc` uses `mmap`, hence `free` a `munmap`.
+    */
+    explicit api_string_reclaimer(std::size_t min_bytes = 128 * 1024);
+
+    api_string_reclaimer(const api_string_reclaimer&) = delete;
+    api_string_reclaimer& operator=(const api_string_reclaimer&) = delete;
+
+    /**
+        Deallocates the pending blocks and stops the thread.
+    */
+    ~api_string_reclaimer();
+
+    /**
+        The reclaimer used by default by `deferred_allocator`.
+        It is started on first use and never stopped.
+    */
+    static api_string_reclaimer& global();
+
+    std::size_t min_bytes() const noexcept
+    {
+        return _min_bytes;
+    }
+
+    /**
+        Calls `free(ptr, count)` either now, if `bytes` is less than
+        `min_bytes()` or if `ptr` is not suitably aligned, or later,
+        from the reclaimer thread.
+    */
+    void defer(void* ptr, std::size_t count, std::size_t bytes, free_func free) noexcept;
+
+    /**
+        Blocks until the blocks deferred so far have been deallocated.
+    */
+    void drain();
+
+private:
+
+    struct _node
+    {
+        _node* next;
+        std::size_t count;
+        free_func free;
+    };
+
+    void _run();
+
+    // waits until `_wake_seq` differs from `seq`
+    void _wait(std::uint32_t seq);
+
+    // increments `_wake_seq` and wakes up the reclaimer thread
+    void _wake() noexcept;
+
+    const std::size_t _min_bytes;
+    std::atomic<_node*> _head{nullptr};
+    std::atomic<std::size_t> _pending{0};
+    std::atomic<bool> _stop{false};
+    std::atomic<std::uint32_t> _wake_seq{0};
+    std::mutex _mutex;
+    std::condition_variable _wake_up; // without futex
+    std::condition_variable _drained;
+    std::thread _thread;
+};
+
+/**
+    An allocator adaptor whose deallocations go through an
+    `api_string_reclaimer`. When used by `basic_string`, the memory of
+    the `basic_api_string` objects created from it is released by the
+    reclaimer thread:
+
+        using string = speudo_std::basic_string
+            < char, std::char_traits<char>, speudo_std::deferred_allocator<char> >;
+
+    `Allocator` must be stateless.
+*/
+template <typename T, typename Allocator = std::allocator<T>>
+class deferred_allocator
+{
+    using _traits = std::allocator_traits<Allocator>;
+
+    static_assert( _traits::is_always_equal::value
+                 , "deferred_allocator requires a stateless allocator" );
+
+public:
+
+    using value_type = T;
+    using size_type = typename _traits::size_type;
+    using difference_type = typename _traits::difference_type;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using is_always_equal = std::false_type;
+
+    template <typename U>
+    struct rebind
+    {
+        using other = speudo_std::deferred_allocator
+            < U, typename _traits::template rebind_alloc<U> >;
+    };
+
+    deferred_allocator() noexcept
+        : _reclaimer(&speudo_std::api_string_reclaimer::global())
+    {
+    }
+
+    explicit deferred_allocator(speudo_std::api_string_reclaimer& r) noexcept
+        : _reclaimer(&r)
+    {
+    }
+
+    template <typename U, typename A>
+    deferred_allocator(const deferred_allocator<U, A>& other) noexcept
+        : _reclaimer(&other.reclaimer())
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+        Allocator a;
+        return _traits::allocate(a, n);
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        _reclaimer->defer(p, n, n * sizeof(T), &deferred_allocator::_free);
+    }
+
+    speudo_std::api_string_reclaimer& reclaimer() const noexcept
+    {
+        return *_reclaimer;
+    }
+
+private:
+
+    static void _free(void* p, std::size_t n)
+    {
+        Allocator a;
+        _traits::deallocate(a, static_cast<T*>(p), n);
+    }
+
+    speudo_std::api_string_reclaimer* _reclaimer;
+};
+
+template <typename T, typename A, typename U, typename B>
+bool operator==(const deferred_allocator<T, A>& a, const deferred_allocator<U, B>& b) noexcept
+{
+    return &a.reclaimer() == &b.reclaimer();
+}
+
+template <typename T, typename A, typename U, typename B>
+bool operator!=(const deferred_allocator<T, A>& a, const deferred_allocator<U, B>& b) noexcept
+{
+    return &a.reclaimer() != &b.reclaimer();
+}
+
+} // namespace speudo_std
+
+#endif
@@ -0,0 +1,399 @@
+#ifndef SPEUDO_STD_API_STRING_SEARCHER_HPP
+#define SPEUDO_STD_API_STRING_SEARCHER_HPP
+
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <api_string.hpp>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace speudo_std {
+
+enum class searcher_algorithm
+{
+    empty,      ///< the needle is empty, hence found everywhere
+    simd,       ///< `find`, that filters with the first and last characters
+    horspool,   ///< Boyer-Moore-Horspool
+    two_way     ///< Crochemore-Perrin Two-Way, with a bad character shift
+};
+
+/**
+    A substring searcher, built once from a needle and then applied to
+    any number of haystacks. The algorithm depends on the length of the
+    needle:
+
+    - up to `simd_max_length` characters, the vectorized `find`, whose
+      cost is dominated by the scan of the haystack;
+    - up to `horspool_max_length` characters, Horspool, that skips up
+      to the whole needle length after each mismatch;
+    - beyond, Two-Way, whose worst case is linear, unlike Horspool's.
+
+    The tables are indexed by the low byte of the characters, so wider
+    characters that share a low byte get the shorter of their shifts.
+    The needle is held as a `basic_api_string`, which shares the memory
+    of the pattern when possible ( see `basic_api_string_view::to_api_string` ).
+
+    It can be used with `std::search`.
+*/
+template <typename CharT>
+class basic_api_string_searcher
+{
+public:
+
+    using size_type = std::size_t;
+
+    constexpr static size_type npos = static_cast<size_type>(-1);
+    constexpr static size_type simd_max_length = 32;
+    constexpr static size_type horspool_max_length = 256;
+
+    explicit basic_api_string_searcher(speudo_std::basic_api_string_view<CharT> needle);
+
+    const speudo_std::basic_api_string<CharT>& needle() const noexcept
+    {
+        return _needle;
+    }
+
+    speudo_std::searcher_algorithm algorithm() const noexcept
+    {
+        return _algorithm;
+    }
+
+    /**
+        The position of the first occurrence of the needle in `haystack`
+        at or after `pos`, or `npos`.
+    */
+    size_type find
+        ( speudo_std::basic_api_string_view<CharT> haystack
+        , size_type pos = 0 ) const noexcept;
+
+    bool found_in(speudo_std::basic_api_string_view<CharT> haystack) const noexcept
+    {
+        return find(haystack) != npos;
+    }
+
+    std::pair<const CharT*, const CharT*> operator()
+        ( const CharT* first
+        , const CharT* last ) const noexcept
+    {
+        size_type pos = find({first, static_cast<size_type>(last - first)});
+        if (pos == npos)
+        {
+            return {last, last};
+        }
+        return {first + pos, first + pos + _needle.size()};
+    }
+
+    /**
+        Searches the needle in each of the haystacks, and returns the
+        positions, in the same order. The haystacks are split among up to
+        `threads` threads ( by default, `std::thread::hardware_concurrency()` ),
+        each one taking at least `min_batch_per_thread` haystacks.
+    */
+    std::vector<size_type> find_in
+        ( const std::vector<speudo_std::basic_api_string<CharT>>& haystacks
+        , unsigned threads = 0 ) const;
+
+    constexpr static size_type min_batch_per_thread = 256;
+
+private:
+
+    static std::uint8_t _bucket(CharT ch) noexcept
+    {
+        return static_cast<std::uint8_t>(ch);
+    }
+
+    void _init_horspool() noexcept;
+    void _init_two_way() noexcept;
+
+    size_type _find_horspool(const CharT* str, size_type len, size_type pos) const noexcept;
+    size_type _find_two_way(const CharT* str, size_type len, size_type pos) const noexcept;
+
+    speudo_std::basic_api_string<CharT> _needle;
+    speudo_std::searcher_algorithm _algorithm;
+
+    // Horspool: the shift after the last character of the window.
+    // Two-Way: one plus the last position in the needle, or zero if absent.
+    size_type _shift[256];
+
+    // Two-Way: the critical factorization and the period
+    size_type _split = 0;
+    size_type _period = 0;
+    size_type _memory_after_shift = 0;
+};
+
+using api_string_searcher    = basic_api_string_searcher<char>;
+using api_u16string_searcher = basic_api_string_searcher<char16_t>;
+using api_u32string_searcher = basic_api_string_searcher<char32_t>;
+using api_wstring_searcher   = basic_api_string_searcher<wchar_t>;
+
+template <typename CharT>
+basic_api_string_searcher<CharT>::basic_api_string_searcher
+    ( speudo_std::basic_api_string_view<CharT> needle )
+    : _needle(needle.to_api_string())
+{
+    const size_type len = _needle.size();
+    if (len == 0)
+    {
+        _algorithm = speudo_std::searcher_algorithm::empty;
+    }
+    else if (len <= simd_max_length)
+    {
+        _algorithm = speudo_std::searcher_algorithm::simd;
+    }
+    else if (len <= horspool_max_length)
+    {
+        _algorithm = speudo_std::searcher_algorithm::horspool;
+        _init_horspool();
+    }
+    else
+    {
+        _algorithm = speudo_std::searcher_algorithm::two_way;
+        _init_two_way();
+    }
+}
+
+template <typename CharT>
+void basic_api_string_searcher<CharT>::_init_horspool() noexcept
+{
+    const CharT* x = _needle.data();
+    const size_type m = _needle.size();
+    std::fill(_shift, _shift + 256, m);
+    for (size_type i = 0; i + 1 < m; ++i)
+    {
+        _shift[_bucket(x[i])] = m - 1 - i;
+    }
+}
+
+template <typename CharT>
+void basic_api_string_searcher<CharT>::_init_two_way() noexcept
+{
+    const CharT* x = _needle.data();
+    const size_type m = _needle.size();
+
+    std::fill(_shift, _shift + 256, 0);
+    for (size_type i = 0; i < m; ++i)
+    {
+        _shift[_bucket(x[i])] = i + 1;
+    }
+
+    // The maximal suffixes for both orderings of the alphabet. The
+    // index `i` starts at -1, hence the unsigned wrap around.
+    auto maximal_suffix = [x, m](bool greater, size_type& period)
+    {
+        size_type i = npos, j = 0, k = 1;
+        period = 1;
+        while (j + k < m)
+        {
+            const CharT a = x[i + k];
+            const CharT b = x[j + k];
+            if (a == b)
+            {
+                if (k == period)
+                {
+                    j += period;
+                    k = 1;
+                }
+                else
+                {
+                    ++k;
+                }
+            }
+            else if (greater ? (a > b) : (a < b))
+            {
+                j += k;
+                k = 1;
+                period = j - i;
+            }
+            else
+            {
+                i = j++;
+                k = period = 1;
+            }
+        }
+        return i;
+    };
+    size_type period1, period2;
+    const size_type split1 = maximal_suffix(true, period1);
+    const size_type split2 = maximal_suffix(false, period2);
+    if (split2 + 1 > split1 + 1)
+    {
+        _split = split2;
+        _period = period2;
+    }
+    else
+    {
+        _split = split1;
+        _period = period1;
+    }
+
+    if (std::memcmp(x, x + _period, (_split + 1) * sizeof(CharT)) != 0)
+    {
+        // not periodic: no need to remember the matched prefix
+        _memory_after_shift = 0;
+        _period = std::max(_split + 1, m - _split - 1) + 1;
+    }
+    else
+    {
+        _memory_after_shift = m - _period;
+    }
+}
+
+template <typename CharT>
+typename basic_api_string_searcher<CharT>::size_type
+basic_api_string_searcher<CharT>::find
+    ( speudo_std::basic_api_string_view<CharT> haystack
+    , size_type pos ) const noexcept
+{
+    const size_type len = haystack.size();
+    const size_type m = _needle.size();
+    if (pos > len || m > len - pos)
+    {
+        return npos;
+    }
+    switch (_algorithm)
+    {
+        case speudo_std::searcher_algorithm::empty:
+            return pos;
+        case speudo_std::searcher_algorithm::simd:
+            return speudo_std::_detail::str_find(haystack.data(), len, _needle.data(), pos, m);
+        case speudo_std::searcher_algorithm::horspool:
+            return _find_horspool(haystack.data(), len, pos);
+        default:
+            return _find_two_way(haystack.data(), len, pos);
+    }
+}
+
+template <typename CharT>
+typename basic_api_string_searcher<CharT>::size_type
+basic_api_string_searcher<CharT>::_find_horspool
+    ( const CharT* str
+    , size_type len
+    , size_type pos ) const noexcept
+{
+    const CharT* x = _needle.data();
+    const size_type m = _needle.size();
+    const CharT last = x[m - 1];
+    for (size_type h = pos; h + m <= len; )
+    {
+        const CharT ch = str[h + m - 1];
+        if (ch == last && std::memcmp(str + h, x, (m - 1) * sizeof(CharT)) == 0)
+        {
+            return h;
+        }
+        h += _shift[_bucket(ch)];
+    }
+    return npos;
+}
+
+template <typename CharT>
+typename basic_api_string_searcher<CharT>::size_type
+basic_api_string_searcher<CharT>::_find_two_way
+    ( const CharT* str
+    , size_type len
+    , size_type pos ) const noexcept
+{
+    const CharT* x = _needle.data();
+    const size_type m = _needle.size();
+    size_type memory = 0; // the length of the prefix known to match
+    for (size_type h = pos; h + m <= len; )
+    {
+        // the bad character shift on the last character of the window
+        const CharT ch = str[h + m - 1];
+        const size_type shift = _shift[_bucket(ch)];
+        if (shift == 0)
+        {
+            h += m;
+            memory = 0;
+            continue;
+        }
+        if (shift != m)
+        {
+            h += std::max(m - shift, memory);
+            memory = 0;
+            continue;
+        }
+
+        // the right half
+        size_type k = std::max(_split + 1, memory);
+        while (k < m && x[k] == str[h + k])
+        {
+            ++k;
+        }
+        if (k < m)
+        {
+            h += k - _split;
+            memory = 0;
+            continue;
+        }
+
+        // the left half
+        k = _split + 1;
+        while (k > memory && x[k - 1] == str[h + k - 1])
+        {
+            --k;
+        }
+        if (k <= memory)
+        {
+            return h;
+        }
+        h += _period;
+        memory = _memory_after_shift;
+    }
+    return npos;
+}
+
+template <typename CharT>
+std::vector<typename basic_api_string_searcher<CharT>::size_type>
+basic_api_string_searcher<CharT>::find_in
+    ( const std::vector<speudo_std::basic_api_string<CharT>>& haystacks
+    , unsigned threads ) const
+{
+    const size_type count = haystacks.size();
+    std::vector<size_type> result(count);
+    auto work = [&](size_type begin, size_type end)
+    {
+        for (size_type i = begin; i < end; ++i)
+        {
+            result[i] = find(haystacks[i]);
+        }
+    };
+
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    const size_type max_threads = (count + min_batch_per_thread - 1) / min_batch_per_thread;
+    const size_type num_threads = std::max<size_type>(1, std::min<size_type>(threads, max_threads));
+    const size_type chunk = (count + num_threads - 1) / num_threads;
+
+    std::vector<std::thread> workers;
+    workers.reserve(num_threads - 1);
+    size_type begin = chunk;
+    try
+    {
+        for (; begin < count; begin += chunk)
+        {
+            workers.emplace_back(work, begin, std::min(begin + chunk, count));
+        }
+    }
+    catch (...)
+    {
+        // could not start a thread: do the remaining work here
+        work(begin, count);
+    }
+    work(0, std::min(chunk, count));
+    for (auto& w : workers)
+    {
+        w.join();
+    }
+    return result;
+}
+
+} // namespace speudo_std
+
+#endif
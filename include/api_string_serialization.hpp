@@ -0,0 +1,269 @@
+#ifndef SPEUDO_STD_API_STRING_SERIALIZATION_HPP
+#define SPEUDO_STD_API_STRING_SERIALIZATION_HPP
+
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <string.hpp>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <unordered_map>
+#include <vector>
+
+namespace speudo_std {
+
+/**
+    The binary format:
+
+    - a 16 bytes header ( see `api_string_archive_header` ).
+    - `count` records. Each record starts with a 64 bits word:
+    ..- if the most significant bit is not set, the word is the length
+        of the string ( in code units ), and it is followed by the
+        characters, the null terminator, and zero padding up to the
+        next multiple of 8 bytes.
+    ..- otherwise, the record is a back reference to an identical
+        string previously written: the remaining bits are the offset
+        ( from the beginning of the buffer ) of its characters.
+
+    All integers are in the native byte order. Since every record is
+    8 bytes aligned, the strings can be referenced directly from a buffer
+    that is itself 8 bytes aligned, which is the case of the memory
+    allocated by `basic_string` and of `map_file`.
+*/
+namespace _detail {
+
+struct api_string_archive_header
+{
+    char magic[4];
+    std::uint8_t version;
+    std::uint8_t char_size;
+    std::uint16_t byte_order;
+    std::uint64_t count;
+};
+
+static_assert(sizeof(api_string_archive_header) == 16);
+
+constexpr std::uint64_t api_string_archive_ref_bit = std::uint64_t(1) << 63;
+constexpr std::size_t api_string_archive_alignment = 8;
+constexpr std::uint16_t api_string_archive_byte_order = 0x0102;
+
+constexpr std::size_t api_string_archive_padded(std::size_t bytes)
+{
+    return (bytes + api_string_archive_alignment - 1)
+        & ~(api_string_archive_alignment - 1);
+}
+
+} // namespace _detail
+
+/**
+    Writes the strings in range `[first, last)` in the format described
+    above. `sink` is called as `sink(const char* bytes, std::size_t count)`.
+
+    When `deduplicate` is true, each repeated string is written as a
+    back reference to its first occurrence.
+*/
+template <typename ForwardIt, typename Sink>
+void write_api_strings
+    ( ForwardIt first
+    , ForwardIt last
+    , Sink&& sink
+    , bool deduplicate = false )
+{
+    using string_type = typename std::iterator_traits<ForwardIt>::value_type;
+    using char_type = typename string_type::value_type;
+    using view_type = std::basic_string_view<char_type>;
+
+    speudo_std::_detail::api_string_archive_header header =
+        { {'A', 'P', 'S', 'S'}
+        , 1
+        , sizeof(char_type)
+        , speudo_std::_detail::api_string_archive_byte_order
+        , static_cast<std::uint64_t>(std::distance(first, last)) };
+    sink(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    static const char zeros[16] = {};
+    std::uint64_t pos = sizeof(header);
+    std::unordered_map<view_type, std::uint64_t> seen;
+
+    for (; first != last; ++first)
+    {
+        const char_type* str = first->data();
+        std::size_t len = first->size();
+        std::uint64_t word = len;
+        if (deduplicate)
+        {
+            auto r = seen.emplace(view_type{str, len}, pos + sizeof(word));
+            if ( ! r.second)
+            {
+                word = speudo_std::_detail::api_string_archive_ref_bit | r.first->second;
+                sink(reinterpret_cast<const char*>(&word), sizeof(word));
+                pos += sizeof(word);
+                continue;
+            }
+        }
+        std::size_t bytes = len * sizeof(char_type);
+        std::size_t padded = speudo_std::_detail::api_string_archive_padded
+            ( bytes + sizeof(char_type) );
+        sink(reinterpret_cast<const char*>(&word), sizeof(word));
+        sink(reinterpret_cast<const char*>(str), bytes);
+        sink(zeros, padded - bytes);
+        pos += sizeof(word) + padded;
+    }
+}
+
+/**
+    Serializes the strings in range `[first, last)` into a newly
+    allocated buffer.
+*/
+template <typename ForwardIt>
+speudo_std::api_string serialize_api_strings
+    ( ForwardIt first
+    , ForwardIt last
+    , bool deduplicate = false )
+{
+    speudo_std::string buffer;
+    speudo_std::write_api_strings
+        ( first, last
+        , [&buffer](const char* bytes, std::size_t count)
+          {
+              buffer.append(bytes, count);
+          }
+        , deduplicate );
+    // not redundant before C++20 ( see `edit` in string.hpp )
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wredundant-move"
+#endif
+    return std::move(buffer);
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+}
+
+/**
+    Reads the strings serialized in `buffer` and writes them into `out`.
+
+    The strings do not copy the characters, unless they fit in the small
+    string optimization. Instead they reference `buffer`'s memory and
+    share its reference counter. If `buffer` is not managed ( i.e. it was
+    created by `api_string_ref` ), neither are the strings.
+
+    Throws `std::invalid_argument` if the content is malformed, or if
+    `buffer.data()` is not 8 bytes aligned.
+*/
+template <typename CharT, typename OutputIt>
+OutputIt deserialize_api_strings(const speudo_std::api_string& buffer, OutputIt out);
+
+template <typename CharT>
+std::vector<speudo_std::basic_api_string<CharT>>
+deserialize_api_strings(const speudo_std::api_string& buffer)
+{
+    std::vector<speudo_std::basic_api_string<CharT>> v;
+    speudo_std::_detail::api_string_archive_header header;
+    if (buffer.size() >= sizeof(header))
+    {
+        std::memcpy(&header, buffer.data(), sizeof(header));
+        std::uint64_t max_count = buffer.size() / sizeof(std::uint64_t);
+        v.reserve(header.count < max_count ? header.count : max_count);
+    }
+    speudo_std::deserialize_api_strings<CharT>(buffer, std::back_inserter(v));
+    return v;
+}
+
+template <typename CharT, typename OutputIt>
+OutputIt deserialize_api_strings(const speudo_std::api_string& buffer, OutputIt out)
+{
+    using data_type = speudo_std::abi::api_string_data<CharT>;
+    using speudo_std::_detail::throw_std_invalid_argument;
+    constexpr std::uint64_t ref_bit = speudo_std::_detail::api_string_archive_ref_bit;
+
+    const char* base = buffer.data();
+    const std::size_t size = buffer.size();
+    speudo_std::_detail::api_string_archive_header header;
+
+    if ( size < sizeof(header)
+      || reinterpret_cast<std::uintptr_t>(base)
+         % speudo_std::_detail::api_string_archive_alignment != 0 )
+    {
+        throw_std_invalid_argument("deserialize_api_strings: invalid buffer");
+    }
+    std::memcpy(&header, base, sizeof(header));
+    if ( std::memcmp(header.magic, "APSS", 4) != 0
+      || header.version != 1
+      || header.char_size != sizeof(CharT)
+      || header.byte_order != speudo_std::_detail::api_string_archive_byte_order )
+    {
+        throw_std_invalid_argument("deserialize_api_strings: invalid header");
+    }
+
+    auto* manager = speudo_std::_detail::basic_string_helper::get_data(buffer).big.mem_manager;
+    std::size_t pos = sizeof(header);
+
+    for (std::uint64_t i = 0; i < header.count; ++i)
+    {
+        std::uint64_t word;
+        if (size - pos < sizeof(word))
+        {
+            throw_std_invalid_argument("deserialize_api_strings: truncated buffer");
+        }
+        std::memcpy(&word, base + pos, sizeof(word));
+        pos += sizeof(word);
+
+        std::size_t payload;
+        std::uint64_t len;
+        if (word & ref_bit)
+        {
+            payload = static_cast<std::size_t>(word & ~ref_bit);
+            if ( payload < sizeof(header) + sizeof(word)
+              || payload % speudo_std::_detail::api_string_archive_alignment != 0
+              || payload >= pos - sizeof(word) )
+            {
+                throw_std_invalid_argument("deserialize_api_strings: invalid reference");
+            }
+            std::memcpy(&len, base + payload - sizeof(len), sizeof(len));
+            if ( (len & ref_bit)
+              || len >= (pos - sizeof(word) - payload) / sizeof(CharT) )
+            {
+                throw_std_invalid_argument("deserialize_api_strings: invalid reference");
+            }
+        }
+        else
+        {
+            len = word;
+            payload = pos;
+            if (len >= (size - pos) / sizeof(CharT))
+            {
+                throw_std_invalid_argument("deserialize_api_strings: truncated buffer");
+            }
+            std::size_t padded = speudo_std::_detail::api_string_archive_padded
+                ( (len + 1) * sizeof(CharT) );
+            pos += padded <= size - pos ? padded : size - pos;
+        }
+
+        const CharT* str = reinterpret_cast<const CharT*>(base + payload);
+        if (str[len] != CharT{})
+        {
+            throw_std_invalid_argument("deserialize_api_strings: missing null terminator");
+        }
+        if (len <= data_type::small_capacity())
+        {
+            *out = speudo_std::basic_api_string<CharT>(str, len);
+        }
+        else
+        {
+            if (manager != nullptr)
+            {
+                manager->acquire();
+            }
+            *out = speudo_std::_detail::basic_string_helper::adopt(manager, str, len);
+        }
+        ++out;
+    }
+    return out;
+}
+
+} // namespace speudo_std
+
+#endif
@@ -0,0 +1,225 @@
+#ifndef SPEUDO_STD_API_STRING_SHM_HPP
+#define SPEUDO_STD_API_STRING_SHM_HPP
+
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <detail/api_string_memory.hpp>
+#include <cstdint>
+#include <string_view> // char_traits
+
+namespace speudo_std {
+
+namespace _detail {
+
+struct shm_segment_state;
+
+speudo_std::_detail::shm_segment_state* shm_create(std::size_t size, const char* name);
+speudo_std::_detail::shm_segment_state* shm_open(const char* name);
+speudo_std::_detail::shm_segment_state* shm_attach(int fd);
+void shm_unlink(const char* name);
+
+void shm_add_ref(speudo_std::_detail::shm_segment_state*);
+void shm_release(speudo_std::_detail::shm_segment_state*);
+int shm_fd(const speudo_std::_detail::shm_segment_state*);
+std::size_t shm_size(const speudo_std::_detail::shm_segment_state*);
+
+/**
+    Allocates a block in the segment and copies `len * char_size` bytes
+    from `src` followed by a null character.
+    Returns the manager of the block and sets `*str` to its content.
+*/
+speudo_std::abi::api_string_mem_base* shm_make
+    ( speudo_std::_detail::shm_segment_state*
+    , const void* src
+    , std::size_t len
+    , std::size_t char_size
+    , void** str );
+
+/**
+    Adds a reference to the block managed by `manager`, if it belongs to
+    the segment. Otherwise, copies `str` into a new block.
+    Returns the handle of the block.
+*/
+std::uint64_t shm_share
+    ( speudo_std::_detail::shm_segment_state*
+    , speudo_std::abi::api_string_mem_base* manager
+    , const void* str
+    , std::size_t len
+    , std::size_t char_size );
+
+speudo_std::abi::api_string_mem_base* shm_adopt
+    ( speudo_std::_detail::shm_segment_state*
+    , std::uint64_t handle
+    , std::size_t char_size
+    , const void** str
+    , std::size_t* len );
+
+void shm_discard(speudo_std::_detail::shm_segment_state*, std::uint64_t handle);
+
+} // namespace _detail
+
+/**
+    A POSIX shared memory segment where strings can be allocated,
+    in order to pass them to other processes on the same host without
+    copying them.
+
+    The reference counter of each string lives in the segment and is
+    updated atomically by all processes. `share` returns a handle ( the
+    offset of the string in the segment ) that carries one reference,
+    which is taken over by `adopt` in the receiving process. Each
+    process accesses the memory through its own mapping of the segment,
+    which is kept alive by the strings that reference it.
+
+    A segment can be created with a name ( `shm_open` ), or anonymously
+    ( `memfd_create` ), in which case its file descriptor has to be sent
+    to the other processes ( for example with `SCM_RIGHTS` ) and attached
+    with `attach`.
+
+    Throws `std::system_error` when the segment cannot be created or
+    mapped, `std::bad_alloc` when it is full, and `std::invalid_argument`
+    when a handle is invalid.
+*/
+class api_string_shm_segment
+{
+public:
+
+    using handle_type = std::uint64_t;
+
+    /**
+        Creates a new segment of `size` bytes. If `name` is null,
+        the segment is anonymous.
+    */
+    static api_string_shm_segment create(std::size_t size, const char* name = nullptr)
+    {
+        return api_string_shm_segment{speudo_std::_detail::shm_create(size, name)};
+    }
+
+    /**
+        Opens a segment created by another process
+    */
+    static api_string_shm_segment open(const char* name)
+    {
+        return api_string_shm_segment{speudo_std::_detail::shm_open(name)};
+    }
+
+    /**
+        Maps the segment referred by `fd`, taking ownership of `fd`.
+    */
+    static api_string_shm_segment attach(int fd)
+    {
+        return api_string_shm_segment{speudo_std::_detail::shm_attach(fd)};
+    }
+
+    static void unlink(const char* name)
+    {
+        speudo_std::_detail::shm_unlink(name);
+    }
+
+    api_string_shm_segment(const api_string_shm_segment& other) noexcept
+        : _state(other._state)
+    {
+        speudo_std::_detail::shm_add_ref(_state);
+    }
+
+    api_string_shm_segment& operator=(const api_string_shm_segment& other) noexcept
+    {
+        speudo_std::_detail::shm_add_ref(other._state);
+        speudo_std::_detail::shm_release(_state);
+        _state = other._state;
+        return *this;
+    }
+
+    ~api_string_shm_segment()
+    {
+        speudo_std::_detail::shm_release(_state);
+    }
+
+    int fd() const noexcept
+    {
+        return speudo_std::_detail::shm_fd(_state);
+    }
+
+    std::size_t size() const noexcept
+    {
+        return speudo_std::_detail::shm_size(_state);
+    }
+
+    /**
+        Creates a string whose content is allocated in the segment
+    */
+    template <typename CharT>
+    speudo_std::basic_api_string<CharT> make_string(const CharT* str, std::size_t len)
+    {
+        void* dest;
+        auto* manager = speudo_std::_detail::shm_make(_state, str, len, sizeof(CharT), &dest);
+        return speudo_std::_detail::basic_string_helper::adopt
+            ( manager, static_cast<const CharT*>(dest), len );
+    }
+
+    template <typename CharT>
+    speudo_std::basic_api_string<CharT> make_string(const CharT* str)
+    {
+        return make_string(str, std::char_traits<CharT>::length(str));
+    }
+
+    /**
+        Returns a handle that can be passed to another process.
+        If `s` was not created in this segment, its content is copied
+        into it. The handle must be either adopted or discarded once.
+    */
+    template <typename CharT>
+    handle_type share(const speudo_std::basic_api_string<CharT>& s)
+    {
+        const auto& d = speudo_std::_detail::basic_string_helper::get_data(s);
+        return speudo_std::_detail::shm_share
+            ( _state
+            , d.big.str != nullptr ? d.big.mem_manager : nullptr
+            , s.data()
+            , s.size()
+            , sizeof(CharT) );
+    }
+
+    /**
+        Creates a string that references the content of the string
+        identified by `handle`, and takes over the reference it carries.
+    */
+    template <typename CharT>
+    speudo_std::basic_api_string<CharT> adopt(handle_type handle)
+    {
+        const void* str;
+        std::size_t len;
+        auto* manager = speudo_std::_detail::shm_adopt
+            ( _state, handle, sizeof(CharT), &str, &len );
+        const CharT* chars = static_cast<const CharT*>(str);
+        if (len <= speudo_std::abi::api_string_data<CharT>::small_capacity())
+        {
+            speudo_std::basic_api_string<CharT> s{chars, len};
+            manager->release();
+            return s;
+        }
+        return speudo_std::_detail::basic_string_helper::adopt(manager, chars, len);
+    }
+
+    /**
+        Releases the reference carried by a handle that is not going to be adopted
+    */
+    void discard(handle_type handle)
+    {
+        speudo_std::_detail::shm_discard(_state, handle);
+    }
+
+private:
+
+    explicit api_string_shm_segment(speudo_std::_detail::shm_segment_state* state)
+        : _state(state)
+    {
+    }
+
+    speudo_std::_detail::shm_segment_state* _state;
+};
+
+} // namespace speudo_std
+
+#endif
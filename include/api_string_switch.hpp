@@ -0,0 +1,246 @@
+#ifndef SPEUDO_STD_API_STRING_SWITCH_HPP
+#define SPEUDO_STD_API_STRING_SWITCH_HPP
+
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <api_string.hpp>
+#include <detail/api_string_hash.hpp>
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+namespace speudo_std {
+
+/**
+    Maps a fixed set of strings, known at compile time, to their indexes,
+    using a perfect hash function computed at compile time ( by the
+    "hash, displace and compress" method ). A lookup hashes the string
+    once, reads one displacement and one slot, and then compares the
+    string with the single candidate.
+
+    Usually created with `make_api_string_switch`:
+
+        constexpr auto methods = speudo_std::make_api_string_switch("GET", "PUT", "POST");
+        switch (methods(s)) {
+            case methods.index("GET"): ...
+            case methods.index("PUT"): ...
+            case methods.npos: ...
+        }
+
+    The construction fails to compile ( when constant evaluated ) if
+    the strings are not distinct.
+*/
+template <typename CharT, std::size_t N>
+class basic_api_string_switch
+{
+    static_assert(N > 0, "basic_api_string_switch needs at least one string");
+
+    static constexpr std::size_t _slots_count()
+    {
+        std::size_t s = 1;
+        while (s < 2 * N)
+        {
+            s *= 2;
+        }
+        return s;
+    }
+
+    constexpr static std::size_t _mask = _slots_count() - 1;
+    constexpr static std::uint32_t _max_displacement = 1 << 20;
+
+public:
+
+    using view_type = std::basic_string_view<CharT>;
+
+    constexpr static std::size_t npos = static_cast<std::size_t>(-1);
+
+    constexpr explicit basic_api_string_switch(const std::array<view_type, N>& strings);
+
+    constexpr std::size_t size() const noexcept
+    {
+        return N;
+    }
+
+    constexpr const view_type& operator[](std::size_t i) const noexcept
+    {
+        return _strings[i];
+    }
+
+    /**
+        Returns the index of the string, or `npos` if it is not in the set
+    */
+    constexpr std::size_t operator()(const CharT* str, std::size_t len) const noexcept;
+
+    constexpr std::size_t operator()(view_type str) const noexcept
+    {
+        return (*this)(str.data(), str.size());
+    }
+
+    template
+        < typename String
+        , std::enable_if_t
+            < std::is_same_v<String, speudo_std::basic_api_string<CharT>>
+            , int > = 0 >
+    constexpr std::size_t operator()(const String& str) const noexcept
+    {
+        return (*this)(str.data(), str.size());
+    }
+
+    /**
+        Same as `operator()`, but fails to compile ( when constant evaluated )
+        if the string is not in the set. Meant for `case` labels.
+    */
+    constexpr std::size_t index(view_type str) const
+    {
+        std::size_t i = (*this)(str.data(), str.size());
+        if (i == npos)
+        {
+            speudo_std::_detail::throw_std_invalid_argument
+                ( "basic_api_string_switch: string not in the set" );
+        }
+        return i;
+    }
+
+private:
+
+    constexpr static std::size_t _bucket(std::uint64_t h) noexcept
+    {
+        return static_cast<std::size_t>((h >> 32) % N);
+    }
+
+    constexpr static std::size_t _slot(std::uint64_t h, std::uint32_t displacement) noexcept
+    {
+        // the finalizer of splitmix64
+        std::uint64_t x = h + (displacement + 1) * 0x9e3779b97f4a7c15;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+        return static_cast<std::size_t>(x ^ (x >> 31)) & _mask;
+    }
+
+    std::array<view_type, N> _strings{};
+    std::array<std::uint32_t, N> _displacements{};
+    std::array<std::size_t, _slots_count()> _slots{};
+};
+
+template <typename CharT, std::size_t N>
+constexpr basic_api_string_switch<CharT, N>::basic_api_string_switch
+    ( const std::array<view_type, N>& strings )
+    : _strings(strings)
+{
+    std::array<std::uint64_t, N> hashes{};
+    std::array<std::size_t, N> bucket_sizes{};
+    for (std::size_t i = 0; i < N; ++i)
+    {
+        hashes[i] = speudo_std::_detail::fnv1a_hash(strings[i].data(), strings[i].size());
+        ++bucket_sizes[_bucket(hashes[i])];
+        for (std::size_t j = 0; j < i; ++j)
+        {
+            if (strings[i] == strings[j])
+            {
+                speudo_std::_detail::throw_std_invalid_argument
+                    ( "basic_api_string_switch: duplicated string" );
+            }
+        }
+    }
+    for (auto& s : _slots)
+    {
+        s = npos;
+    }
+
+    // place the largest buckets first
+    std::array<std::size_t, N> members{};
+    std::array<std::size_t, _slots_count()> candidate{};
+    for (std::size_t placed = 0; placed < N; )
+    {
+        std::size_t b = 0;
+        for (std::size_t i = 1; i < N; ++i)
+        {
+            if (bucket_sizes[i] > bucket_sizes[b])
+            {
+                b = i;
+            }
+        }
+        std::size_t count = 0;
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            if (_bucket(hashes[i]) == b)
+            {
+                members[count++] = i;
+            }
+        }
+        std::uint32_t d = 0;
+        for (; ; ++d)
+        {
+            if (d == _max_displacement)
+            {
+                speudo_std::_detail::throw_std_invalid_argument
+                    ( "basic_api_string_switch: failed to find a perfect hash" );
+            }
+            bool ok = true;
+            for (std::size_t k = 0; ok && k < count; ++k)
+            {
+                candidate[k] = _slot(hashes[members[k]], d);
+                ok = _slots[candidate[k]] == npos;
+                for (std::size_t l = 0; ok && l < k; ++l)
+                {
+                    ok = candidate[l] != candidate[k];
+                }
+            }
+            if (ok)
+            {
+                break;
+            }
+        }
+        _displacements[b] = d;
+        for (std::size_t k = 0; k < count; ++k)
+        {
+            _slots[candidate[k]] = members[k];
+        }
+        placed += count;
+        bucket_sizes[b] = 0;
+    }
+}
+
+template <typename CharT, std::size_t N>
+constexpr std::size_t basic_api_string_switch<CharT, N>::operator()
+    ( const CharT* str
+    , std::size_t len ) const noexcept
+{
+    std::uint64_t h = speudo_std::_detail::fnv1a_hash(str, len);
+    std::size_t i = _slots[_slot(h, _displacements[_bucket(h)])];
+    if ( i != npos
+      && _strings[i].size() == len
+      && std::char_traits<CharT>::compare(_strings[i].data(), str, len) == 0 )
+    {
+        return i;
+    }
+    return npos;
+}
+
+template <typename CharT, std::size_t... L>
+constexpr basic_api_string_switch<CharT, sizeof...(L)>
+make_api_string_switch(const CharT (&... strings)[L])
+{
+    return basic_api_string_switch<CharT, sizeof...(L)>
+        ( std::array<std::basic_string_view<CharT>, sizeof...(L)>
+            { { std::basic_string_view<CharT>(strings, L - 1)... } } );
+}
+
+template <typename CharT, std::size_t N>
+constexpr basic_api_string_switch<CharT, N>
+make_api_string_switch(const std::array<std::basic_string_view<CharT>, N>& strings)
+{
+    return basic_api_string_switch<CharT, N>(strings);
+}
+
+template <std::size_t N> using api_string_switch    = basic_api_string_switch<char, N>;
+template <std::size_t N> using api_u16string_switch = basic_api_string_switch<char16_t, N>;
+template <std::size_t N> using api_u32string_switch = basic_api_string_switch<char32_t, N>;
+template <std::size_t N> using api_wstring_switch   = basic_api_string_switch<wchar_t, N>;
+
+} // namespace speudo_std
+
+#endif
@@ -0,0 +1,362 @@
+#ifndef SPEUDO_STD_API_STRING_TABLE_HPP
+#define SPEUDO_STD_API_STRING_TABLE_HPP
+
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <string.hpp>
+#include <detail/api_string_hash.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+namespace speudo_std {
+
+/**
+    The binary format of a string table:
+
+    - a 16 bytes header ( see `api_string_table_header` ).
+    - `count` entries of 16 bytes: the offset ( from the beginning of the
+      buffer ) and the length ( in code units ) of each string, in
+      lexicographical order.
+    - `bucket_count` buckets of 8 bytes: the 32 most significant bits of
+      the hash of a string, followed by its index plus one ( zero for an
+      empty bucket ). `bucket_count` is a power of two and collisions are
+      resolved by linear probing.
+    - the characters of the strings, each one followed by a null terminator.
+
+    All integers are in the native byte order. The hash is the 64 bits
+    FNV-1a of the code units, so that the table does not depend on the
+    standard library that built it.
+*/
+namespace _detail {
+
+struct api_string_table_header
+{
+    char magic[4];
+    std::uint8_t version;
+    std::uint8_t char_size;
+    std::uint16_t byte_order;
+    std::uint32_t count;
+    std::uint32_t bucket_count;
+};
+
+struct api_string_table_entry
+{
+    std::uint64_t offset;
+    std::uint64_t length;
+};
+
+struct api_string_table_bucket
+{
+    std::uint32_t hash;
+    std::uint32_t index;
+};
+
+static_assert(sizeof(api_string_table_header) == 16);
+static_assert(sizeof(api_string_table_entry) == 16);
+static_assert(sizeof(api_string_table_bucket) == 8);
+
+constexpr std::uint16_t api_string_table_byte_order = 0x0102;
+
+/**
+    Keeps a reference to `s` that is never released.
+*/
+inline void make_api_string_immortal(const speudo_std::api_string& s)
+{
+    static std::mutex mtx;
+    // never destroyed, so that the strings stay valid in the destructors
+    // of the objects with static storage duration
+    static auto* immortals = new std::vector<speudo_std::api_string>;
+    std::lock_guard<std::mutex> lock(mtx);
+    immortals->push_back(s);
+}
+
+} // namespace _detail
+
+/**
+    Writes a table of the distinct strings in range `[first, last)` in the
+    format described above. `sink` is called as
+    `sink(const char* bytes, std::size_t count)`.
+*/
+template <typename ForwardIt, typename Sink>
+void write_api_string_table(ForwardIt first, ForwardIt last, Sink&& sink)
+{
+    using string_type = typename std::iterator_traits<ForwardIt>::value_type;
+    using char_type = typename string_type::value_type;
+    using view_type = std::basic_string_view<char_type>;
+
+    std::vector<view_type> strings;
+    for (; first != last; ++first)
+    {
+        strings.emplace_back(first->data(), first->size());
+    }
+    std::sort(strings.begin(), strings.end());
+    strings.erase(std::unique(strings.begin(), strings.end()), strings.end());
+
+    std::uint32_t bucket_count = 1;
+    while (bucket_count < 2 * strings.size())
+    {
+        bucket_count *= 2;
+    }
+    std::vector<speudo_std::_detail::api_string_table_bucket> buckets(bucket_count);
+    std::vector<speudo_std::_detail::api_string_table_entry> entries;
+    entries.reserve(strings.size());
+
+    std::uint64_t pos
+        = sizeof(speudo_std::_detail::api_string_table_header)
+        + strings.size() * sizeof(speudo_std::_detail::api_string_table_entry)
+        + bucket_count * sizeof(speudo_std::_detail::api_string_table_bucket);
+
+    for (std::size_t i = 0; i < strings.size(); ++i)
+    {
+        entries.push_back({pos, strings[i].size()});
+        pos += (strings[i].size() + 1) * sizeof(char_type);
+
+        std::uint64_t h = speudo_std::_detail::fnv1a_hash
+            ( strings[i].data(), strings[i].size() );
+        std::size_t b = h & (bucket_count - 1);
+        while (buckets[b].index != 0)
+        {
+            b = (b + 1) & (bucket_count - 1);
+        }
+        buckets[b] = {static_cast<std::uint32_t>(h >> 32), static_cast<std::uint32_t>(i + 1)};
+    }
+
+    speudo_std::_detail::api_string_table_header header =
+        { {'A', 'P', 'S', 'T'}
+        , 1
+        , sizeof(char_type)
+        , speudo_std::_detail::api_string_table_byte_order
+        , static_cast<std::uint32_t>(strings.size())
+        , bucket_count };
+    sink(reinterpret_cast<const char*>(&header), sizeof(header));
+    sink( reinterpret_cast<const char*>(entries.data())
+        , entries.size() * sizeof(entries[0]) );
+    sink( reinterpret_cast<const char*>(buckets.data())
+        , buckets.size() * sizeof(buckets[0]) );
+
+    const char_type zero{};
+    for (const auto& s : strings)
+    {
+        sink(reinterpret_cast<const char*>(s.data()), s.size() * sizeof(char_type));
+        sink(reinterpret_cast<const char*>(&zero), sizeof(zero));
+    }
+}
+
+/**
+    Writes the table of the distinct strings in range `[first, last)`
+    into a newly allocated buffer.
+*/
+template <typename ForwardIt>
+speudo_std::api_string make_api_string_table(ForwardIt first, ForwardIt last)
+{
+    speudo_std::string buffer;
+    speudo_std::write_api_string_table
+        ( first, last
+        , [&buffer](const char* bytes, std::size_t count)
+          {
+              buffer.append(bytes, count);
+          } );
+    // converted without copy only through an explicit move in C++17
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wredundant-move"
+#endif
+    return std::move(buffer);
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+}
+
+/**
+    A read-only view of a string table written by `write_api_string_table`.
+    Typically the buffer is a memory-mapped file ( see `map_file` ), so that
+    the table is ready to use without any parsing or allocation.
+
+    The constructor only checks the header. The strings returned by the
+    table are not managed: they reference the buffer directly, without
+    touching any reference counter, and so must not outlive the table,
+    unless it is made immortal ( see `make_immortal` ). Copying a string
+    table is cheap and keeps the buffer alive.
+*/
+template <typename CharT>
+class basic_api_string_table
+{
+public:
+
+    using value_type = speudo_std::basic_api_string<CharT>;
+    using size_type = std::size_t;
+
+    constexpr static size_type npos = static_cast<size_type>(-1);
+
+    /**
+        Throws `std::invalid_argument` if the header is malformed, or if
+        `buffer.data()` is not 8 bytes aligned.
+    */
+    explicit basic_api_string_table(speudo_std::api_string buffer);
+
+    size_type size() const noexcept
+    {
+        return _count;
+    }
+
+    bool empty() const noexcept
+    {
+        return _count == 0;
+    }
+
+    /**
+        Returns the `i`-th string in lexicographical order.
+        Throws `std::invalid_argument` if its entry is corrupted.
+    */
+    speudo_std::basic_api_string<CharT> operator[](size_type i) const;
+
+    /**
+        Returns the index of string `str`, or `npos` if not found.
+    */
+    size_type find(const CharT* str, std::size_t len) const;
+
+    size_type find(const speudo_std::basic_api_string<CharT>& str) const
+    {
+        return find(str.data(), str.size());
+    }
+
+    bool contains(const CharT* str, std::size_t len) const
+    {
+        return find(str, len) != npos;
+    }
+
+    bool contains(const speudo_std::basic_api_string<CharT>& str) const
+    {
+        return find(str.data(), str.size()) != npos;
+    }
+
+    const speudo_std::api_string& buffer() const noexcept
+    {
+        return _buffer;
+    }
+
+    /**
+        Keeps the buffer alive until the end of the program, so that the
+        strings returned by the table ( and by its copies ) are immortal
+        references, that can be stored anywhere. Intended for the tables
+        loaded once, at startup.
+    */
+    void make_immortal() const
+    {
+        speudo_std::_detail::make_api_string_immortal(_buffer);
+    }
+
+private:
+
+    speudo_std::api_string _buffer;
+    const speudo_std::_detail::api_string_table_entry* _entries;
+    const speudo_std::_detail::api_string_table_bucket* _buckets;
+    std::size_t _count;
+    std::size_t _bucket_mask;
+
+    std::basic_string_view<CharT> _view(size_type i) const;
+};
+
+template <typename CharT>
+basic_api_string_table<CharT>::basic_api_string_table(speudo_std::api_string buffer)
+    : _buffer(std::move(buffer))
+{
+    using speudo_std::_detail::throw_std_invalid_argument;
+    const char* base = _buffer.data();
+    const std::size_t size = _buffer.size();
+    speudo_std::_detail::api_string_table_header header;
+
+    if ( size < sizeof(header)
+      || reinterpret_cast<std::uintptr_t>(base) % alignof(std::uint64_t) != 0 )
+    {
+        throw_std_invalid_argument("basic_api_string_table: invalid buffer");
+    }
+    std::memcpy(&header, base, sizeof(header));
+    if ( std::memcmp(header.magic, "APST", 4) != 0
+      || header.version != 1
+      || header.char_size != sizeof(CharT)
+      || header.byte_order != speudo_std::_detail::api_string_table_byte_order
+      || header.bucket_count == 0
+      || (header.bucket_count & (header.bucket_count - 1)) != 0
+      || header.bucket_count <= header.count
+      || ( size - sizeof(header) ) / sizeof(*_entries) < header.count
+      || ( size - sizeof(header) - header.count * sizeof(*_entries) )
+         / sizeof(*_buckets) < header.bucket_count )
+    {
+        throw_std_invalid_argument("basic_api_string_table: invalid header");
+    }
+    _entries = reinterpret_cast<const speudo_std::_detail::api_string_table_entry*>
+        ( base + sizeof(header) );
+    _buckets = reinterpret_cast<const speudo_std::_detail::api_string_table_bucket*>
+        ( _entries + header.count );
+    _count = header.count;
+    _bucket_mask = header.bucket_count - 1;
+}
+
+template <typename CharT>
+std::basic_string_view<CharT> basic_api_string_table<CharT>::_view(size_type i) const
+{
+    const auto& e = _entries[i];
+    const std::size_t size = _buffer.size();
+    if ( e.offset % sizeof(CharT) != 0
+      || e.offset > size
+      || e.length >= (size - e.offset) / sizeof(CharT) )
+    {
+        speudo_std::_detail::throw_std_invalid_argument("basic_api_string_table: invalid entry");
+    }
+    const CharT* str = reinterpret_cast<const CharT*>(_buffer.data() + e.offset);
+    if (str[e.length] != CharT{})
+    {
+        speudo_std::_detail::throw_std_invalid_argument("basic_api_string_table: missing null terminator");
+    }
+    return {str, static_cast<std::size_t>(e.length)};
+}
+
+template <typename CharT>
+speudo_std::basic_api_string<CharT> basic_api_string_table<CharT>::operator[](size_type i) const
+{
+    auto v = _view(i);
+    return speudo_std::_detail::basic_string_helper::adopt<CharT>(nullptr, v.data(), v.size());
+}
+
+template <typename CharT>
+typename basic_api_string_table<CharT>::size_type
+basic_api_string_table<CharT>::find(const CharT* str, std::size_t len) const
+{
+    std::uint64_t h = speudo_std::_detail::fnv1a_hash(str, len);
+    const auto h32 = static_cast<std::uint32_t>(h >> 32);
+    std::size_t b = h & _bucket_mask;
+    for (std::size_t probes = 0; probes <= _bucket_mask; ++probes, b = (b + 1) & _bucket_mask)
+    {
+        const auto& bucket = _buckets[b];
+        if (bucket.index == 0 || bucket.index > _count)
+        {
+            return npos;
+        }
+        if (bucket.hash == h32)
+        {
+            auto v = _view(bucket.index - 1);
+            if (v.size() == len && std::char_traits<CharT>::compare(v.data(), str, len) == 0)
+            {
+                return bucket.index - 1;
+            }
+        }
+    }
+    return npos;
+}
+
+using api_string_table    = basic_api_string_table<char>;
+using api_u16string_table = basic_api_string_table<char16_t>;
+using api_u32string_table = basic_api_string_table<char32_t>;
+using api_wstring_table   = basic_api_string_table<wchar_t>;
+
+} // namespace speudo_std
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef SPEUDO_STD_API_STRING_UTF_HPP
+#define SPEUDO_STD_API_STRING_UTF_HPP
+
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <api_string.hpp>
+
+namespace speudo_std {
+
+namespace _detail {
+
+/**
+    The UTF functions of `api_string_utf.hpp`. The encoding depends on the
+    size of the character type: UTF-8 for `char`, UTF-16 for `char16_t`
+    ( and `wchar_t` when it has two bytes ), and UTF-32 for `char32_t`
+    ( and `wchar_t` when it has four bytes ). They are vectorized, with
+    the instruction set selected at run time, and only defined for
+    `char`, `wchar_t`, `char16_t` and `char32_t`.
+*/
+template <typename CharT>
+bool utf_validate(const CharT* str, std::size_t len) noexcept;
+
+/**
+    The number of code units of `To` needed to encode `str`, or
+    `static_cast<std::size_t>(-1)` if `str` is not valid.
+*/
+template <typename To, typename From>
+std::size_t utf_transcoded_length(const From* str, std::size_t len) noexcept;
+
+template <typename To, typename From>
+speudo_std::basic_api_string<To> utf_transcode(const From* str, std::size_t len);
+
+} // namespace _detail
+
+/**
+    Tells whether `str` is a valid UTF-8, UTF-16 or UTF-32 string, according
+    to its character type. Overlong encodings, surrogates that are not
+    part of a pair ( or any surrogate in UTF-8 and UTF-32 ) and code points
+    beyond U+10FFFF are invalid.
+*/
+inline bool is_valid_utf(speudo_std::api_string_view str) noexcept
+{
+    return speudo_std::_detail::utf_validate(str.data(), str.size());
+}
+inline bool is_valid_utf(speudo_std::api_u16string_view str) noexcept
+{
+    return speudo_std::_detail::utf_validate(str.data(), str.size());
+}
+inline bool is_valid_utf(speudo_std::api_u32string_view str) noexcept
+{
+    return speudo_std::_detail::utf_validate(str.data(), str.size());
+}
+inline bool is_valid_utf(speudo_std::api_wstring_view str) noexcept
+{
+    return speudo_std::_detail::utf_validate(str.data(), str.size());
+}
+
+/**
+    The length of `str` once converted to the encoding of `To`, or
+    `static_cast<std::size_t>(-1)` if `str` is not valid.
+*/
+template <typename To>
+std::size_t utf_transcoded_length(speudo_std::api_string_view str) noexcept
+{
+    return speudo_std::_detail::utf_transcoded_length<To>(str.data(), str.size());
+}
+template <typename To>
+std::size_t utf_transcoded_length(speudo_std::api_u16string_view str) noexcept
+{
+    return speudo_std::_detail::utf_transcoded_length<To>(str.data(), str.size());
+}
+template <typename To>
+std::size_t utf_transcoded_length(speudo_std::api_u32string_view str) noexcept
+{
+    return speudo_std::_detail::utf_transcoded_length<To>(str.data(), str.size());
+}
+template <typename To>
+std::size_t utf_transcoded_length(speudo_std::api_wstring_view str) noexcept
+{
+    return speudo_std::_detail::utf_transcoded_length<To>(str.data(), str.size());
+}
+
+/**
+    Converts `str` to the encoding of `To`. The input is validated and
+    the length of the result computed in a first pass, so that the
+    memory of the result is allocated once, with the exact size.
+
+    Throws `std::invalid_argument` if `str` is not valid.
+*/
+template <typename To>
+speudo_std::basic_api_string<To> utf_transcode(speudo_std::api_string_view str)
+{
+    return speudo_std::_detail::utf_transcode<To>(str.data(), str.size());
+}
+template <typename To>
+speudo_std::basic_api_string<To> utf_transcode(speudo_std::api_u16string_view str)
+{
+    return speudo_std::_detail::utf_transcode<To>(str.data(), str.size());
+}
+template <typename To>
+speudo_std::basic_api_string<To> utf_transcode(speudo_std::api_u32string_view str)
+{
+    return speudo_std::_detail::utf_transcode<To>(str.data(), str.size());
+}
+template <typename To>
+speudo_std::basic_api_string<To> utf_transcode(speudo_std::api_wstring_view str)
+{
+    return speudo_std::_detail::utf_transcode<To>(str.data(), str.size());
+}
+
+} // namespace speudo_std
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef SPEUDO_STD_API_STRING_WEAK_HPP
+#define SPEUDO_STD_API_STRING_WEAK_HPP
+
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <detail/api_string_memory.hpp>
+#include <utility>
+
+namespace speudo_std {
+
+/**
+    Observes the string of a `basic_api_string` without keeping it alive.
+    `lock()` returns the string if there is still a `basic_api_string`
+    that references it, and an empty string otherwise.
+
+    This requires a memory manager whose `abi_version` is at least 1 ( like
+    the one used by `basic_api_string` and `basic_string` ). The memory
+    block is deallocated only after the last weak reference is released,
+    so a cache should erase its expired entries.
+
+    Strings that have no memory manager, or that are in SSO mode, are
+    simply copied, hence never expire. Strings whose manager does not
+    support weak references ( like those created by `map_file` ) are kept
+    alive.
+*/
+template <typename CharT>
+class basic_weak_api_string
+{
+public:
+
+    using value_type = speudo_std::basic_api_string<CharT>;
+
+    basic_weak_api_string() noexcept
+    {
+    }
+
+    basic_weak_api_string(const value_type& s) noexcept;
+
+    basic_weak_api_string(const basic_weak_api_string& other) noexcept
+        : _value(other._value)
+        , _manager(other._manager)
+        , _str(other._str)
+        , _len(other._len)
+    {
+        if (_manager != nullptr)
+        {
+            _manager->weak_acquire();
+        }
+    }
+
+    basic_weak_api_string(basic_weak_api_string&& other) noexcept
+        : _value(std::move(other._value))
+        , _manager(std::exchange(other._manager, nullptr))
+        , _str(other._str)
+        , _len(other._len)
+    {
+    }
+
+    ~basic_weak_api_string()
+    {
+        if (_manager != nullptr)
+        {
+            _manager->weak_release();
+        }
+    }
+
+    basic_weak_api_string& operator=(const basic_weak_api_string& other) noexcept
+    {
+        basic_weak_api_string tmp(other);
+        swap(tmp);
+        return *this;
+    }
+
+    basic_weak_api_string& operator=(basic_weak_api_string&& other) noexcept
+    {
+        basic_weak_api_string tmp(std::move(other));
+        swap(tmp);
+        return *this;
+    }
+
+    basic_weak_api_string& operator=(const value_type& s) noexcept
+    {
+        basic_weak_api_string tmp(s);
+        swap(tmp);
+        return *this;
+    }
+
+    void swap(basic_weak_api_string& other) noexcept
+    {
+        _value.swap(other._value);
+        std::swap(_manager, other._manager);
+        std::swap(_str, other._str);
+        std::swap(_len, other._len);
+    }
+
+    void reset() noexcept
+    {
+        basic_weak_api_string tmp;
+        swap(tmp);
+    }
+
+    /**
+        Returns the observed string, or an empty string if it has
+        been released.
+    */
+    value_type lock() const noexcept;
+
+    bool expired() const noexcept
+    {
+        if (_manager == nullptr)
+        {
+            return false;
+        }
+        if (_manager->try_acquire())
+        {
+            _manager->release();
+            return false;
+        }
+        return true;
+    }
+
+private:
+
+    // the string, when it is not weakly referenced
+    value_type _value;
+
+    speudo_std::abi::api_string_mem_base* _manager = nullptr;
+    const CharT* _str = nullptr;
+    std::size_t _len = 0;
+};
+
+template <typename CharT>
+basic_weak_api_string<CharT>::basic_weak_api_string(const value_type& s) noexcept
+{
+    const auto& data = speudo_std::_detail::basic_string_helper::get_data(s);
+    if ( data.big.str != nullptr
+      && data.big.mem_manager != nullptr
+      && data.big.mem_manager->supports_weak() )
+    {
+        _manager = data.big.mem_manager;
+        _manager->weak_acquire();
+        _str = data.big.str;
+        _len = data.big.len;
+    }
+    else
+    {
+        _value = s;
+    }
+}
+
+template <typename CharT>
+typename basic_weak_api_string<CharT>::value_type
+basic_weak_api_string<CharT>::lock() const noexcept
+{
+    if (_manager == nullptr)
+    {
+        return _value;
+    }
+    if (_manager->try_acquire())
+    {
+        return speudo_std::_detail::basic_string_helper::adopt<CharT>(_manager, _str, _len);
+    }
+    return {};
+}
+
+template <typename CharT>
+void swap(basic_weak_api_string<CharT>& a, basic_weak_api_string<CharT>& b) noexcept
+{
+    a.swap(b);
+}
+
+using weak_api_string    = basic_weak_api_string<char>;
+using weak_api_u16string = basic_weak_api_string<char16_t>;
+using weak_api_u32string = basic_weak_api_string<char32_t>;
+using weak_api_wstring   = basic_weak_api_string<wchar_t>;
+
+} // namespace speudo_std
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef SPEUDO_STD_DETAIL_API_STRING_HASH_HPP
+#define SPEUDO_STD_DETAIL_API_STRING_HASH_HPP
+
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+#include <cstddef>
+#include <cstdint>
+
+namespace speudo_std {
+
+namespace _detail {
+
+/**
+    The 64 bits FNV-1a hash of the code units of a string, taken
+    in little endian order, so that the result does not depend on
+    the platform nor on the standard library.
+*/
+template <typename CharT>
+constexpr std::uint64_t fnv1a_hash
+    ( const CharT* str
+    , std::size_t len
+    , std::uint64_t h = 0xcbf29ce484222325 ) noexcept
+{
+    for (std::size_t i = 0; i < len; ++i)
+    {
+        auto c = static_cast<std::uint64_t>(str[i]);
+        for (std::size_t b = 0; b < sizeof(CharT); ++b)
+        {
+            h = (h ^ ((c >> (8 * b)) & 0xff)) * 0x100000001b3;
+        }
+    }
+    return h;
+}
+
+/**
+    The hash of `api_string_hash`. Unlike `fnv1a_hash`, it is not meant to
+    be stored, since it may change from one version to another.
+
+    The bytes of the code units ( in little endian order ) are split in
+    blocks of `hash_block_size` bytes. Each block is read as four 64 bits
+    words, accumulated into four independent lanes, so that the run time
+    implementation handles a whole block at a time with SIMD instructions.
+    The lanes are then mixed together, followed by the remaining bytes.
+*/
+constexpr std::size_t hash_block_size = 32;
+
+inline constexpr std::uint64_t hash_lane_keys[4] =
+    { 0x9e3779b97f4a7c15, 0xc2b2ae3d27d4eb4f, 0x165667b19e3779f9, 0x27d4eb2f165667c5 };
+
+// The finalizer of MurmurHash3
+constexpr std::uint64_t hash_mix(std::uint64_t h) noexcept
+{
+    h = (h ^ (h >> 33)) * 0xff51afd7ed558ccd;
+    h = (h ^ (h >> 33)) * 0xc4ceb9fe1a85ec53;
+    return h ^ (h >> 33);
+}
+
+constexpr std::uint64_t hash_accumulate
+    ( std::uint64_t acc
+    , std::uint64_t word
+    , std::uint64_t key ) noexcept
+{
+    const std::uint64_t x = word ^ key;
+    return acc + (x & 0xffffffff) * (x >> 32) + word;
+}
+
+// The 64 bits word made of the bytes of `str[0, 8 / sizeof(CharT))`
+template <typename CharT>
+constexpr std::uint64_t hash_word(const CharT* str) noexcept
+{
+    constexpr std::uint64_t unit_mask = (std::uint64_t{1} << (8 * sizeof(CharT))) - 1;
+    std::uint64_t w = 0;
+    for (std::size_t k = 0; k < 8 / sizeof(CharT); ++k)
+    {
+        w |= (static_cast<std::uint64_t>(str[k]) & unit_mask) << (8 * sizeof(CharT) * k);
+    }
+    return w;
+}
+
+/**
+    The end of `lanes_hash`, once the blocks of `str[0, done)` have
+    been accumulated into `acc`.
+*/
+template <typename CharT>
+constexpr std::uint64_t lanes_hash_finish
+    ( const std::uint64_t* acc
+    , const CharT* str
+    , std::size_t len
+    , std::size_t done ) noexcept
+{
+    std::uint64_t h = 0xcbf29ce484222325;
+    if (done != 0)
+    {
+        for (std::size_t k = 0; k < 4; ++k)
+        {
+            h = hash_mix(h ^ acc[k]);
+        }
+    }
+    h = speudo_std::_detail::fnv1a_hash(str + done, len - done, h);
+    return hash_mix(h ^ (len * sizeof(CharT)));
+}
+
+template <typename CharT>
+constexpr std::uint64_t lanes_hash(const CharT* str, std::size_t len) noexcept
+{
+    constexpr std::size_t block_len = hash_block_size / sizeof(CharT);
+    constexpr std::size_t word_len = 8 / sizeof(CharT);
+    std::uint64_t acc[4] = { hash_lane_keys[0], hash_lane_keys[1]
+                           , hash_lane_keys[2], hash_lane_keys[3] };
+    std::size_t i = 0;
+    for (; i + block_len <= len; i += block_len)
+    {
+        for (std::size_t k = 0; k < 4; ++k)
+        {
+            acc[k] = hash_accumulate
+                ( acc[k], hash_word(str + i + k * word_len), hash_lane_keys[k] );
+        }
+    }
+    return lanes_hash_finish(acc, str, len, i);
+}
+
+} // namespace _detail
+
+} // namespace speudo_std
+
+#endif
@@ -8,6 +8,7 @@
 #include <api_string.hpp>
 #include <atomic>
 #include <memory>
+#include <type_traits>
 
 namespace speudo_std {
 
@@ -25,6 +26,29 @@ inline void report_deallocation(){}
 
 namespace _detail {
 
+/**
+    Tells whether allocator `A` has the optional member function
+    `A::pointer reallocate(A::pointer p, size_type old_n, size_type new_n)`,
+    which resizes the block `p`, moving it if necessary, like `realloc`.
+    It returns null on failure, in which case `p` is left unchanged.
+*/
+template <typename A, typename = void>
+struct has_reallocate: std::false_type
+{
+};
+
+template <typename A>
+struct has_reallocate
+    < A
+    , std::void_t
+        < decltype( std::declval<A&>().reallocate
+                      ( std::declval<typename std::allocator_traits<A>::pointer>()
+                      , std::size_t{}
+                      , std::size_t{} )) > >
+    : std::true_type
+{
+};
+
 constexpr std::size_t api_string_mem_alignment
     = alignof(speudo_std::abi::api_string_mem_base) > alignof(char32_t)
     ? alignof(speudo_std::abi::api_string_mem_base)
@@ -85,6 +109,72 @@ public:
                , (array_size - 1) * sizeof(api_string_mem)};
     }
 
+    /**
+        Resizes the memory of `mem_base`, if it was created by this class,
+        is not shared, and if the allocator supports `reallocate` ( see
+        `has_reallocate` ). The content is preserved, though it may be
+        moved. Returns a null manager otherwise, or if the reallocation
+        fails, in which case nothing changes.
+    */
+    static memory reallocate
+        ( speudo_std::abi::api_string_mem_base* mem_base
+        , size_type bytes_capacity )
+    {
+        if constexpr (speudo_std::_detail::has_reallocate<rebinded_allocator_type>::value)
+        {
+            if (mem_base->func_table == get_table() && unique(mem_base))
+            {
+                auto* self = static_cast<api_string_mem*>(mem_base);
+                size_type old_array_size = reinterpret_cast<api_string_mem*>(self->_end) - self;
+                size_type array_size
+                    = (bytes_capacity + 2 * sizeof(api_string_mem) - 1)
+                    / sizeof(api_string_mem);
+
+                // The header holds atomics, which can not be relocated
+                // bytewise. So it is destroyed before the reallocation,
+                // which then only preserves the characters, and constructed
+                // again afterwards, wherever the block ends up.
+                Allocator a(self->get_allocator());
+                rebinded_allocator_type r_allocator(a);
+                const std::size_t refcount = self->_refcount.load(std::memory_order_relaxed);
+                const std::size_t weak_count = self->_weak_count.load(std::memory_order_relaxed);
+                speudo_std::abi::api_string_aux* aux = self->_aux.load(std::memory_order_relaxed);
+                std::byte* old_end = self->_end;
+                rebinded_allocator_traits::destroy(r_allocator, self);
+
+                api_string_mem* p = r_allocator.reallocate(self, old_array_size, array_size);
+                const bool moved = p != nullptr;
+                if ( ! moved)
+                {
+                    p = self;
+                }
+                rebinded_allocator_traits::construct
+                    ( r_allocator, p, a
+                    , moved ? reinterpret_cast<std::byte*>(p + array_size) : old_end );
+                p->_refcount.store(refcount, std::memory_order_relaxed);
+                p->_weak_count.store(weak_count, std::memory_order_relaxed);
+                p->_aux.store(aux, std::memory_order_relaxed);
+                if (moved)
+                {
+                    return { p
+                           , reinterpret_cast<std::byte*>(p + 1)
+                           , (array_size - 1) * sizeof(api_string_mem)};
+                }
+            }
+        }
+        return {nullptr, nullptr, 0};
+    }
+
+    /**
+        Adds `n` references at once. Used when one block is shared by
+        several `basic_api_string` objects from the start.
+    */
+    static void add_references(speudo_std::abi::api_string_mem_base* mem_base, std::size_t n)
+    {
+        auto* self = static_cast<api_string_mem*>(mem_base);
+        self->_refcount.fetch_add(n, std::memory_order_relaxed);
+    }
+
     static size_type max_bytes_size(const Allocator& a)
     {
         rebinded_allocator_type rb(a);
@@ -96,7 +186,12 @@ public:
 private:
 
     std::atomic<std::size_t> _refcount{1};
+
+    // The number of weak references, plus one while `_refcount` is not zero.
+    // The memory is deallocated when it reaches zero.
+    std::atomic<std::size_t> _weak_count{1};
     std::byte* _end;
+    std::atomic<speudo_std::abi::api_string_aux*> _aux{nullptr};
 
     Allocator& get_allocator()
     {
@@ -113,20 +208,70 @@ private:
     {
         auto* self = static_cast<api_string_mem*>(mem_base);
         if (self->_refcount.fetch_sub(1, std::memory_order_release) == 1) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            weak_release(self);
+        }
+    }
+
+    static void acquire_n(api_string_mem_base* mem_base, std::size_t n)
+    {
+        auto* self = static_cast<api_string_mem*>(mem_base);
+        self->_refcount.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    static void release_n(api_string_mem_base* mem_base, std::size_t n)
+    {
+        auto* self = static_cast<api_string_mem*>(mem_base);
+        if (self->_refcount.fetch_sub(n, std::memory_order_release) == n) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            weak_release(self);
+        }
+    }
+
+    static void weak_acquire(api_string_mem_base* mem_base)
+    {
+        auto* self = static_cast<api_string_mem*>(mem_base);
+        self->_weak_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void weak_release(api_string_mem_base* mem_base)
+    {
+        auto* self = static_cast<api_string_mem*>(mem_base);
+        if (self->_weak_count.fetch_sub(1, std::memory_order_release) == 1) {
             std::atomic_thread_fence(std::memory_order_acquire);
             delete_self(self);
         }
     }
 
+    static bool try_acquire(api_string_mem_base* mem_base)
+    {
+        auto* self = static_cast<api_string_mem*>(mem_base);
+        std::size_t count = self->_refcount.load(std::memory_order_relaxed);
+        while (count != 0) {
+            if (self->_refcount.compare_exchange_weak
+                   ( count, count + 1
+                   , std::memory_order_acquire
+                   , std::memory_order_relaxed ))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // A string observed by weak references is not unique, since
+    // any of them could be locked while the content is modified.
     static bool unique(api_string_mem_base* mem_base)
     {
         auto* self = static_cast<api_string_mem*>(mem_base);
-        return self->_refcount.load() == 1;
+        return self->_refcount.load(std::memory_order_acquire) == 1
+            && self->_weak_count.load(std::memory_order_acquire) == 1;
     }
 
     static std::byte* begin(api_string_mem_base* mem_base)
     {
-        return reinterpret_cast<std::byte*>(mem_base + 1);
+        auto* self = static_cast<api_string_mem*>(mem_base);
+        return reinterpret_cast<std::byte*>(self + 1);
     }
 
     static std::byte* end(api_string_mem_base* mem_base)
@@ -135,15 +280,50 @@ private:
         return reinterpret_cast<std::byte*>(self->_end);
     }
 
+    static speudo_std::abi::api_string_aux* get_aux(api_string_mem_base* mem_base)
+    {
+        auto* self = static_cast<api_string_mem*>(mem_base);
+        return self->_aux.load(std::memory_order_acquire);
+    }
+
+    static speudo_std::abi::api_string_aux* set_aux
+        ( api_string_mem_base* mem_base
+        , speudo_std::abi::api_string_aux* aux )
+    {
+        auto* self = static_cast<api_string_mem*>(mem_base);
+        speudo_std::abi::api_string_aux* expected = nullptr;
+        if (self->_aux.compare_exchange_strong
+               ( expected, aux
+               , std::memory_order_acq_rel
+               , std::memory_order_acquire ))
+        {
+            return aux;
+        }
+        return expected;
+    }
+
+    static void drop_aux(api_string_mem_base* mem_base)
+    {
+        auto* self = static_cast<api_string_mem*>(mem_base);
+        auto* aux = self->_aux.exchange(nullptr, std::memory_order_acq_rel);
+        if (aux != nullptr) {
+            aux->destroy(aux);
+        }
+    }
+
     static const speudo_std::abi::api_string_func_table* get_table()
     {
         static const speudo_std::abi::api_string_func_table table =
-            {0, acquire, release, unique, begin, end};
+            { 3, acquire, release, unique, begin, end
+            , weak_acquire, weak_release, try_acquire
+            , acquire_n, release_n
+            , get_aux, set_aux, drop_aux };
         return & table;
     }
 
     static void delete_self(api_string_mem_base* mem_base)
     {
+        drop_aux(mem_base);
         auto* self = static_cast<api_string_mem*>(mem_base);
         rebinded_allocator_type r_allocator{self->get_allocator()};
         size_type count = reinterpret_cast<api_string_mem*>(self->_end) - self;
@@ -154,6 +334,48 @@ private:
     }
 };
 
+/**
+    Internal: the access to the representation of `basic_api_string` shared
+    by the headers and the sources of this library. It is not part of the
+    public interface, and bypasses the invariants of `basic_api_string`:
+    `adopt` does not check that `str` belongs to the memory of `manager`.
+*/
+class basic_string_helper
+{
+public:
+
+    template <typename CharT>
+    static speudo_std::abi::api_string_data<CharT>&
+    get_data(speudo_std::basic_api_string<CharT>& s)
+    {
+        return s._data;
+    }
+
+    template <typename CharT>
+    static const speudo_std::abi::api_string_data<CharT>&
+    get_data(const speudo_std::basic_api_string<CharT>& s)
+    {
+        return s._data;
+    }
+
+    /**
+        Creates a `basic_api_string` that takes over one reference
+        of `manager`. `str[len]` must be zero.
+    */
+    template <typename CharT>
+    static speudo_std::basic_api_string<CharT> adopt
+        ( speudo_std::abi::api_string_mem_base* manager
+        , const CharT* str
+        , std::size_t len )
+    {
+        speudo_std::basic_api_string<CharT> s;
+        s._data.big.len = len;
+        s._data.big.mem_manager = manager;
+        s._data.big.str = str;
+        return s;
+    }
+};
+
 extern template class api_string_mem<std::allocator<char>>;
 extern template class api_string_mem<std::allocator<char16_t>>;
 extern template class api_string_mem<std::allocator<char32_t>>;
@@ -6,33 +6,80 @@
 //          http://www.boost.org/LICENSE_1_0.txt)
 
 #include <detail/api_string_memory.hpp>
+#include <algorithm>
+#include <cassert>
+#include <functional>
 #include <string_view> // char_traits
 
 namespace speudo_std {
 
-template
-    < typename CharT
-    , typename Traits = std::char_traits<CharT>
-    , typename Allocator = std::allocator<CharT> >
-class basic_string;
+/**
+    Selects the constructor of `basic_string` that shares the memory of
+    a `basic_api_string` until the first modification.
+*/
+struct copy_on_write_t
+{
+    explicit copy_on_write_t() = default;
+};
 
-namespace _detail {
+inline constexpr copy_on_write_t copy_on_write{};
+
+/**
+    Computes the capacity of a `basic_string` when it needs to grow to
+    `required` characters:
 
-class basic_string_helper
+    - if the string takes at least `LinearFromBytes` bytes, the capacity is
+      increased by `LinearStepBytes` bytes only, so that huge strings do
+      not waste half of their memory;
+    - otherwise, `required` is multiplied by `FactorPercent / 100`,
+      but the capacity grows by at least `MinStep` characters.
+
+    The default policy doubles the required size. Another policy can be
+    selected through a member type `growth_policy` of the allocator.
+*/
+template
+    < std::size_t FactorPercent = 200
+    , std::size_t MinStep = 0
+    , std::size_t LinearFromBytes = static_cast<std::size_t>(-1)
+    , std::size_t LinearStepBytes = 0 >
+struct string_growth_policy
 {
-    template <typename CharT>
-    static speudo_std::abi::api_string_data<CharT>&
-    get_data(speudo_std::basic_api_string<CharT>& s)
+    static_assert(FactorPercent >= 100, "the capacity must not shrink");
+
+    static constexpr std::size_t next_capacity(std::size_t required, std::size_t char_size)
     {
-        return s._data;
+        if (required >= LinearFromBytes / char_size)
+        {
+            return required + LinearStepBytes / char_size;
+        }
+        std::size_t cap = required <= static_cast<std::size_t>(-1) / FactorPercent
+            ? required * FactorPercent / 100
+            : required;
+        return cap - required < MinStep ? required + MinStep : cap;
     }
+};
+
+namespace _detail {
 
-    template < typename, typename, typename >
-    friend class speudo_std::basic_string;
+template <typename Allocator, typename = void>
+struct growth_policy_of
+{
+    using type = speudo_std::string_growth_policy<>;
 };
 
-}
+template <typename Allocator>
+struct growth_policy_of<Allocator, std::void_t<typename Allocator::growth_policy>>
+{
+    using type = typename Allocator::growth_policy;
+};
+
+} // namespace _detail
 
+template
+    < typename CharT
+    , typename Traits = std::char_traits<CharT>
+    , typename Allocator = std::allocator<CharT> >
+class basic_string;
 
 template <typename CharT, typename Traits, typename Allocator>
 class basic_string
@@ -48,6 +95,8 @@ class basic_string
 
     using _memory_creator = speudo_std::_detail::api_string_mem<Allocator>;
 
+    using _growth_policy = typename speudo_std::_detail::growth_policy_of<Allocator>::type;
+
 public:
 
     using value_type     = CharT;
@@ -66,7 +115,7 @@ public:
     using reverse_iterator       = std::reverse_iterator<iterator>;
     using const_reverse_iterator = std::reverse_iterator<const_iterator>;
 
-    static const size_type npos = -1;
+    static constexpr size_type npos = -1;
 
     basic_string() noexcept(noexcept(Allocator{}))
         : basic_string(Allocator{})
@@ -131,8 +180,16 @@ public:
     basic_string(const basic_string& other)
         : _allocator(_alloc_traits::select_on_container_copy_construction(other._allocator))
     {
-        _reset_data();
-        append(&other[0], other.size());
+        if (other._shared())
+        {
+            _data = other._data;
+            _data.big.mem_manager->acquire();
+        }
+        else
+        {
+            _reset_data();
+            append(other.data(), other.size());
+        }
     }
 
     basic_string(basic_string&& other, const Allocator& alloc)
@@ -177,6 +234,17 @@ public:
         ( basic_api_string<CharT>&& other
         , const Allocator& alloc = Allocator{} );
 
+    /**
+        Shares the memory of `other` instead of copying it. The string is
+        copied only when a non-const member function is called, including
+        non-const element access and iterators. This is done eagerly if
+        `other` has no memory manager or fits in the small string buffer.
+    */
+    basic_string
+        ( const basic_api_string<CharT>& other
+        , speudo_std::copy_on_write_t
+        , const Allocator& alloc = Allocator{} );
+
 
     ~basic_string()
     {
@@ -313,6 +381,7 @@ public:
     }
     pointer data()
     {
+        _make_writable();
         return _big() ? _data.big.str : _data.small.str;
     }
     const_pointer c_str() const
@@ -321,6 +390,11 @@ public:
     }
     // operator std::basic_string_view<CharT, Traits>() const noexcept;
 
+    operator speudo_std::basic_api_string_view<CharT>() const noexcept
+    {
+        return {data(), size()};
+    }
+
     operator speudo_std::basic_api_string<CharT>() const &
     {
         return basic_string{*this}._move_to_api_string();
@@ -354,9 +428,7 @@ public:
     }
     iterator end()
     {
-        return _big()
-            ? (_data.big.str + _data.big.len)
-            : (_data.small.str + _data.small.len);
+        return data() + size();
     }
     const_iterator end() const
     {
@@ -406,7 +478,7 @@ public:
     }
     size_type capacity() const
     {
-        return _big() ? _data.big.capacity : _data.small_capacity();
+        return _shared() ? _data.big.len : _capacity();
     }
     bool empty() const
     {
@@ -414,8 +486,8 @@ public:
     }
     void reserve(size_type new_cap)
     {
-        if (new_cap > capacity()) {
-            _replace_memory(data(), length(), new_cap);
+        if (new_cap > _capacity()) {
+            _replace_memory(c_str(), length(), std::max(new_cap, length()));
         }
     }
     size_type max_size() const
@@ -430,28 +502,60 @@ public:
 
     void clear();
 
-    // basic_string& insert( size_type index, size_type count, CharT ch );
+    basic_string& insert( size_type index, size_type count, CharT ch )
+    {
+        return _replace_fill(index, 0, count, ch, "basic_string::insert: pos > size()");
+    }
 
-    // basic_string& insert( size_type index, const CharT* s );
+    basic_string& insert( size_type index, const CharT* s )
+    {
+        return _replace(index, 0, s, Traits::length(s), "basic_string::insert: pos > size()");
+    }
 
-    // basic_string& insert( size_type index, const CharT* s, size_type count );
+    basic_string& insert( size_type index, const CharT* s, size_type count )
+    {
+        return _replace(index, 0, s, count, "basic_string::insert: pos > size()");
+    }
 
-    // basic_string& insert( size_type index, const basic_string& other );
+    basic_string& insert( size_type index, const basic_string& other )
+    {
+        return _replace(index, 0, other.data(), other.size(), "basic_string::insert: pos > size()");
+    }
 
-    // basic_string& insert
-    //     ( size_type index
-    //     , const basic_string& other
-    //     , size_type index_other
-    //     , size_type count = npos);
+    basic_string& insert
+        ( size_type index
+        , const basic_string& other
+        , size_type index_other
+        , size_type count = npos)
+    {
+        return _replace
+            ( index, 0, other._view().substr(index_other, count)
+            , "basic_string::insert: pos > size()" );
+    }
 
-    // iterator insert( const_iterator pos, CharT ch );
+    iterator insert( const_iterator pos, CharT ch )
+    {
+        size_type index = pos - c_str();
+        _replace_fill(index, 0, 1, ch, "basic_string::insert: pos > size()");
+        return data() + index;
+    }
 
-    // iterator insert( const_iterator pos, size_type count, CharT ch );
+    iterator insert( const_iterator pos, size_type count, CharT ch )
+    {
+        size_type index = pos - c_str();
+        _replace_fill(index, 0, count, ch, "basic_string::insert: pos > size()");
+        return data() + index;
+    }
 
     // template< class InputIt >
     // iterator insert( const_iterator pos, InputIt first, InputIt last );
 
-    // iterator insert( const_iterator pos, std::initializer_list<CharT> ilist );
+    iterator insert( const_iterator pos, std::initializer_list<CharT> ilist )
+    {
+        size_type index = pos - c_str();
+        _replace(index, 0, ilist.begin(), ilist.size(), "basic_string::insert: pos > size()");
+        return data() + index;
+    }
 
     // template < class T >
     // basic_string& insert( size_type pos, const T& t );
@@ -463,11 +567,24 @@ public:
     //     , size_type index_str
     //     , size_type count = npos);
 
-    // basic_string& erase( size_type index = 0, size_type count = npos );
+    basic_string& erase( size_type index = 0, size_type count = npos )
+    {
+        return _replace_fill(index, count, 0, CharT{}, "basic_string::erase: pos > size()");
+    }
 
-    // iterator erase( const_iterator position );
+    iterator erase( const_iterator position )
+    {
+        size_type index = position - c_str();
+        _replace_fill(index, 1, 0, CharT{}, "basic_string::erase: pos > size()");
+        return data() + index;
+    }
 
-    // iterator erase( const_iterator first, const_iterator last );
+    iterator erase( const_iterator first, const_iterator last )
+    {
+        size_type index = first - c_str();
+        _replace_fill(index, last - first, 0, CharT{}, "basic_string::erase: pos > size()");
+        return data() + index;
+    }
 
     void push_back(CharT ch);
 
@@ -588,22 +705,31 @@ public:
 
     // bool ends_with(const CharT* x) const;
 
-    // basic_string& replace
-    //     ( size_type pos
-    //     , size_type count
-    //     , const basic_string& other );
+    basic_string& replace
+        ( size_type pos
+        , size_type count
+        , const basic_string& other )
+    {
+        return _replace(pos, count, other.data(), other.size());
+    }
 
-    // basic_string& replace
-    //     ( const_iterator first
-    //     , const_iterator last
-    //     , const basic_string& other );
+    basic_string& replace
+        ( const_iterator first
+        , const_iterator last
+        , const basic_string& other )
+    {
+        return _replace(first - c_str(), last - first, other.data(), other.size());
+    }
 
-    // basic_string& replace
-    //     ( size_type pos
-    //     , size_type count
-    //     , const basic_string& other
-    //     , size_type pos2
-    //     , size_type count2 = npos );
+    basic_string& replace
+        ( size_type pos
+        , size_type count
+        , const basic_string& other
+        , size_type pos2
+        , size_type count2 = npos )
+    {
+        return _replace(pos, count, other._view().substr(pos2, count2));
+    }
 
     // template< class InputIt >
     // basic_string& replace
@@ -612,44 +738,65 @@ public:
     //     , InputIt first2
     //     , InputIt last2 );
 
-    // basic_string& replace
-    //     ( size_type pos
-    //     , size_type count
-    //     , const CharT* cstr
-    //     , size_type count2 );
+    basic_string& replace
+        ( size_type pos
+        , size_type count
+        , const CharT* cstr
+        , size_type count2 )
+    {
+        return _replace(pos, count, cstr, count2);
+    }
 
-    // basic_string& replace
-    //     ( const_iterator first
-    //     , const_iterator last
-    //     , const CharT* cstr
-    //     , size_type count2 );
+    basic_string& replace
+        ( const_iterator first
+        , const_iterator last
+        , const CharT* cstr
+        , size_type count2 )
+    {
+        return _replace(first - c_str(), last - first, cstr, count2);
+    }
 
-    // basic_string& replace
-    //     ( size_type pos
-    //     , size_type count
-    //     , const CharT* cstr );
+    basic_string& replace
+        ( size_type pos
+        , size_type count
+        , const CharT* cstr )
+    {
+        return _replace(pos, count, cstr, Traits::length(cstr));
+    }
 
-    // basic_string& replace
-    //     ( const_iterator first
-    //     , const_iterator last
-    //     , const CharT* cstr );
+    basic_string& replace
+        ( const_iterator first
+        , const_iterator last
+        , const CharT* cstr )
+    {
+        return _replace(first - c_str(), last - first, cstr, Traits::length(cstr));
+    }
 
-    // basic_string& replace
-    //     ( size_type pos
-    //     , size_type count
-    //     , size_type count2
-    //     , CharT ch );
+    basic_string& replace
+        ( size_type pos
+        , size_type count
+        , size_type count2
+        , CharT ch )
+    {
+        return _replace_fill(pos, count, count2, ch);
+    }
 
-    // basic_string& replace
-    //     ( const_iterator first
-    //     , const_iterator last
-    //     , size_type count2
-    //     , CharT ch );
+    basic_string& replace
+        ( const_iterator first
+        , const_iterator last
+        , size_type count2
+        , CharT ch )
+    {
+        return _replace_fill(first - c_str(), last - first, count2, ch);
+    }
 
-    // basic_string& replace
-    //     ( const_iterator first
-    //     , const_iterator last
-    //     , std::initializer_list<CharT> ilist );
+    basic_string& replace
+        ( const_iterator first
+        , const_iterator last
+        , std::initializer_list<CharT> ilist )
+    {
+        return _replace(first - c_str(), last - first, ilist.begin(), ilist.size());
+    }
 
     // template < class T >
     // basic_string& replace
@@ -671,10 +818,16 @@ public:
     //     , size_type pos2
     //     , size_type count2 = npos );
 
+    basic_string substr( size_type pos = 0, size_type count = npos ) const
+    {
+        auto v = _view().substr(pos, count);
+        return basic_string(v.data(), v.size(), _allocator);
+    }
 
-    // basic_string substr( size_type pos = 0, size_type count = npos ) const;
-
-    // size_type copy( CharT* dest, size_type count, size_type pos = 0) const;
+    size_type copy( CharT* dest, size_type count, size_type pos = 0) const
+    {
+        return _view().copy(dest, count, pos);
+    }
 
     void resize( size_type count )
     {
@@ -683,6 +836,23 @@ public:
 
     void resize( size_type count, CharT ch );
 
+    /**
+        Resizes the string to `count` characters, without initializing
+        the new ones, and calls `op(data(), count)`, which writes the
+        content and returns the actual size, that must not be greater
+        than `count`. The characters before `std::min(size(), count)`
+        are preserved.
+    */
+    template <typename Operation>
+    void resize_and_overwrite( size_type count, Operation op );
+
+    /**
+        Appends `count` uninitialized characters, and returns a pointer
+        to the first of them, which the caller must overwrite. If fewer
+        characters are written, call `resize` to drop the remaining ones.
+    */
+    CharT* append_uninitialized( size_type count );
+
 private:
 
     using _prop_alloc_on_swap
@@ -714,57 +884,140 @@ public:
     //
     // Search
     //
-    // size_type find( const basic_string& str, size_type pos = 0 ) const
+    size_type find( const basic_string& str, size_type pos = 0 ) const noexcept
+    {
+        return _search_view().find(str.data(), pos, str.size());
+    }
 
-    //     size_type find( const CharT* s, size_type pos, size_type count ) const;
+    size_type find( const CharT* s, size_type pos, size_type count ) const
+    {
+        return _search_view().find(s, pos, count);
+    }
 
-    // size_type find( const CharT* s, size_type pos = 0 ) const;
+    size_type find( const CharT* s, size_type pos = 0 ) const
+    {
+        return _search_view().find(s, pos, Traits::length(s));
+    }
 
-    // size_type find( CharT ch, size_type pos = 0 ) const;
+    size_type find( CharT ch, size_type pos = 0 ) const noexcept
+    {
+        return _search_view().find(ch, pos);
+    }
 
     // template < class T >
     // size_type find( const T& t, size_type pos = 0 ) const;
 
-    // size_type find_first_of( const basic_string& str, size_type pos = 0 ) const;
+    size_type rfind( const basic_string& str, size_type pos = npos ) const noexcept
+    {
+        return _search_view().rfind(str.data(), pos, str.size());
+    }
 
-    // size_type find_first_of( const CharT* s, size_type pos, size_type count ) const;
+    size_type rfind( const CharT* s, size_type pos, size_type count ) const
+    {
+        return _search_view().rfind(s, pos, count);
+    }
 
-    // size_type find_first_of( const CharT* s, size_type pos = 0 ) const;
+    size_type rfind( const CharT* s, size_type pos = npos ) const
+    {
+        return _search_view().rfind(s, pos, Traits::length(s));
+    }
 
-    // size_type find_first_of( CharT ch, size_type pos = 0 ) const;
+    size_type rfind( CharT ch, size_type pos = npos ) const noexcept
+    {
+        return _search_view().rfind(ch, pos);
+    }
+
+    // template < class T >
+    // size_type rfind( const T& t, size_type pos = npos ) const;
+
+    size_type find_first_of( const basic_string& str, size_type pos = 0 ) const noexcept
+    {
+        return _search_view().find_first_of(str.data(), pos, str.size());
+    }
+
+    size_type find_first_of( const CharT* s, size_type pos, size_type count ) const
+    {
+        return _search_view().find_first_of(s, pos, count);
+    }
+
+    size_type find_first_of( const CharT* s, size_type pos = 0 ) const
+    {
+        return _search_view().find_first_of(s, pos, Traits::length(s));
+    }
+
+    size_type find_first_of( CharT ch, size_type pos = 0 ) const noexcept
+    {
+        return _search_view().find_first_of(ch, pos);
+    }
 
     // template < class T >
     // size_type find_first_of( const T& t, size_type pos = 0 ) const;
 
-    // size_type find_first_not_of( const basic_string& str, size_type pos = 0 ) const;
+    size_type find_first_not_of( const basic_string& str, size_type pos = 0 ) const noexcept
+    {
+        return _search_view().find_first_not_of(str.data(), pos, str.size());
+    }
 
-    // size_type find_first_not_of( const CharT* s, size_type pos, size_type count ) const;
+    size_type find_first_not_of( const CharT* s, size_type pos, size_type count ) const
+    {
+        return _search_view().find_first_not_of(s, pos, count);
+    }
 
-    // size_type find_first_not_of( const CharT* s, size_type pos = 0 ) const;
+    size_type find_first_not_of( const CharT* s, size_type pos = 0 ) const
+    {
+        return _search_view().find_first_not_of(s, pos, Traits::length(s));
+    }
 
-    // size_type find_first_not_of( CharT ch, size_type pos = 0 ) const;
+    size_type find_first_not_of( CharT ch, size_type pos = 0 ) const noexcept
+    {
+        return _search_view().find_first_not_of(ch, pos);
+    }
 
     // template < class T >
     // size_type find_first_not_of( const T& t, size_type pos = 0 ) const;
 
-    // size_type find_last_of( const basic_string& str, size_type pos = npos ) const;
+    size_type find_last_of( const basic_string& str, size_type pos = npos ) const noexcept
+    {
+        return _search_view().find_last_of(str.data(), pos, str.size());
+    }
 
-    // size_type find_last_of( const CharT* s, size_type pos, size_type count ) const;
+    size_type find_last_of( const CharT* s, size_type pos, size_type count ) const
+    {
+        return _search_view().find_last_of(s, pos, count);
+    }
 
-    // size_type find_last_of( const CharT* s, size_type pos = npos ) const;
+    size_type find_last_of( const CharT* s, size_type pos = npos ) const
+    {
+        return _search_view().find_last_of(s, pos, Traits::length(s));
+    }
 
-    // size_type find_last_of( CharT ch, size_type pos = npos ) const;
+    size_type find_last_of( CharT ch, size_type pos = npos ) const noexcept
+    {
+        return _search_view().find_last_of(ch, pos);
+    }
 
     // template < class T >
     // size_type find_last_of( const T& t, size_type pos = npos ) const;
 
-    // size_type find_last_not_of( const basic_string& str, size_type pos = npos ) const;
+    size_type find_last_not_of( const basic_string& str, size_type pos = npos ) const noexcept
+    {
+        return _search_view().find_last_not_of(str.data(), pos, str.size());
+    }
 
-    // size_type find_last_not_of( const CharT* s, size_type pos, size_type count ) const;
+    size_type find_last_not_of( const CharT* s, size_type pos, size_type count ) const
+    {
+        return _search_view().find_last_not_of(s, pos, count);
+    }
 
-    // size_type find_last_not_of( const CharT* s, size_type pos = npos ) const;
+    size_type find_last_not_of( const CharT* s, size_type pos = npos ) const
+    {
+        return _search_view().find_last_not_of(s, pos, Traits::length(s));
+    }
 
-    // size_type find_last_not_of( CharT ch, size_type pos = npos ) const;
+    size_type find_last_not_of( CharT ch, size_type pos = npos ) const noexcept
+    {
+        return _search_view().find_last_not_of(ch, pos);
+    }
 
     // template < class T >
     // size_type find_last_not_of( const T& t, size_type pos = npos ) const;
@@ -773,6 +1026,75 @@ private:
 
     speudo_std::basic_api_string<CharT> _move_to_api_string() &&;
 
+    union data_type;
+
+    std::basic_string_view<CharT, Traits> _view() const noexcept
+    {
+        return {c_str(), size()};
+    }
+
+    // The find functions of `basic_api_string_view` are vectorized, but
+    // compare the characters without `Traits`
+    auto _search_view() const noexcept
+    {
+        if constexpr (std::is_same<Traits, std::char_traits<CharT>>::value)
+        {
+            return speudo_std::basic_api_string_view<CharT>(c_str(), size());
+        }
+        else
+        {
+            return _view();
+        }
+    }
+
+    // Replaces the `count` characters at `pos` by `str[0, count2)`,
+    // which may be part of this string.
+    // `func` is the message of the exception thrown when `pos > size()`.
+    basic_string& _replace
+        ( size_type pos
+        , size_type count
+        , const CharT* str
+        , size_type count2
+        , const char* func = "basic_string::replace: pos > size()" );
+
+    basic_string& _replace
+        ( size_type pos
+        , size_type count
+        , std::basic_string_view<CharT, Traits> str
+        , const char* func = "basic_string::replace: pos > size()" )
+    {
+        return _replace(pos, count, str.data(), str.size(), func);
+    }
+
+    basic_string& _replace_fill
+        ( size_type pos
+        , size_type count
+        , size_type count2
+        , CharT ch
+        , const char* func = "basic_string::replace: pos > size()" );
+
+    // Checks `pos` and clamps `count` for the replace, insert and erase functions
+    size_type _replaced_count(size_type pos, size_type count, const char* func) const
+    {
+        if (pos > length())
+        {
+            _detail::throw_std_out_of_range(func);
+        }
+        return std::min(count, length() - pos);
+    }
+
+    // Creates a new memory block that contains this string with the
+    // characters in `[pos, pos + count)` replaced by `count2` uninitialized
+    // ones, or uses the small string buffer if the result fits in it.
+    // The result is not installed ( see `_set_data` ), so that the
+    // current characters are still readable.
+    data_type _new_data_with_gap(size_type pos, size_type count, size_type count2);
+
+    static CharT* _str_of(data_type& d)
+    {
+        return d.big.str != nullptr ? d.big.str : d.small.str;
+    }
+
     static int _compare
         ( const CharT* s1
         , size_type len1
@@ -792,10 +1114,60 @@ private:
         return _data.big.str == nullptr;
     }
 
+    // Whether the memory is shared with a `basic_api_string` ( see the
+    // copy_on_write_t constructor ), which is denoted by a zero capacity.
+    bool _shared() const
+    {
+        return _big() && _data.big.capacity == 0;
+    }
+
+    // The number of characters that can be written without reallocation.
+    size_type _capacity() const
+    {
+        return _big() ? _data.big.capacity : _data.small_capacity();
+    }
+
+    void _make_writable()
+    {
+        if (_shared())
+        {
+            _replace_memory(_data.big.str, _data.big.len, _data.big.len);
+        }
+    }
+
     void _grow_cap_if_necessary_for(size_t len_growth);
 
+    void _set_length(size_type len)
+    {
+        if (_big())
+        {
+            _data.big.len = len;
+            Traits::assign(_data.big.str[len], CharT{});
+        }
+        else
+        {
+            _data.small.len = static_cast<unsigned char>(len);
+            Traits::assign(_data.small.str[len], CharT{});
+        }
+    }
+
+    static size_type _next_capacity(size_type required)
+    {
+        return _growth_policy::next_capacity(required, sizeof(CharT));
+    }
+
+    // Tries to resize the memory block without copying it
+    bool _reallocate(size_type new_cap);
+
     void _replace_memory(const CharT* new_str, size_type new_len, size_type new_cap);
 
+    // Allocates a memory block able to hold `cap` characters,
+    // and sets its length to `len`, which is not greater than `cap`
+    data_type _create_data(size_type len, size_type cap);
+
+    // Takes ownership of `new_data` and releases the current memory block
+    void _set_data(const data_type& new_data) noexcept;
+
     // const Allocator&& _allocator_ref() const &&
     // {
     //     return static_cast<const Allocator&&>(_allocator);
@@ -907,11 +1279,13 @@ basic_string<CharT, Traits, Allocator>::basic_string
         if ( other_data.big.mem_manager != nullptr
           && other_data.big.mem_manager->unique() )
         {
+            // the content is going to change
+            other_data.big.mem_manager->drop_aux();
             _data.big.len = other_data.big.len;
             _data.big.mem_manager = other_data.big.mem_manager;
             _data.big.str = const_cast<CharT*>(other_data.big.str);
             auto end = reinterpret_cast<const CharT*>(other_data.big.mem_manager->end());
-            _data.big.capacity = end - other_data.big.str;
+            _data.big.capacity = end - other_data.big.str - 1;
             other_data = speudo_std::abi::api_string_data<CharT> {};
         }
         else
@@ -927,6 +1301,30 @@ basic_string<CharT, Traits, Allocator>::basic_string
     }
 }
 
+template <typename CharT, typename Traits, typename Allocator>
+basic_string<CharT, Traits, Allocator>::basic_string
+    ( const basic_api_string<CharT>& other
+    , speudo_std::copy_on_write_t
+    , const Allocator& alloc )
+    : basic_string(alloc)
+{
+    const auto& other_data = speudo_std::_detail::basic_string_helper::get_data(other);
+    if ( other_data.big.str != nullptr
+      && other_data.big.mem_manager != nullptr
+      && other_data.big.len > _data.small_capacity() )
+    {
+        other_data.big.mem_manager->acquire();
+        _data.big.len = other_data.big.len;
+        _data.big.capacity = 0;
+        _data.big.mem_manager = other_data.big.mem_manager;
+        _data.big.str = const_cast<CharT*>(other_data.big.str);
+    }
+    else
+    {
+        assign(other.data(), other.size());
+    }
+}
+
 template <typename CharT, typename Traits, typename Allocator>
 basic_string<CharT, Traits, Allocator>&
 basic_string<CharT, Traits, Allocator>::assign
@@ -964,6 +1362,11 @@ basic_string<CharT, Traits, Allocator>::assign(basic_string&& other)
     {
         _data = other._data;
     }
+    else if (_shared())
+    {
+        _data.big.mem_manager->release();
+        _data = other._data;
+    }
     else
     {
         _data.big.len = other._data.small.len;
@@ -977,9 +1380,9 @@ template <typename CharT, typename Traits, typename Allocator>
 basic_string<CharT, Traits, Allocator>&
 basic_string<CharT, Traits, Allocator>::assign(const CharT* s, size_type count)
 {
-    if (count > capacity())
+    if (count > _capacity() || _shared())
     {
-        _replace_memory(s, count, 2*count);
+        _replace_memory(s, count, _next_capacity(count));
     }
     else if (_small())
     {
@@ -1021,6 +1424,7 @@ void basic_string<CharT, Traits, Allocator>::resize(size_type count, CharT ch)
 {
     if (count < size())
     {
+        _make_writable();
         if (_big())
         {
             _data.big.len = count;
@@ -1038,6 +1442,35 @@ void basic_string<CharT, Traits, Allocator>::resize(size_type count, CharT ch)
     }
 }
 
+template <typename CharT, typename Traits, typename Allocator>
+template <typename Operation>
+void basic_string<CharT, Traits, Allocator>::resize_and_overwrite
+    ( size_type count
+    , Operation op )
+{
+    if (count > size())
+    {
+        _grow_cap_if_necessary_for(count - size());
+    }
+    else
+    {
+        _make_writable();
+    }
+    CharT* str = _big() ? _data.big.str : _data.small.str;
+    size_type len = std::move(op)(str, count);
+    assert(len <= count);
+    _set_length(len);
+}
+
+template <typename CharT, typename Traits, typename Allocator>
+CharT* basic_string<CharT, Traits, Allocator>::append_uninitialized(size_type count)
+{
+    _grow_cap_if_necessary_for(count);
+    size_type len = size();
+    _set_length(len + count);
+    return (_big() ? _data.big.str : _data.small.str) + len;
+}
+
 template <typename CharT, typename Traits, typename Allocator>
 void basic_string<CharT, Traits, Allocator>::shrink_to_fit()
 {
@@ -1052,7 +1485,7 @@ void basic_string<CharT, Traits, Allocator>::shrink_to_fit()
             basic_string tmp{_data.big.str, _data.big.len};
             swap(tmp);
         }
-        else if (_data.big.capcity - _data.big.len > min_capacity_diff)
+        else if (_shared() || _data.big.capacity - _data.big.len > min_capacity_diff)
         {
             _replace_memory(_data.big.str, _data.big.len, _data.big.len);
         }
@@ -1062,6 +1495,11 @@ void basic_string<CharT, Traits, Allocator>::shrink_to_fit()
 template <typename CharT, typename Traits, typename Allocator>
 inline void basic_string<CharT, Traits, Allocator>::clear()
 {
+    if (_shared())
+    {
+        _data.big.mem_manager->release();
+        _reset_data();
+    }
     _data.big.len = 0;
     if (_big())
     {
@@ -1114,12 +1552,14 @@ basic_string<CharT, Traits, Allocator>::_move_to_api_string() &&
 template <typename CharT, typename Traits, typename Allocator>
 CharT basic_string<CharT, Traits, Allocator>::pop_back()
 {
+    _make_writable();
     if (_big())
     {
         if (_data.big.len > 0)
         {
             CharT value = _data.big.str[_data.big.len - 1];
             -- _data.big.len;
+            Traits::assign(_data.big.str[_data.big.len], CharT{});
             return value;
         }
     }
@@ -1127,6 +1567,7 @@ CharT basic_string<CharT, Traits, Allocator>::pop_back()
     {
         CharT value = _data.small.str[_data.small.len - 1];
         -- _data.small.len;
+        Traits::assign(_data.small.str[_data.small.len], CharT{});
         return value;
     }
 
@@ -1159,13 +1600,13 @@ basic_string<CharT, Traits, Allocator>::append(size_type count, CharT ch)
     _grow_cap_if_necessary_for(count);
     if (_big())
     {
-        Traits::assign(_data.big.str, count, ch);
+        Traits::assign(_data.big.str + _data.big.len, count, ch);
         Traits::assign(_data.big.str[_data.big.len + count], CharT());
         _data.big.len += count;
     }
     else
     {
-        Traits::assign(_data.small.str, count, ch);
+        Traits::assign(_data.small.str + _data.small.len, count, ch);
         Traits::assign(_data.small.str[_data.small.len + count], CharT());
         _data.small.len += static_cast<unsigned char>(count);
     }
@@ -1195,11 +1636,34 @@ basic_string<CharT, Traits, Allocator>::append(const CharT* s, size_type count)
 template <typename CharT, typename Traits, typename Allocator>
 void basic_string<CharT, Traits, Allocator>::_grow_cap_if_necessary_for(size_t len_growth)
 {
-    if (length() + len_growth > capacity())
+    if (length() + len_growth > _capacity())
+    {
+        size_type new_cap = _next_capacity(length() + len_growth);
+        if ( ! _reallocate(new_cap))
+        {
+            _replace_memory(c_str(), length(), new_cap);
+        }
+    }
+}
+
+template <typename CharT, typename Traits, typename Allocator>
+bool basic_string<CharT, Traits, Allocator>::_reallocate(size_type new_cap)
+{
+    if ( ! _big()
+      || _shared()
+      || reinterpret_cast<std::byte*>(_data.big.str) != _data.big.mem_manager->begin() )
+    {
+        return false;
+    }
+    auto m = _memory_creator::reallocate(_data.big.mem_manager, (new_cap + 1) * sizeof(CharT));
+    if (m.manager == nullptr)
     {
-        size_type new_cap = 2 * (length() + len_growth);
-        _replace_memory(data(), length(), new_cap);
+        return false;
     }
+    _data.big.capacity = m.pool_size / sizeof(CharT) - 1;
+    _data.big.mem_manager = m.manager;
+    _data.big.str = reinterpret_cast<CharT*>(m.pool);
+    return true;
 }
 
 template <typename CharT, typename Traits, typename Allocator>
@@ -1208,18 +1672,33 @@ void basic_string<CharT, Traits, Allocator>::_replace_memory
     , basic_string::size_type new_len
     , basic_string::size_type new_cap )
 {
-    assert(new_cap >= new_len);
+    data_type new_data = _create_data(new_len, new_cap);
+    Traits::copy(new_data.big.str, new_str, new_len);
+    _set_data(new_data);
+}
+
+template <typename CharT, typename Traits, typename Allocator>
+typename basic_string<CharT, Traits, Allocator>::data_type
+basic_string<CharT, Traits, Allocator>::_create_data
+    ( basic_string::size_type len
+    , basic_string::size_type cap )
+{
+    assert(cap >= len);
 
-    auto m = _memory_creator::create(_allocator, (new_cap + 1) * sizeof(CharT));
+    auto m = _memory_creator::create(_allocator, (cap + 1) * sizeof(CharT));
 
     data_type new_data;
-    new_data.big.len = new_len;
+    new_data.big.len = len;
     new_data.big.capacity = m.pool_size / sizeof(CharT) - 1;
     new_data.big.mem_manager = m.manager;
     new_data.big.str = reinterpret_cast<CharT*>(m.pool);
-    Traits::copy(new_data.big.str, new_str, new_len);
-    Traits::assign(new_data.big.str[new_len], CharT{});
+    Traits::assign(new_data.big.str[len], CharT{});
+    return new_data;
+}
 
+template <typename CharT, typename Traits, typename Allocator>
+void basic_string<CharT, Traits, Allocator>::_set_data(const data_type& new_data) noexcept
+{
     data_type old_data = _data;
     _data = new_data;
     if (old_data.big.str != nullptr)
@@ -1228,6 +1707,126 @@ void basic_string<CharT, Traits, Allocator>::_replace_memory
     }
 }
 
+template <typename CharT, typename Traits, typename Allocator>
+typename basic_string<CharT, Traits, Allocator>::data_type
+basic_string<CharT, Traits, Allocator>::_new_data_with_gap
+    ( basic_string::size_type pos
+    , basic_string::size_type count
+    , basic_string::size_type count2 )
+{
+    const size_type len = length();
+    const size_type new_len = len - count + count2;
+    data_type new_data;
+    if (new_len <= data_type::small_capacity())
+    {
+        if (sizeof(new_data.big) > sizeof(new_data.small))
+        {
+            new_data.big = {0};
+        }
+        else
+        {
+            new_data.small = {0};
+        }
+        new_data.small.len = static_cast<unsigned char>(new_len);
+    }
+    else
+    {
+        const size_type new_cap = new_len > len ? _next_capacity(new_len) : new_len;
+        new_data = _create_data(new_len, new_cap);
+    }
+    CharT* new_str = _str_of(new_data);
+    const CharT* old_str = c_str();
+    Traits::copy(new_str, old_str, pos);
+    Traits::copy( new_str + pos + count2
+                , old_str + pos + count
+                , len - pos - count );
+    Traits::assign(new_str[new_len], CharT{});
+    return new_data;
+}
+
+template <typename CharT, typename Traits, typename Allocator>
+basic_string<CharT, Traits, Allocator>&
+basic_string<CharT, Traits, Allocator>::_replace
+    ( basic_string::size_type pos
+    , basic_string::size_type count
+    , const CharT* str
+    , basic_string::size_type count2
+    , const char* func )
+{
+    count = _replaced_count(pos, count, func);
+    const size_type len = length();
+    const size_type new_len = len - count + count2;
+    if (new_len > _capacity() || _shared())
+    {
+        // `str` may point into the current block, so it is only
+        // released after the copy
+        data_type new_data = _new_data_with_gap(pos, count, count2);
+        Traits::copy(_str_of(new_data) + pos, str, count2);
+        _set_data(new_data);
+        return *this;
+    }
+
+    CharT* p = const_cast<CharT*>(c_str());
+    const size_type tail = len - pos - count;
+    if (count2 <= count)
+    {
+        Traits::move(p + pos, str, count2);
+        Traits::move(p + pos + count2, p + pos + count, tail);
+    }
+    else
+    {
+        Traits::move(p + pos + count2, p + pos + count, tail);
+
+        // The characters of `str` that were in the tail have
+        // been shifted by `count2 - count`.
+        const CharT* split = p + pos + count;
+        if (std::less_equal<const CharT*>()(str + count2, split)
+         || std::less_equal<const CharT*>()(p + len, str))
+        {
+            Traits::move(p + pos, str, count2);
+        }
+        else if (std::less_equal<const CharT*>()(split, str))
+        {
+            Traits::copy(p + pos, str + (count2 - count), count2);
+        }
+        else
+        {
+            const size_type head = split - str;
+            Traits::move(p + pos, str, head);
+            Traits::copy(p + pos + head, p + pos + count2, count2 - head);
+        }
+    }
+    _set_length(new_len);
+    return *this;
+}
+
+template <typename CharT, typename Traits, typename Allocator>
+basic_string<CharT, Traits, Allocator>&
+basic_string<CharT, Traits, Allocator>::_replace_fill
+    ( basic_string::size_type pos
+    , basic_string::size_type count
+    , basic_string::size_type count2
+    , CharT ch
+    , const char* func )
+{
+    count = _replaced_count(pos, count, func);
+    const size_type len = length();
+    const size_type new_len = len - count + count2;
+    if (new_len > _capacity() || _shared())
+    {
+        data_type new_data = _new_data_with_gap(pos, count, count2);
+        Traits::assign(_str_of(new_data) + pos, count2, ch);
+        _set_data(new_data);
+        return *this;
+    }
+
+    CharT* p = const_cast<CharT*>(c_str());
+    Traits::move(p + pos + count2, p + pos + count, len - pos - count);
+    Traits::assign(p + pos, count2, ch);
+    _set_length(new_len);
+    return *this;
+}
+
 
 
 template< class CharT, class Traits, class Alloc >
@@ -1497,6 +2096,33 @@ inline bool operator>=( const CharT* lhs, const basic_string<CharT,Traits,Alloc>
     return rhs.compare(lhs) <= 0;
 }
 
+/**
+    Modifies the content of `s` by calling `f` with a `basic_string<CharT>&`,
+    and returns the result as a `basic_api_string`.
+
+    If `s` is the only reference to its memory, `f` edits it in place,
+    and no allocation happens unless the string grows beyond the capacity
+    of the block. Otherwise `s` is copied first. In both cases, `s` is
+    left empty.
+*/
+template <typename CharT, typename F>
+speudo_std::basic_api_string<CharT> edit(speudo_std::basic_api_string<CharT>&& s, F&& f)
+{
+    speudo_std::basic_string<CharT> str{std::move(s)};
+    s = speudo_std::basic_api_string<CharT>{};
+    std::forward<F>(f)(str);
+    // The conversion to `basic_api_string` is only implicitly applied
+    // to an rvalue since C++20 ( P1825 ), though some compilers do it
+    // in C++17 too, and then consider the move redundant.
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wredundant-move"
+#endif
+    return std::move(str);
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+}
 
 using string = basic_string<char>;
 using wstring = basic_string<wchar_t>;
@@ -1,20 +1,26 @@
 #include <detail/api_string_memory.hpp>
+#include "api_string_simd.hpp"
 #include <string> // char_traits
 #include <stdexcept>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
 	
 namespace speudo_std {
 
 #if defined(API_STRING_TEST_MODE)
 namespace api_string_test {
 
-static std::size_t& allocations_count_ref()
+static std::atomic<std::size_t>& allocations_count_ref()
 {
-    static std::size_t count = 0;
+    static std::atomic<std::size_t> count{0};
     return count;
 }
-static std::size_t& deallocations_count_ref()
+static std::atomic<std::size_t>& deallocations_count_ref()
 {
-    static std::size_t count = 0;
+    static std::atomic<std::size_t> count{0};
     return count;
 }
 void reset()
@@ -39,6 +45,8 @@ void report_deallocation()
     deallocations_count_ref()++;
 }
 
+static std::atomic<int> forced_find_isa{-1};
+
 } // namespace api_string_test
 
 #endif //defined(API_STRING_TEST_MODE)
@@ -50,6 +58,11 @@ void throw_std_out_of_range(const char* msg)
     throw std::out_of_range(msg);
 }
 
+void throw_std_invalid_argument(const char* msg)
+{
+    throw std::invalid_argument(msg);
+}
+
 std::size_t str_length(const char* str)
 {
     return std::char_traits<char>::length(str);
@@ -75,9 +88,13 @@ inline int do_compare
     , const CharT* rhs
     , std::size_t rhs_len)
 {
-    std::size_t min_len = lhs_len > rhs_len ? lhs_len : rhs_len;
+    std::size_t min_len = lhs_len < rhs_len ? lhs_len : rhs_len;
     int cmp = std::char_traits<CharT>::compare(lhs, rhs, min_len);
-    return cmp != 0 ? cmp : (lhs_len == rhs_len ? 0 : (lhs_len < rhs_len? -1 : +1));
+    if (cmp != 0)
+    {
+        return cmp < 0 ? -1 : +1;
+    }
+    return lhs_len == rhs_len ? 0 : (lhs_len < rhs_len? -1 : +1);
 }
 
 int str_compare
@@ -117,6 +134,523 @@ int str_compare
 }
 
 
+// ---------------------------------------------------------------------
+// find functions
+// ---------------------------------------------------------------------
+//
+// The characters are compared as unsigned integers of the same size,
+// so that `wchar_t` and `char32_t` share the same code. There are three
+// implementations: the portable one, one with SSE2 and one with AVX2.
+// The vectorized ones test a whole register of characters at a time
+// against a predicate ( the "classifier" ), and the substring search
+// first selects the positions where both the first and the last
+// characters of the searched string match.
+
+namespace {
+
+constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+template <typename U>
+inline bool equal_units(const U* a, const U* b, std::size_t count)
+{
+    return std::memcmp(a, b, count * sizeof(U)) == 0;
+}
+
+// A set of characters, with a bitmap for the ones lower than 256
+template <typename U>
+class char_set
+{
+public:
+
+    char_set(const U* s, std::size_t count)
+        : _str(s)
+        , _count(count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (s[i] < 256)
+            {
+                _bits[s[i] >> 6] |= std::uint64_t{1} << (s[i] & 63);
+            }
+            else
+            {
+                _has_wide = true;
+            }
+        }
+    }
+
+    bool contains(U ch) const
+    {
+        if (ch < 256)
+        {
+            return (_bits[ch >> 6] >> (ch & 63)) & 1;
+        }
+        return _has_wide
+            && std::char_traits<U>::find(_str, _count, ch) != nullptr;
+    }
+
+private:
+
+    const U* _str;
+    std::size_t _count;
+    std::uint64_t _bits[4] = {0, 0, 0, 0};
+    bool _has_wide = false;
+};
+
+// The portable implementation. `last` is the position of the last
+// character to be tested by the backward searches.
+
+template <typename U>
+std::size_t scalar_find_char(const U* str, std::size_t len, std::size_t pos, U ch)
+{
+    if constexpr (sizeof(U) == 1)
+    {
+        auto p = std::memchr(str + pos, ch, len - pos);
+        return p == nullptr ? npos : static_cast<const U*>(p) - str;
+    }
+    for (; pos < len; ++pos)
+    {
+        if (str[pos] == ch)
+        {
+            return pos;
+        }
+    }
+    return npos;
+}
+
+template <typename U>
+std::size_t scalar_rfind_char(const U* str, std::size_t, std::size_t last, U ch)
+{
+    for (std::size_t i = last + 1; i > 0; --i)
+    {
+        if (str[i - 1] == ch)
+        {
+            return i - 1;
+        }
+    }
+    return npos;
+}
+
+template <typename U>
+std::size_t scalar_find
+    ( const U* str, std::size_t len, std::size_t pos
+    , const U* s, std::size_t count )
+{
+    const std::size_t last_start = len - count;
+    while (pos <= last_start)
+    {
+        pos = scalar_find_char(str, last_start + 1, pos, s[0]);
+        if (pos == npos)
+        {
+            return npos;
+        }
+        if (equal_units(str + pos + 1, s + 1, count - 1))
+        {
+            return pos;
+        }
+        ++pos;
+    }
+    return npos;
+}
+
+template <typename U>
+std::size_t scalar_rfind
+    ( const U* str, std::size_t, std::size_t last_start
+    , const U* s, std::size_t count )
+{
+    for (std::size_t i = last_start + 1; i > 0; --i)
+    {
+        if (str[i - 1] == s[0] && equal_units(str + i, s + 1, count - 1))
+        {
+            return i - 1;
+        }
+    }
+    return npos;
+}
+
+template <typename U>
+std::size_t scalar_find_of
+    ( const U* str, std::size_t len, std::size_t pos
+    , const U* s, std::size_t count, bool negate )
+{
+    const char_set<U> set{s, count};
+    for (; pos < len; ++pos)
+    {
+        if (set.contains(str[pos]) != negate)
+        {
+            return pos;
+        }
+    }
+    return npos;
+}
+
+template <typename U>
+std::size_t scalar_rfind_of
+    ( const U* str, std::size_t, std::size_t last
+    , const U* s, std::size_t count, bool negate )
+{
+    const char_set<U> set{s, count};
+    for (std::size_t i = last + 1; i > 0; --i)
+    {
+        if (set.contains(str[i - 1]) != negate)
+        {
+            return i - 1;
+        }
+    }
+    return npos;
+}
+
+template <typename U>
+struct find_functions
+{
+    std::size_t (*find_char)(const U*, std::size_t, std::size_t, U);
+    std::size_t (*rfind_char)(const U*, std::size_t, std::size_t, U);
+    std::size_t (*find)(const U*, std::size_t, std::size_t, const U*, std::size_t);
+    std::size_t (*rfind)(const U*, std::size_t, std::size_t, const U*, std::size_t);
+    std::size_t (*find_of)(const U*, std::size_t, std::size_t, const U*, std::size_t, bool);
+    std::size_t (*rfind_of)(const U*, std::size_t, std::size_t, const U*, std::size_t, bool);
+};
+
+template <typename U>
+constexpr find_functions<U> scalar_find_functions =
+    { scalar_find_char<U>, scalar_rfind_char<U>
+    , scalar_find<U>, scalar_rfind<U>
+    , scalar_find_of<U>, scalar_rfind_of<U> };
+
+#if defined(SPEUDO_STD_SIMD_X86)
+
+// The sets of up to `max_simd_set_size` characters are
+// tested with one comparison per character
+constexpr std::size_t max_simd_set_size = 16;
+
+namespace sse2 {
+
+// `pshufb` is not part of SSE2
+constexpr bool has_byte_set_classifier = false;
+struct byte_set_classifier;
+
+#include "api_string_find.inc"
+#include "api_string_hash.inc"
+
+} // namespace sse2
+
+SPEUDO_STD_BEGIN_TARGET_AVX2
+
+namespace avx2 {
+
+// Tests any set of bytes with two table lookups ( `pshufb` ): the low
+// nibble of a byte selects a row of a 16x16 bitmap, in which the high
+// nibble selects the bit. The rows are split in two tables of 8 bits,
+// one for the bytes lower than 0x80 and one for the others.
+constexpr bool has_byte_set_classifier = true;
+
+struct byte_set_classifier
+{
+    __m256i low_rows;
+    __m256i high_rows;
+
+    byte_set_classifier(const std::uint8_t* s, std::size_t count)
+    {
+        alignas(16) std::uint8_t rows[2][16] = {};
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            rows[s[i] >> 7][s[i] & 0xF] |= static_cast<std::uint8_t>(1u << ((s[i] >> 4) & 7));
+        }
+        low_rows = _mm256_broadcastsi128_si256
+            ( _mm_load_si128(reinterpret_cast<const __m128i*>(rows[0])) );
+        high_rows = _mm256_broadcastsi128_si256
+            ( _mm_load_si128(reinterpret_cast<const __m128i*>(rows[1])) );
+    }
+
+    __m256i operator()(__m256i x) const
+    {
+        // `pshufb` yields zero where the index has its highest bit set
+        const __m256i index_mask = _mm256_set1_epi8(static_cast<char>(0x8F));
+        const __m256i high_bit = _mm256_set1_epi8(static_cast<char>(0x80));
+        const __m256i bits = _mm256_setr_epi8
+            ( 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128
+            , 1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128 );
+
+        __m256i row = _mm256_or_si256
+            ( _mm256_shuffle_epi8(low_rows, _mm256_and_si256(x, index_mask))
+            , _mm256_shuffle_epi8
+                ( high_rows
+                , _mm256_and_si256(_mm256_xor_si256(x, high_bit), index_mask) ) );
+        __m256i high_nibble = _mm256_and_si256
+            ( _mm256_srli_epi16(x, 4)
+            , _mm256_set1_epi8(0x07) );
+        __m256i bit = _mm256_shuffle_epi8(bits, high_nibble);
+        return _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), bit);
+    }
+};
+
+#include "api_string_find.inc"
+#include "api_string_hash.inc"
+
+} // namespace avx2
+
+SPEUDO_STD_END_TARGET
+
+#endif // defined(SPEUDO_STD_SIMD_X86)
+
+} // unnamed namespace
+
+static int best_simd_isa()
+{
+#if defined(SPEUDO_STD_SIMD_X86)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? 2 : 1;
+#else
+    return 0;
+#endif
+}
+
+int selected_simd_isa()
+{
+    static const int best = best_simd_isa();
+#if defined(API_STRING_TEST_MODE)
+    int forced = speudo_std::api_string_test::forced_find_isa;
+    if (forced >= 0 && forced < best)
+    {
+        return forced;
+    }
+#endif
+    return best;
+}
+
+namespace {
+
+template <typename U>
+const find_functions<U>& get_find_functions()
+{
+#if defined(SPEUDO_STD_SIMD_X86)
+    switch (selected_simd_isa())
+    {
+        case 2: return avx2::functions<U>;
+        case 1: return sse2::functions<U>;
+    }
+#endif
+    return scalar_find_functions<U>;
+}
+
+// The blocks are hashed by the vectorized functions, which read the
+// code units as little endian integers, like `hash_word`.
+template <typename CharT>
+std::uint64_t do_hash(const CharT* str, std::size_t len)
+{
+#if defined(SPEUDO_STD_SIMD_X86)
+    const std::size_t blocks = len * sizeof(CharT) / hash_block_size;
+    const int isa = selected_simd_isa();
+    if (blocks != 0 && isa != 0)
+    {
+        std::uint64_t acc[4] = { hash_lane_keys[0], hash_lane_keys[1]
+                               , hash_lane_keys[2], hash_lane_keys[3] };
+        const auto* bytes = reinterpret_cast<const unsigned char*>(str);
+        if (isa == 2)
+        {
+            avx2::hash_blocks(bytes, blocks, acc);
+        }
+        else
+        {
+            sse2::hash_blocks(bytes, blocks, acc);
+        }
+        return lanes_hash_finish(acc, str, len, blocks * hash_block_size / sizeof(CharT));
+    }
+#endif
+    return speudo_std::_detail::lanes_hash(str, len);
+}
+
+} // unnamed namespace
+
+std::uint64_t str_hash(const char* str, std::size_t len)
+{
+    return do_hash(str, len);
+}
+std::uint64_t str_hash(const wchar_t* str, std::size_t len)
+{
+    return do_hash(str, len);
+}
+std::uint64_t str_hash(const char16_t* str, std::size_t len)
+{
+    return do_hash(str, len);
+}
+std::uint64_t str_hash(const char32_t* str, std::size_t len)
+{
+    return do_hash(str, len);
+}
+
+template <typename CharT>
+std::size_t str_find
+    ( const CharT* str, std::size_t len
+    , const CharT* s, std::size_t pos, std::size_t count ) noexcept
+{
+    if (pos > len || count > len - pos)
+    {
+        return npos;
+    }
+    if (count == 0)
+    {
+        return pos;
+    }
+    auto& f = get_find_functions<code_unit<CharT>>();
+    if (count == 1)
+    {
+        return f.find_char(to_code_units(str), len, pos, to_code_units(s)[0]);
+    }
+    return f.find(to_code_units(str), len, pos, to_code_units(s), count);
+}
+
+template <typename CharT>
+std::size_t str_find
+    ( const CharT* str, std::size_t len
+    , CharT ch, std::size_t pos ) noexcept
+{
+    if (pos >= len)
+    {
+        return npos;
+    }
+    return get_find_functions<code_unit<CharT>>().find_char
+        ( to_code_units(str), len, pos, static_cast<code_unit<CharT>>(ch) );
+}
+
+template <typename CharT>
+std::size_t str_rfind
+    ( const CharT* str, std::size_t len
+    , const CharT* s, std::size_t pos, std::size_t count ) noexcept
+{
+    if (count > len)
+    {
+        return npos;
+    }
+    const std::size_t last_start = std::min(pos, len - count);
+    if (count == 0)
+    {
+        return last_start;
+    }
+    auto& f = get_find_functions<code_unit<CharT>>();
+    if (count == 1)
+    {
+        return f.rfind_char(to_code_units(str), len, last_start, to_code_units(s)[0]);
+    }
+    return f.rfind(to_code_units(str), len, last_start, to_code_units(s), count);
+}
+
+template <typename CharT>
+std::size_t str_rfind
+    ( const CharT* str, std::size_t len
+    , CharT ch, std::size_t pos ) noexcept
+{
+    if (len == 0)
+    {
+        return npos;
+    }
+    return get_find_functions<code_unit<CharT>>().rfind_char
+        ( to_code_units(str), len, std::min(pos, len - 1)
+        , static_cast<code_unit<CharT>>(ch) );
+}
+
+template <typename CharT>
+std::size_t str_find_first_of
+    ( const CharT* str, std::size_t len
+    , const CharT* s, std::size_t pos, std::size_t count ) noexcept
+{
+    if (pos >= len || count == 0)
+    {
+        return npos;
+    }
+    return get_find_functions<code_unit<CharT>>().find_of
+        ( to_code_units(str), len, pos, to_code_units(s), count, false );
+}
+
+template <typename CharT>
+std::size_t str_find_first_not_of
+    ( const CharT* str, std::size_t len
+    , const CharT* s, std::size_t pos, std::size_t count ) noexcept
+{
+    if (pos >= len)
+    {
+        return npos;
+    }
+    if (count == 0)
+    {
+        return pos;
+    }
+    return get_find_functions<code_unit<CharT>>().find_of
+        ( to_code_units(str), len, pos, to_code_units(s), count, true );
+}
+
+template <typename CharT>
+std::size_t str_find_last_of
+    ( const CharT* str, std::size_t len
+    , const CharT* s, std::size_t pos, std::size_t count ) noexcept
+{
+    if (len == 0 || count == 0)
+    {
+        return npos;
+    }
+    return get_find_functions<code_unit<CharT>>().rfind_of
+        ( to_code_units(str), len, std::min(pos, len - 1)
+        , to_code_units(s), count, false );
+}
+
+template <typename CharT>
+std::size_t str_find_last_not_of
+    ( const CharT* str, std::size_t len
+    , const CharT* s, std::size_t pos, std::size_t count ) noexcept
+{
+    if (len == 0)
+    {
+        return npos;
+    }
+    const std::size_t last = std::min(pos, len - 1);
+    if (count == 0)
+    {
+        return last;
+    }
+    return get_find_functions<code_unit<CharT>>().rfind_of
+        ( to_code_units(str), len, last, to_code_units(s), count, true );
+}
+
+#define SPEUDO_STD_INSTANTIATE_FIND(CHAR_T)                                   \
+    template std::size_t str_find<CHAR_T>                                     \
+        (const CHAR_T*, std::size_t, const CHAR_T*, std::size_t, std::size_t) noexcept; \
+    template std::size_t str_find<CHAR_T>                                     \
+        (const CHAR_T*, std::size_t, CHAR_T, std::size_t) noexcept;           \
+    template std::size_t str_rfind<CHAR_T>                                    \
+        (const CHAR_T*, std::size_t, const CHAR_T*, std::size_t, std::size_t) noexcept; \
+    template std::size_t str_rfind<CHAR_T>                                    \
+        (const CHAR_T*, std::size_t, CHAR_T, std::size_t) noexcept;           \
+    template std::size_t str_find_first_of<CHAR_T>                            \
+        (const CHAR_T*, std::size_t, const CHAR_T*, std::size_t, std::size_t) noexcept; \
+    template std::size_t str_find_first_not_of<CHAR_T>                        \
+        (const CHAR_T*, std::size_t, const CHAR_T*, std::size_t, std::size_t) noexcept; \
+    template std::size_t str_find_last_of<CHAR_T>                             \
+        (const CHAR_T*, std::size_t, const CHAR_T*, std::size_t, std::size_t) noexcept; \
+    template std::size_t str_find_last_not_of<CHAR_T>                         \
+        (const CHAR_T*, std::size_t, const CHAR_T*, std::size_t, std::size_t) noexcept;
+
+SPEUDO_STD_INSTANTIATE_FIND(char)
+SPEUDO_STD_INSTANTIATE_FIND(wchar_t)
+SPEUDO_STD_INSTANTIATE_FIND(char16_t)
+SPEUDO_STD_INSTANTIATE_FIND(char32_t)
+
+#undef SPEUDO_STD_INSTANTIATE_FIND
+
+} // namespace _detail
+
+#if defined(API_STRING_TEST_MODE)
+
+int api_string_test::force_find_isa(int level)
+{
+    forced_find_isa = level;
+    return speudo_std::_detail::selected_simd_isa();
+}
+
+#endif // defined(API_STRING_TEST_MODE)
+
+namespace _detail {
+
+
 template class api_string_mem<std::allocator<char>>;
 template class api_string_mem<std::allocator<char16_t>>;
 template class api_string_mem<std::allocator<char32_t>>;
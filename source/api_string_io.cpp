@@ -0,0 +1,366 @@
+#include <api_string_io.hpp>
+#include <detail/api_string_memory.hpp>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace speudo_std {
+
+namespace _detail {
+
+namespace {
+
+class mapped_file_mem: public speudo_std::abi::api_string_mem_base
+{
+public:
+
+    mapped_file_mem(void* addr, std::size_t map_len)
+        : speudo_std::abi::api_string_mem_base{get_table()}
+        , _addr(addr)
+        , _map_len(map_len)
+    {
+    }
+
+private:
+
+    std::atomic<std::size_t> _refcount{1};
+    void* _addr;
+    std::size_t _map_len;
+
+    static std::size_t acquire(api_string_mem_base* mem_base)
+    {
+        auto* self = static_cast<mapped_file_mem*>(mem_base);
+        return self->_refcount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void release(api_string_mem_base* mem_base)
+    {
+        auto* self = static_cast<mapped_file_mem*>(mem_base);
+        if (self->_refcount.fetch_sub(1, std::memory_order_release) == 1) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            ::munmap(self->_addr, self->_map_len);
+            delete self;
+        }
+    }
+
+    // The mapping is read-only, so the content must never be
+    // taken over and modified in place, as `basic_string` does
+    // with unique strings.
+    static bool unique(api_string_mem_base*)
+    {
+        return false;
+    }
+
+    static std::byte* begin(api_string_mem_base* mem_base)
+    {
+        return static_cast<std::byte*>(static_cast<mapped_file_mem*>(mem_base)->_addr);
+    }
+
+    static std::byte* end(api_string_mem_base* mem_base)
+    {
+        auto* self = static_cast<mapped_file_mem*>(mem_base);
+        return static_cast<std::byte*>(self->_addr) + self->_map_len;
+    }
+
+    static const speudo_std::abi::api_string_func_table* get_table()
+    {
+        static const speudo_std::abi::api_string_func_table table =
+            {0, acquire, release, unique, begin, end};
+        return & table;
+    }
+};
+
+class file_descriptor
+{
+public:
+    explicit file_descriptor(int fd) : _fd(fd) {}
+    file_descriptor(const file_descriptor&) = delete;
+    ~file_descriptor()
+    {
+        if (_fd >= 0)
+        {
+            ::close(_fd);
+        }
+    }
+    int get() const { return _fd; }
+
+private:
+    int _fd;
+};
+
+[[noreturn]] void throw_system_error(const char* what)
+{
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+std::size_t read_fd(void* source, char* buff, std::size_t count)
+{
+    int fd = static_cast<int>(reinterpret_cast<std::intptr_t>(source));
+    for(;;)
+    {
+        ssize_t n = ::read(fd, buff, count);
+        if (n >= 0)
+        {
+            return static_cast<std::size_t>(n);
+        }
+        if (errno != EINTR)
+        {
+            throw_system_error("read");
+        }
+    }
+}
+
+// Reads what the stream buffer already holds, or else waits for at
+// least one character, but not for the chunk to be full, since the
+// input may be interactive. At the end of the input, the state of the
+// stream is cleared, so that the reading resumes if the source grows.
+std::size_t read_istream(void* source, char* buff, std::size_t count)
+{
+    auto& is = *static_cast<std::istream*>(source);
+    std::streamsize n = is.readsome(buff, static_cast<std::streamsize>(count));
+    if (n == 0 && is.good())
+    {
+        is.read(buff, 1);
+        n = is.gcount();
+        if (n != 0 && count > 1)
+        {
+            n += is.readsome(buff + 1, static_cast<std::streamsize>(count - 1));
+        }
+    }
+    if (is.bad())
+    {
+        throw std::system_error(std::make_error_code(std::errc::io_error), "istream::read");
+    }
+    if (n == 0 && is.eof())
+    {
+        is.clear();
+    }
+    return static_cast<std::size_t>(n);
+}
+
+} // unnamed namespace
+
+std::size_t writev_all(int fd, ::iovec* iov, std::size_t count, long long offset)
+{
+#if defined(IOV_MAX)
+    constexpr std::size_t max_chunk = IOV_MAX;
+#else
+    constexpr std::size_t max_chunk = 1024;
+#endif
+
+    std::size_t total = 0;
+    while (count != 0)
+    {
+        int chunk = static_cast<int>(count < max_chunk ? count : max_chunk);
+        ssize_t n = offset < 0
+            ? ::writev(fd, iov, chunk)
+            : ::pwritev(fd, iov, chunk, static_cast<off_t>(offset + total));
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw_system_error("writev");
+        }
+        total += static_cast<std::size_t>(n);
+
+        // skip what has been written, and adjust a partially written element
+        std::size_t written = static_cast<std::size_t>(n);
+        while (count != 0 && written >= iov->iov_len)
+        {
+            written -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if (written != 0)
+        {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+            iov->iov_len -= written;
+        }
+    }
+    return total;
+}
+
+} // namespace _detail
+
+api_string_line_reader::api_string_line_reader(int fd, std::size_t chunk_size)
+    : _read(_detail::read_fd)
+    , _source(reinterpret_cast<void*>(static_cast<std::intptr_t>(fd)))
+    , _chunk_size(chunk_size > 0 ? chunk_size : 1)
+{
+}
+
+api_string_line_reader::api_string_line_reader(std::istream& is, std::size_t chunk_size)
+    : _read(_detail::read_istream)
+    , _source(&is)
+    , _chunk_size(chunk_size > 0 ? chunk_size : 1)
+{
+}
+
+api_string_line_reader::~api_string_line_reader()
+{
+    if (_current.manager != nullptr)
+    {
+        _current.manager->release();
+    }
+    if (_spare.manager != nullptr)
+    {
+        _spare.manager->release();
+    }
+}
+
+bool api_string_line_reader::getline(speudo_std::api_string& line)
+{
+    auto make_line = [this](char* begin, char* end)
+    {
+        if (end != begin && end[-1] == '\r')
+        {
+            -- end;
+        }
+        *end = '\0';
+        std::size_t len = end - begin;
+        if (len <= speudo_std::abi::api_string_data<char>::small_capacity())
+        {
+            return speudo_std::api_string{begin, len};
+        }
+        _current.manager->acquire();
+        return _detail::basic_string_helper::adopt<char>(_current.manager, begin, len);
+    };
+
+    std::size_t scanned = 0;
+    for(;;)
+    {
+        // memchr is vectorized by the standard library on the relevant platforms
+        char* nl = _begin + scanned == _end ? nullptr : static_cast<char*>
+            ( std::memchr(_begin + scanned, '\n', (_end - _begin) - scanned) );
+        if (nl != nullptr)
+        {
+            line = make_line(_begin, nl);
+            _begin = nl + 1;
+            return true;
+        }
+        scanned = _end - _begin;
+        if ( ! _refill())
+        {
+            if (_begin == _end)
+            {
+                return false;
+            }
+            line = make_line(_begin, _end);
+            // the null terminator of `line` is at `_end`, so the input
+            // read afterwards, if the source grows, goes after it
+            _begin = _end = _end + 1;
+            return true;
+        }
+    }
+}
+
+bool api_string_line_reader::_refill()
+{
+    if (_end >= _current.end)
+    {
+        std::size_t pending = _end - _begin;
+        std::size_t required = pending < _chunk_size / 2 ? _chunk_size : 2 * pending;
+        if ( _current.manager != nullptr
+          && pending < _chunk_size / 2
+          && _current.manager->unique() )
+        {
+            // the lines that referenced the chunk may have left an index of
+            // their content ( see `api_string_code_points.hpp` )
+            _current.manager->drop_aux();
+            std::memmove(_current.begin, _begin, pending);
+        }
+        else
+        {
+            if ( _spare.manager == nullptr
+              || static_cast<std::size_t>(_spare.end - _spare.begin) < required
+              || ! _spare.manager->unique() )
+            {
+                using mem_type = _detail::api_string_mem<std::allocator<char>>;
+                auto m = mem_type::create(std::allocator<char>{}, required + 1);
+                if (_spare.manager != nullptr)
+                {
+                    _spare.manager->release();
+                }
+                char* begin = reinterpret_cast<char*>(m.pool);
+                _spare = _chunk{m.manager, begin, begin + (m.pool_size - 1)};
+            }
+            else
+            {
+                _spare.manager->drop_aux();
+            }
+            if (pending != 0)
+            {
+                std::memcpy(_spare.begin, _begin, pending);
+            }
+            std::swap(_current, _spare);
+        }
+        _begin = _current.begin;
+        _end = _current.begin + pending;
+    }
+    std::size_t n = _read(_source, _end, _current.end - _end);
+    _end += n;
+    return n != 0;
+}
+
+speudo_std::api_string map_file(const char* path)
+{
+    _detail::file_descriptor fd{::open(path, O_RDONLY | O_CLOEXEC)};
+    if (fd.get() < 0)
+    {
+        _detail::throw_system_error(path);
+    }
+    struct stat st;
+    if (::fstat(fd.get(), &st) != 0)
+    {
+        _detail::throw_system_error(path);
+    }
+    std::size_t size = static_cast<std::size_t>(st.st_size);
+    if (size == 0)
+    {
+        return {};
+    }
+
+    // Reserve at least one extra zero-filled byte after the content,
+    // so that the string is null-terminated.
+    std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    std::size_t map_len = (size / page + 1) * page;
+    void* addr = ::mmap( nullptr, map_len, PROT_READ
+                       , MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if (addr == MAP_FAILED)
+    {
+        _detail::throw_system_error(path);
+    }
+    if ( ::mmap(addr, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd.get(), 0)
+      == MAP_FAILED )
+    {
+        int err = errno;
+        ::munmap(addr, map_len);
+        throw std::system_error(err, std::generic_category(), path);
+    }
+
+    speudo_std::abi::api_string_mem_base* manager;
+    try
+    {
+        manager = new _detail::mapped_file_mem(addr, map_len);
+    }
+    catch(...)
+    {
+        ::munmap(addr, map_len);
+        throw;
+    }
+    return speudo_std::_detail::basic_string_helper::adopt
+        ( manager, static_cast<const char*>(addr), size );
+}
+
+} // namespace speudo_std
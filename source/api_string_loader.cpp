@@ -0,0 +1,595 @@
+#include <api_string_io.hpp>
+#include <detail/api_string_memory.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define SPEUDO_STD_HAS_IO_URING 1
+#endif
+
+namespace speudo_std {
+
+namespace _detail {
+
+namespace {
+
+using file_memory = speudo_std::_detail::api_string_mem<std::allocator<char>>;
+
+std::error_code last_error()
+{
+    return std::error_code(errno, std::generic_category());
+}
+
+/**
+    A file opened and a memory block allocated for its content
+*/
+struct file_read
+{
+    std::size_t index = 0;
+    int fd = -1;
+    file_memory::memory mem = {};
+    std::size_t size = 0;
+    std::size_t done = 0;
+
+    char* buffer() const
+    {
+        return reinterpret_cast<char*>(mem.pool);
+    }
+
+    void close()
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    void discard()
+    {
+        close();
+        if (mem.manager != nullptr)
+        {
+            mem.manager->release();
+            mem = {};
+        }
+    }
+
+    speudo_std::api_string finish()
+    {
+        close();
+        if (mem.manager == nullptr)
+        {
+            return {};
+        }
+        char* str = buffer();
+        str[done] = '\0';
+        auto manager = mem.manager;
+        mem = {};
+        return basic_string_helper::adopt(manager, str, done);
+    }
+};
+
+/**
+    Opens the file and allocates the memory. Returns false on failure.
+    An empty file gets no memory.
+*/
+bool open_file(const speudo_std::api_string& path, file_read& f, std::error_code& err)
+{
+    f.fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (f.fd < 0)
+    {
+        err = last_error();
+        return false;
+    }
+    struct stat st;
+    if (::fstat(f.fd, &st) != 0)
+    {
+        err = last_error();
+        f.close();
+        return false;
+    }
+    f.size = static_cast<std::size_t>(st.st_size);
+    f.done = 0;
+    if (f.size != 0)
+    {
+        try
+        {
+            f.mem = file_memory::create(std::allocator<char>{}, f.size + 1);
+        }
+        catch (const std::bad_alloc&)
+        {
+            err = std::make_error_code(std::errc::not_enough_memory);
+            f.close();
+            return false;
+        }
+    }
+    return true;
+}
+
+struct load_context
+{
+    const speudo_std::api_string* paths;
+    speudo_std::api_string* contents;
+    std::error_code* errors;
+};
+
+void load_one(const load_context& ctx, std::size_t i)
+{
+    file_read f;
+    f.index = i;
+    if ( ! open_file(ctx.paths[i], f, ctx.errors[i]))
+    {
+        return;
+    }
+    while (f.done < f.size)
+    {
+        ssize_t n = ::pread(f.fd, f.buffer() + f.done, f.size - f.done, f.done);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            ctx.errors[i] = last_error();
+            f.discard();
+            return;
+        }
+        if (n == 0)
+        {
+            break; // the file has been truncated meanwhile
+        }
+        f.done += static_cast<std::size_t>(n);
+    }
+    ctx.contents[i] = f.finish();
+}
+
+/**
+    Loads the files `indices[0, count)`, or `[0, count)` if `indices` is null
+*/
+void load_with_thread_pool
+    ( const load_context& ctx
+    , const std::size_t* indices
+    , std::size_t count
+    , unsigned threads )
+{
+    if (threads == 0)
+    {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (threads > count)
+    {
+        threads = static_cast<unsigned>(count);
+    }
+    std::atomic<std::size_t> next{0};
+    auto worker = [&]()
+    {
+        for ( std::size_t i = next.fetch_add(1, std::memory_order_relaxed)
+            ; i < count
+            ; i = next.fetch_add(1, std::memory_order_relaxed) )
+        {
+            load_one(ctx, indices != nullptr ? indices[i] : i);
+        }
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(threads > 0 ? threads - 1 : 0);
+    try
+    {
+        for (unsigned t = 1; t < threads; ++t)
+        {
+            pool.emplace_back(worker);
+        }
+    }
+    catch (const std::system_error&)
+    {
+        // proceed with the threads that could be created
+    }
+    worker();
+    for (auto& t : pool)
+    {
+        t.join();
+    }
+}
+
+#if defined(SPEUDO_STD_HAS_IO_URING)
+
+/**
+    A minimal io_uring submission and completion queue, used only to
+    issue IORING_OP_READ requests
+*/
+class io_uring_queue
+{
+public:
+
+    io_uring_queue() = default;
+    io_uring_queue(const io_uring_queue&) = delete;
+
+    ~io_uring_queue()
+    {
+        if (_sqes != nullptr)
+        {
+            ::munmap(_sqes, _sqes_len);
+        }
+        if (_cq_ptr != nullptr && _cq_ptr != _sq_ptr)
+        {
+            ::munmap(_cq_ptr, _cq_len);
+        }
+        if (_sq_ptr != nullptr)
+        {
+            ::munmap(_sq_ptr, _sq_len);
+        }
+        if (_fd >= 0)
+        {
+            ::close(_fd);
+        }
+    }
+
+    std::error_code init(unsigned entries)
+    {
+        io_uring_params p;
+        std::memset(&p, 0, sizeof(p));
+        _fd = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &p));
+        if (_fd < 0)
+        {
+            return last_error();
+        }
+        _sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        _cq_len = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        bool single_mmap = p.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap)
+        {
+            _sq_len = _cq_len = std::max(_sq_len, _cq_len);
+        }
+        _sq_ptr = map(_sq_len, IORING_OFF_SQ_RING);
+        if (_sq_ptr == nullptr)
+        {
+            return last_error();
+        }
+        if (single_mmap)
+        {
+            _cq_ptr = _sq_ptr;
+        }
+        else if ((_cq_ptr = map(_cq_len, IORING_OFF_CQ_RING)) == nullptr)
+        {
+            return last_error();
+        }
+        _sqes_len = p.sq_entries * sizeof(io_uring_sqe);
+        _sqes = static_cast<io_uring_sqe*>(map(_sqes_len, IORING_OFF_SQES));
+        if (_sqes == nullptr)
+        {
+            return last_error();
+        }
+
+        char* sq = static_cast<char*>(_sq_ptr);
+        _sq_tail  = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+        _sq_mask  = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+        _sq_array = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+        _sq_entries = p.sq_entries;
+
+        char* cq = static_cast<char*>(_cq_ptr);
+        _cq_head = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+        _cq_tail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+        _cq_mask = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+        _cqes    = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+        return probe_read();
+    }
+
+    unsigned capacity() const
+    {
+        return _sq_entries;
+    }
+
+    void prepare_read(int fd, void* buff, std::size_t len, std::uint64_t offset, std::uint64_t user_data)
+    {
+        unsigned tail = *_sq_tail + _to_submit;
+        unsigned idx = tail & _sq_mask;
+        io_uring_sqe* sqe = &_sqes[idx];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = fd;
+        sqe->addr = reinterpret_cast<std::uint64_t>(buff);
+        sqe->len = static_cast<unsigned>(std::min<std::size_t>(len, 1u << 30));
+        sqe->off = offset;
+        sqe->user_data = user_data;
+        _sq_array[idx] = idx;
+        ++ _to_submit;
+    }
+
+    /**
+        Submits the prepared requests and waits for at least one completion.
+        The requests that the kernel did not consume are submitted again
+        on the next call, since they stay in the submission queue.
+    */
+    std::error_code submit_and_wait()
+    {
+        __atomic_store_n(_sq_tail, *_sq_tail + _to_submit, __ATOMIC_RELEASE);
+        _unsubmitted += _to_submit;
+        _to_submit = 0;
+        for(;;)
+        {
+            long r = ::syscall( __NR_io_uring_enter, _fd, _unsubmitted, 1u
+                              , IORING_ENTER_GETEVENTS, nullptr, 0 );
+            if (r >= 0)
+            {
+                // on a short submission, the kernel returns without waiting
+                _unsubmitted -= static_cast<unsigned>(r);
+                return {};
+            }
+            if (errno != EINTR)
+            {
+                return last_error();
+            }
+        }
+    }
+
+    template <typename F>
+    void for_each_completion(F f)
+    {
+        unsigned head = *_cq_head;
+        unsigned tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head)
+        {
+            const io_uring_cqe& cqe = _cqes[head & _cq_mask];
+            f(cqe.user_data, cqe.res);
+        }
+        __atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+    }
+
+private:
+
+    /**
+        IORING_OP_READ comes with Linux 5.6, like IORING_REGISTER_PROBE.
+        On the kernels that have io_uring but not this opcode, each read
+        would fail with EINVAL, so io_uring is considered unavailable.
+    */
+    std::error_code probe_read()
+    {
+        constexpr unsigned ops_count = IORING_OP_READ + 1;
+        alignas(io_uring_probe) char buff
+            [sizeof(io_uring_probe) + ops_count * sizeof(io_uring_probe_op)] = {};
+        auto* probe = reinterpret_cast<io_uring_probe*>(buff);
+        if (::syscall(__NR_io_uring_register, _fd, IORING_REGISTER_PROBE, probe, ops_count) != 0)
+        {
+            return errno == EINVAL
+                ? std::make_error_code(std::errc::function_not_supported)
+                : last_error();
+        }
+        if ( probe->last_op < IORING_OP_READ
+          || ! (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) )
+        {
+            return std::make_error_code(std::errc::function_not_supported);
+        }
+        return {};
+    }
+
+    void* map(std::size_t len, off_t offset)
+    {
+        void* p = ::mmap( nullptr, len, PROT_READ | PROT_WRITE
+                        , MAP_SHARED | MAP_POPULATE, _fd, offset );
+        return p == MAP_FAILED ? nullptr : p;
+    }
+
+    int _fd = -1;
+    void* _sq_ptr = nullptr;
+    void* _cq_ptr = nullptr;
+    std::size_t _sq_len = 0;
+    std::size_t _cq_len = 0;
+    io_uring_sqe* _sqes = nullptr;
+    std::size_t _sqes_len = 0;
+
+    unsigned* _sq_tail = nullptr;
+    unsigned _sq_mask = 0;
+    unsigned* _sq_array = nullptr;
+    unsigned _sq_entries = 0;
+    unsigned _to_submit = 0;
+    unsigned _unsubmitted = 0;
+
+    unsigned* _cq_head = nullptr;
+    unsigned* _cq_tail = nullptr;
+    unsigned _cq_mask = 0;
+    io_uring_cqe* _cqes = nullptr;
+};
+
+/**
+    Returns an error only if io_uring could not be initialized, in which
+    case nothing has been done. If io_uring fails later, the files that
+    are not loaded get its error, and their indices are put in `unfinished`.
+*/
+std::error_code load_with_io_uring
+    ( const load_context& ctx
+    , std::size_t count
+    , unsigned depth
+    , std::vector<std::size_t>& unfinished )
+{
+    io_uring_queue ring;
+    if (auto err = ring.init(std::max(1u, std::min(depth, 4096u))))
+    {
+        return err;
+    }
+    std::vector<file_read> slots(ring.capacity());
+    std::vector<unsigned> free_slots;
+    free_slots.reserve(slots.size());
+    for (unsigned i = slots.size(); i > 0; --i)
+    {
+        free_slots.push_back(i - 1);
+    }
+
+    auto submit = [&](unsigned slot)
+    {
+        file_read& f = slots[slot];
+        ring.prepare_read(f.fd, f.buffer() + f.done, f.size - f.done, f.done, slot);
+    };
+    auto complete = [&](unsigned slot)
+    {
+        ctx.contents[slots[slot].index] = slots[slot].finish();
+        free_slots.push_back(slot);
+    };
+
+    std::size_t next = 0;
+    std::size_t in_flight = 0;
+    while (next < count || in_flight != 0)
+    {
+        while (next < count && ! free_slots.empty())
+        {
+            unsigned slot = free_slots.back();
+            file_read& f = slots[slot];
+            f.index = next;
+            if (open_file(ctx.paths[next], f, ctx.errors[next]))
+            {
+                free_slots.pop_back();
+                if (f.size == 0)
+                {
+                    complete(slot);
+                }
+                else
+                {
+                    submit(slot);
+                    ++ in_flight;
+                }
+            }
+            ++ next;
+        }
+        if (in_flight == 0)
+        {
+            continue;
+        }
+        if (auto err = ring.submit_and_wait())
+        {
+            // The requests already submitted may still be running, so their
+            // buffers are intentionally leaked rather than deallocated.
+            for (auto& f : slots)
+            {
+                if (f.fd >= 0)
+                {
+                    ctx.errors[f.index] = err;
+                    unfinished.push_back(f.index);
+                    f.close();
+                }
+            }
+            for (; next < count; ++next)
+            {
+                ctx.errors[next] = err;
+                unfinished.push_back(next);
+            }
+            return {};
+        }
+        ring.for_each_completion([&](std::uint64_t slot, int res)
+        {
+            file_read& f = slots[slot];
+            if (res == -EINTR || res == -EAGAIN)
+            {
+                submit(slot);
+            }
+            else if (res < 0)
+            {
+                ctx.errors[f.index] = std::error_code(-res, std::generic_category());
+                f.discard();
+                free_slots.push_back(slot);
+                -- in_flight;
+            }
+            else
+            {
+                f.done += static_cast<std::size_t>(res);
+                if (res != 0 && f.done < f.size)
+                {
+                    submit(slot);
+                }
+                else
+                {
+                    complete(slot);
+                    -- in_flight;
+                }
+            }
+        });
+    }
+    return {};
+}
+
+#endif // defined(SPEUDO_STD_HAS_IO_URING)
+
+} // unnamed namespace
+
+} // namespace _detail
+
+void load_files
+    ( const speudo_std::api_string* paths
+    , std::size_t count
+    , speudo_std::api_string* contents
+    , std::error_code* errors
+    , const speudo_std::file_loader_options& options )
+{
+    std::vector<std::error_code> local_errors;
+    if (errors == nullptr)
+    {
+        local_errors.resize(count);
+        errors = local_errors.data();
+    }
+    else
+    {
+        std::fill(errors, errors + count, std::error_code{});
+    }
+    if (count == 0)
+    {
+        return;
+    }
+
+    _detail::load_context ctx{paths, contents, errors};
+    bool done = false;
+
+#if defined(SPEUDO_STD_HAS_IO_URING)
+    if (options.backend != file_loader_backend::thread_pool)
+    {
+        std::vector<std::size_t> unfinished;
+        auto err = _detail::load_with_io_uring(ctx, count, options.queue_depth, unfinished);
+        done = ! err;
+        if (err && options.backend == file_loader_backend::io_uring)
+        {
+            throw std::system_error(err, "io_uring");
+        }
+        if ( ! unfinished.empty() && options.backend == file_loader_backend::automatic)
+        {
+            for (std::size_t i : unfinished)
+            {
+                errors[i].clear();
+            }
+            _detail::load_with_thread_pool
+                ( ctx, unfinished.data(), unfinished.size(), options.threads );
+        }
+    }
+#else
+    if (options.backend == file_loader_backend::io_uring)
+    {
+        throw std::system_error
+            ( std::make_error_code(std::errc::function_not_supported)
+            , "io_uring" );
+    }
+#endif
+
+    if ( ! done)
+    {
+        _detail::load_with_thread_pool(ctx, nullptr, count, options.threads);
+    }
+
+    if ( ! local_errors.empty())
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (local_errors[i])
+            {
+                throw std::system_error(local_errors[i], paths[i].c_str());
+            }
+        }
+    }
+}
+
+} // namespace speudo_std
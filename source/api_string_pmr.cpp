@@ -0,0 +1,60 @@
+#include <api_string_pmr.hpp>
+
+namespace speudo_std {
+namespace _detail {
+
+template class api_string_mem<std::pmr::polymorphic_allocator<char>>;
+template class api_string_mem<std::pmr::polymorphic_allocator<char16_t>>;
+template class api_string_mem<std::pmr::polymorphic_allocator<char32_t>>;
+template class api_string_mem<std::pmr::polymorphic_allocator<wchar_t>>;
+
+template <typename CharT>
+static void api_string_init_pmr
+    ( speudo_std::abi::api_string_data<CharT>& data
+    , const CharT* str
+    , std::size_t count
+    , std::pmr::memory_resource* resource )
+{
+    speudo_std::_detail::api_string_init_impl
+        < CharT, std::char_traits<CharT>, std::pmr::polymorphic_allocator<CharT> >
+        ( data, str, count, std::pmr::polymorphic_allocator<CharT>{resource} );
+}
+
+void api_string_init
+    ( speudo_std::abi::api_string_data<char>& data
+    , const char* str
+    , std::size_t count
+    , std::pmr::memory_resource* resource )
+{
+    api_string_init_pmr(data, str, count, resource);
+}
+
+void api_string_init
+    ( speudo_std::abi::api_string_data<char16_t>& data
+    , const char16_t* str
+    , std::size_t count
+    , std::pmr::memory_resource* resource )
+{
+    api_string_init_pmr(data, str, count, resource);
+}
+
+void api_string_init
+    ( speudo_std::abi::api_string_data<char32_t>& data
+    , const char32_t* str
+    , std::size_t count
+    , std::pmr::memory_resource* resource )
+{
+    api_string_init_pmr(data, str, count, resource);
+}
+
+void api_string_init
+    ( speudo_std::abi::api_string_data<wchar_t>& data
+    , const wchar_t* str
+    , std::size_t count
+    , std::pmr::memory_resource* resource )
+{
+    api_string_init_pmr(data, str, count, resource);
+}
+
+} // namespace _detail
+} // namespace speudo_std
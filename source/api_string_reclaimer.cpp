@@ -0,0 +1,152 @@
+#include <api_string_reclaimer.hpp>
+#include <new>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define SPEUDO_STD_HAS_FUTEX 1
+#endif
+
+namespace speudo_std {
+
+api_string_reclaimer::api_string_reclaimer(std::size_t min_bytes)
+    : _min_bytes(min_bytes < sizeof(_node) ? sizeof(_node) : min_bytes)
+{
+    _thread = std::thread([this]{ _run(); });
+}
+
+api_string_reclaimer::~api_string_reclaimer()
+{
+    _stop = true;
+    _wake();
+    _thread.join();
+}
+
+api_string_reclaimer& api_string_reclaimer::global()
+{
+    // never destroyed, since strings with static storage duration
+    // may still be released after it would be
+    static api_string_reclaimer* reclaimer = new api_string_reclaimer;
+    return *reclaimer;
+}
+
+void api_string_reclaimer::defer
+    ( void* ptr
+    , std::size_t count
+    , std::size_t bytes
+    , free_func free ) noexcept
+{
+    if ( bytes < _min_bytes
+      || reinterpret_cast<std::uintptr_t>(ptr) % alignof(_node) != 0 )
+    {
+        free(ptr, count);
+        return;
+    }
+    _pending.fetch_add(1, std::memory_order_relaxed);
+    _node* n = ::new (ptr) _node{nullptr, count, free};
+    _node* head = _head.load(std::memory_order_relaxed);
+    do
+    {
+        n->next = head;
+    }
+    while ( ! _head.compare_exchange_weak
+                ( head, n
+                , std::memory_order_release
+                , std::memory_order_relaxed ));
+
+    if (head == nullptr)
+    {
+        // the list was empty, so the reclaimer may be sleeping
+        _wake();
+    }
+}
+
+void api_string_reclaimer::drain()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _drained.wait(lock, [this]{ return _pending.load() == 0; });
+}
+
+void api_string_reclaimer::_run()
+{
+    while (true)
+    {
+        _node* list = _head.exchange(nullptr, std::memory_order_acquire);
+        if (list != nullptr)
+        {
+            std::size_t freed = 0;
+            while (list != nullptr)
+            {
+                _node n = *list;
+                list->~_node();
+                n.free(list, n.count);
+                list = n.next;
+                ++freed;
+            }
+            if (_pending.fetch_sub(freed) == freed)
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _drained.notify_all();
+            }
+            continue;
+        }
+        // `_wake` increments `_wake_seq` after pushing into the list,
+        // so that `_wait` returns immediately if it happens meanwhile
+        const std::uint32_t seq = _wake_seq.load();
+        if (_head.load() != nullptr)
+        {
+            continue;
+        }
+        if (_stop.load())
+        {
+            return;
+        }
+        _wait(seq);
+    }
+}
+
+#if defined(SPEUDO_STD_HAS_FUTEX)
+
+// std::atomic<std::uint32_t> has the size and the representation of the
+// 32-bit word expected by futex, like in the implementations of C++20's
+// std::atomic::wait.
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t), "");
+
+void api_string_reclaimer::_wait(std::uint32_t seq)
+{
+    // returns immediately if `_wake_seq` is no longer `seq`, and may also
+    // return spuriously ( EINTR ), which the loop of `_run` handles
+    ::syscall( SYS_futex, reinterpret_cast<std::uint32_t*>(&_wake_seq)
+             , FUTEX_WAIT_PRIVATE, seq, nullptr, nullptr, 0 );
+}
+
+void api_string_reclaimer::_wake() noexcept
+{
+    _wake_seq.fetch_add(1);
+    ::syscall( SYS_futex, reinterpret_cast<std::uint32_t*>(&_wake_seq)
+             , FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0 );
+}
+
+#else
+
+void api_string_reclaimer::_wait(std::uint32_t seq)
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _wake_up.wait(lock, [this, seq]{ return _wake_seq.load() != seq; });
+}
+
+void api_string_reclaimer::_wake() noexcept
+{
+    {
+        // so that the increment does not happen between the check of
+        // the predicate and the wait in `_wait`
+        std::lock_guard<std::mutex> lock(_mutex);
+        _wake_seq.fetch_add(1);
+    }
+    _wake_up.notify_one();
+}
+
+#endif // defined(SPEUDO_STD_HAS_FUTEX)
+
+} // namespace speudo_std
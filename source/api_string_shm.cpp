@@ -0,0 +1,458 @@
+#include <api_string_shm.hpp>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace speudo_std {
+
+namespace _detail {
+
+namespace {
+
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free);
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+constexpr std::uint64_t shm_magic = 0x6873'676e'6972'7473; // "strings" + 'h'
+constexpr unsigned shm_min_class = 5;   // 32 bytes
+constexpr unsigned shm_max_class = 40;  // 1 TiB
+constexpr unsigned shm_offset_bits = 40;
+constexpr std::uint64_t shm_offset_mask = (std::uint64_t(1) << shm_offset_bits) - 1;
+
+/**
+    The header at the beginning of the segment.
+    Freed blocks are kept in one lock-free list per size class.
+    The heads of the lists are tagged ( the bits above `shm_offset_bits` )
+    to avoid the ABA problem.
+*/
+struct shm_header
+{
+    std::uint64_t magic;
+    std::uint64_t size;
+    std::atomic<std::uint64_t> bump;
+    std::atomic<std::uint64_t> free_lists[shm_max_class + 1];
+};
+
+constexpr std::size_t shm_header_size = 512;
+static_assert(sizeof(shm_header) <= shm_header_size);
+
+/**
+    The header of each block. Its size is a power of two given by
+    `size_class`, and the string content comes right after the header.
+*/
+struct shm_block
+{
+    std::atomic<std::uint32_t> refcount;
+    std::uint16_t size_class;
+    std::uint16_t char_size;
+    std::uint64_t length;
+    std::atomic<std::uint64_t> next_free;
+    std::uint64_t reserved;
+};
+
+static_assert(sizeof(shm_block) == 32);
+
+[[noreturn]] void throw_system_error(const char* what)
+{
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+} // unnamed namespace
+
+struct shm_segment_state
+{
+    std::atomic<std::size_t> refcount{1};
+    char* base;
+    std::size_t size;
+    int fd;
+
+    shm_header& header() const
+    {
+        return *reinterpret_cast<shm_header*>(base);
+    }
+
+    shm_block& block(std::uint64_t offset) const
+    {
+        return *reinterpret_cast<shm_block*>(base + offset);
+    }
+
+    ~shm_segment_state()
+    {
+        ::munmap(base, size);
+        ::close(fd);
+    }
+};
+
+namespace {
+
+/**
+    The process-local manager of a string allocated in the segment.
+    All the copies of a `basic_api_string` inside a process share one
+    local reference counter, while the whole object holds one single
+    reference to the block.
+*/
+class shm_string_mem: public speudo_std::abi::api_string_mem_base
+{
+public:
+
+    shm_string_mem(shm_segment_state* seg, std::uint64_t offset)
+        : speudo_std::abi::api_string_mem_base{get_table()}
+        , _seg(seg)
+        , _offset(offset)
+    {
+        shm_add_ref(seg);
+    }
+
+    static bool is_shm_string_mem(const speudo_std::abi::api_string_mem_base* m)
+    {
+        return m->func_table == get_table();
+    }
+
+    shm_segment_state* segment() const
+    {
+        return _seg;
+    }
+
+    std::uint64_t offset() const
+    {
+        return _offset;
+    }
+
+private:
+
+    std::atomic<std::size_t> _refcount{1};
+    shm_segment_state* _seg;
+    std::uint64_t _offset;
+
+    static std::size_t acquire(api_string_mem_base* mem_base)
+    {
+        auto* self = static_cast<shm_string_mem*>(mem_base);
+        return self->_refcount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void release(api_string_mem_base* mem_base)
+    {
+        auto* self = static_cast<shm_string_mem*>(mem_base);
+        if (self->_refcount.fetch_sub(1, std::memory_order_release) == 1) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            shm_discard(self->_seg, self->_offset);
+            shm_release(self->_seg);
+            delete self;
+        }
+    }
+
+    static bool unique(api_string_mem_base* mem_base)
+    {
+        auto* self = static_cast<shm_string_mem*>(mem_base);
+        return self->_refcount.load() == 1
+            && self->_seg->block(self->_offset).refcount.load() == 1;
+    }
+
+    static std::byte* begin(api_string_mem_base* mem_base)
+    {
+        auto* self = static_cast<shm_string_mem*>(mem_base);
+        return reinterpret_cast<std::byte*>(self->_seg->base + self->_offset + sizeof(shm_block));
+    }
+
+    static std::byte* end(api_string_mem_base* mem_base)
+    {
+        auto* self = static_cast<shm_string_mem*>(mem_base);
+        const auto& b = self->_seg->block(self->_offset);
+        return reinterpret_cast<std::byte*>
+            (self->_seg->base + self->_offset + (std::uint64_t(1) << b.size_class));
+    }
+
+    static const speudo_std::abi::api_string_func_table* get_table()
+    {
+        static const speudo_std::abi::api_string_func_table table =
+            {0, acquire, release, unique, begin, end};
+        return & table;
+    }
+};
+
+shm_segment_state* map_segment(int fd, std::size_t size, bool initialize)
+{
+    void* base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+    {
+        int err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::generic_category(), "mmap");
+    }
+    auto* header = static_cast<shm_header*>(base);
+    if (initialize)
+    {
+        new (header) shm_header{shm_magic, size, {shm_header_size}, {}};
+    }
+    else if (header->magic != shm_magic || header->size != size)
+    {
+        ::munmap(base, size);
+        ::close(fd);
+        speudo_std::_detail::throw_std_invalid_argument("api_string_shm_segment: invalid segment");
+    }
+    try
+    {
+        return new shm_segment_state{{1}, static_cast<char*>(base), size, fd};
+    }
+    catch(...)
+    {
+        ::munmap(base, size);
+        ::close(fd);
+        throw;
+    }
+}
+
+std::uint64_t tagged(std::uint64_t offset, std::uint64_t old_head)
+{
+    return offset | (((old_head >> shm_offset_bits) + 1) << shm_offset_bits);
+}
+
+std::uint64_t allocate_block(shm_segment_state* seg, unsigned size_class)
+{
+    auto& head = seg->header().free_lists[size_class];
+    std::uint64_t h = head.load(std::memory_order_acquire);
+    while ((h & shm_offset_mask) != 0)
+    {
+        std::uint64_t offset = h & shm_offset_mask;
+        std::uint64_t next = seg->block(offset).next_free.load(std::memory_order_relaxed);
+        if (head.compare_exchange_weak(h, tagged(next, h), std::memory_order_acquire))
+        {
+            return offset;
+        }
+    }
+    std::uint64_t block_size = std::uint64_t(1) << size_class;
+    std::uint64_t offset = seg->header().bump.fetch_add(block_size, std::memory_order_relaxed);
+    if (offset + block_size > seg->size)
+    {
+        seg->header().bump.fetch_sub(block_size, std::memory_order_relaxed);
+        throw std::bad_alloc();
+    }
+    return offset;
+}
+
+void free_block(shm_segment_state* seg, std::uint64_t offset)
+{
+    auto& b = seg->block(offset);
+    auto& head = seg->header().free_lists[b.size_class];
+    std::uint64_t h = head.load(std::memory_order_relaxed);
+    do
+    {
+        b.next_free.store(h & shm_offset_mask, std::memory_order_relaxed);
+    }
+    while ( ! head.compare_exchange_weak(h, tagged(offset, h), std::memory_order_release));
+}
+
+unsigned size_class_for(std::size_t bytes)
+{
+    unsigned c = shm_min_class;
+    while (c < shm_max_class && (std::uint64_t(1) << c) < bytes)
+    {
+        ++c;
+    }
+    return c;
+}
+
+shm_block& checked_block(shm_segment_state* seg, std::uint64_t handle)
+{
+    if ( handle < shm_header_size
+      || handle % sizeof(shm_block) != 0
+      || handle > seg->size - sizeof(shm_block) )
+    {
+        speudo_std::_detail::throw_std_invalid_argument("api_string_shm_segment: invalid handle");
+    }
+    auto& b = seg->block(handle);
+    if ( b.size_class < shm_min_class
+      || b.size_class > shm_max_class
+      || (std::uint64_t(1) << b.size_class) > seg->size - handle
+      || (b.length + 1) * b.char_size > (std::uint64_t(1) << b.size_class) - sizeof(shm_block) )
+    {
+        speudo_std::_detail::throw_std_invalid_argument("api_string_shm_segment: invalid handle");
+    }
+    return b;
+}
+
+} // unnamed namespace
+
+shm_segment_state* shm_create(std::size_t size, const char* name)
+{
+    if (size < shm_header_size)
+    {
+        size = shm_header_size;
+    }
+    int fd = name == nullptr
+        ? ::memfd_create("api_string_shm", MFD_CLOEXEC)
+        : ::shm_open(name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        throw_system_error(name ? name : "memfd_create");
+    }
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+        int err = errno;
+        ::close(fd);
+        if (name != nullptr)
+        {
+            ::shm_unlink(name);
+        }
+        throw std::system_error(err, std::generic_category(), "ftruncate");
+    }
+    try
+    {
+        return map_segment(fd, size, true);
+    }
+    catch(...)
+    {
+        // map_segment has closed `fd`
+        if (name != nullptr)
+        {
+            ::shm_unlink(name);
+        }
+        throw;
+    }
+}
+
+shm_segment_state* shm_open(const char* name)
+{
+    int fd = ::shm_open(name, O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        throw_system_error(name);
+    }
+    return shm_attach(fd);
+}
+
+shm_segment_state* shm_attach(int fd)
+{
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+    {
+        int err = errno;
+        ::close(fd);
+        throw std::system_error(err, std::generic_category(), "fstat");
+    }
+    return map_segment(fd, static_cast<std::size_t>(st.st_size), false);
+}
+
+void shm_unlink(const char* name)
+{
+    ::shm_unlink(name);
+}
+
+void shm_add_ref(shm_segment_state* seg)
+{
+    seg->refcount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void shm_release(shm_segment_state* seg)
+{
+    if (seg->refcount.fetch_sub(1, std::memory_order_release) == 1)
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        delete seg;
+    }
+}
+
+int shm_fd(const shm_segment_state* seg)
+{
+    return seg->fd;
+}
+
+std::size_t shm_size(const shm_segment_state* seg)
+{
+    return seg->size;
+}
+
+speudo_std::abi::api_string_mem_base* shm_make
+    ( shm_segment_state* seg
+    , const void* src
+    , std::size_t len
+    , std::size_t char_size
+    , void** str )
+{
+    std::size_t bytes = len * char_size;
+    unsigned size_class = size_class_for(sizeof(shm_block) + bytes + char_size);
+    std::uint64_t offset = allocate_block(seg, size_class);
+
+    auto& b = seg->block(offset);
+    b.refcount.store(1, std::memory_order_relaxed);
+    b.size_class = static_cast<std::uint16_t>(size_class);
+    b.char_size = static_cast<std::uint16_t>(char_size);
+    b.length = len;
+    char* dest = seg->base + offset + sizeof(shm_block);
+    std::memcpy(dest, src, bytes);
+    std::memset(dest + bytes, 0, char_size);
+
+    try
+    {
+        *str = dest;
+        return new shm_string_mem(seg, offset);
+    }
+    catch(...)
+    {
+        free_block(seg, offset);
+        throw;
+    }
+}
+
+std::uint64_t shm_share
+    ( shm_segment_state* seg
+    , speudo_std::abi::api_string_mem_base* manager
+    , const void* str
+    , std::size_t len
+    , std::size_t char_size )
+{
+    if ( manager != nullptr
+      && shm_string_mem::is_shm_string_mem(manager)
+      && static_cast<shm_string_mem*>(manager)->segment() == seg )
+    {
+        std::uint64_t offset = static_cast<shm_string_mem*>(manager)->offset();
+        seg->block(offset).refcount.fetch_add(1, std::memory_order_relaxed);
+        return offset;
+    }
+    void* dest;
+    auto* m = shm_make(seg, str, len, char_size, &dest);
+    std::uint64_t offset = static_cast<shm_string_mem*>(m)->offset();
+    // transfer the reference of the block from the local manager to the handle
+    seg->block(offset).refcount.fetch_add(1, std::memory_order_relaxed);
+    m->release();
+    return offset;
+}
+
+speudo_std::abi::api_string_mem_base* shm_adopt
+    ( shm_segment_state* seg
+    , std::uint64_t handle
+    , std::size_t char_size
+    , const void** str
+    , std::size_t* len )
+{
+    auto& b = checked_block(seg, handle);
+    if (b.char_size != char_size)
+    {
+        speudo_std::_detail::throw_std_invalid_argument("api_string_shm_segment: wrong character type");
+    }
+    auto* m = new shm_string_mem(seg, handle);
+    *str = seg->base + handle + sizeof(shm_block);
+    *len = b.length;
+    return m;
+}
+
+void shm_discard(shm_segment_state* seg, std::uint64_t handle)
+{
+    auto& b = checked_block(seg, handle);
+    if (b.refcount.fetch_sub(1, std::memory_order_release) == 1)
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        free_block(seg, handle);
+    }
+}
+
+} // namespace _detail
+
+} // namespace speudo_std
@@ -0,0 +1,289 @@
+#ifndef SPEUDO_STD_SOURCE_API_STRING_SIMD_HPP
+#define SPEUDO_STD_SOURCE_API_STRING_SIMD_HPP
+
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+// The SIMD registers shared by the vectorized functions of the library.
+// Each instruction set has its own namespace with a `vec` class, so that
+// the same generic code can be included once per instruction set.
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__GNUC__) && defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__))
+#  define SPEUDO_STD_SIMD_X86
+#  include <immintrin.h>
+#  if defined(__clang__)
+#    define SPEUDO_STD_BEGIN_TARGET_AVX2 \
+         _Pragma("clang attribute push (__attribute__((target(\"avx2\"))), apply_to = function)")
+#    define SPEUDO_STD_END_TARGET _Pragma("clang attribute pop")
+#  else
+#    define SPEUDO_STD_BEGIN_TARGET_AVX2 \
+         _Pragma("GCC push_options") _Pragma("GCC target(\"avx2\")")
+#    define SPEUDO_STD_END_TARGET _Pragma("GCC pop_options")
+#  endif
+#endif
+
+namespace speudo_std {
+namespace _detail {
+
+/**
+    The instruction set of the vectorized functions: 0 for the portable
+    code, 1 for SSE2 and 2 for AVX2. It is the best one supported by the
+    processor, unless restricted by `api_string_test::force_find_isa`.
+*/
+int selected_simd_isa();
+
+namespace {
+
+// The characters are handled as unsigned integers of the same size,
+// so that `wchar_t` shares the code of `char16_t` or `char32_t`.
+template <typename CharT>
+using code_unit = typename std::conditional
+    < sizeof(CharT) == 1
+    , std::uint8_t
+    , typename std::conditional
+        < sizeof(CharT) == 2
+        , std::uint16_t
+        , std::uint32_t >::type >::type;
+
+template <typename CharT>
+inline const code_unit<CharT>* to_code_units(const CharT* str)
+{
+    return reinterpret_cast<const code_unit<CharT>*>(str);
+}
+
+template <typename CharT>
+inline code_unit<CharT>* to_code_units(CharT* str)
+{
+    return reinterpret_cast<code_unit<CharT>*>(str);
+}
+
+#if defined(SPEUDO_STD_SIMD_X86)
+
+inline unsigned lowest_bit(std::uint32_t mask)
+{
+    return __builtin_ctz(mask);
+}
+
+inline unsigned highest_bit(std::uint32_t mask)
+{
+    return 31 - __builtin_clz(mask);
+}
+
+// The mask of the first `n` bits
+inline std::uint32_t low_bits(std::size_t n)
+{
+    return n >= 32 ? ~std::uint32_t{0} : (std::uint32_t{1} << n) - 1;
+}
+
+namespace sse2 {
+
+struct vec
+{
+    using reg = __m128i;
+    static constexpr std::size_t size = 16;
+
+    static reg load(const void* p)
+    {
+        return _mm_loadu_si128(static_cast<const __m128i*>(p));
+    }
+    static void store(void* p, reg x)
+    {
+        _mm_storeu_si128(static_cast<__m128i*>(p), x);
+    }
+    static std::uint32_t mask(reg x)
+    {
+        return static_cast<std::uint32_t>(_mm_movemask_epi8(x));
+    }
+    static reg bit_or(reg a, reg b)
+    {
+        return _mm_or_si128(a, b);
+    }
+    static reg bit_and(reg a, reg b)
+    {
+        return _mm_and_si128(a, b);
+    }
+    static reg bit_xor(reg a, reg b)
+    {
+        return _mm_xor_si128(a, b);
+    }
+    // the operations on 64 bits lanes
+    static reg add64(reg a, reg b)
+    {
+        return _mm_add_epi64(a, b);
+    }
+    // the products of the low halves
+    static reg mul_low32(reg a, reg b)
+    {
+        return _mm_mul_epu32(a, b);
+    }
+    static reg high_half64(reg x)
+    {
+        return _mm_srli_epi64(x, 32);
+    }
+    template <typename U>
+    static reg broadcast(U ch)
+    {
+        if constexpr (sizeof(U) == 1)
+        {
+            return _mm_set1_epi8(static_cast<char>(ch));
+        }
+        else if constexpr (sizeof(U) == 2)
+        {
+            return _mm_set1_epi16(static_cast<short>(ch));
+        }
+        else
+        {
+            return _mm_set1_epi32(static_cast<int>(ch));
+        }
+    }
+    template <typename U>
+    static reg cmpeq(reg a, reg b)
+    {
+        if constexpr (sizeof(U) == 1)
+        {
+            return _mm_cmpeq_epi8(a, b);
+        }
+        else if constexpr (sizeof(U) == 2)
+        {
+            return _mm_cmpeq_epi16(a, b);
+        }
+        else
+        {
+            return _mm_cmpeq_epi32(a, b);
+        }
+    }
+    // signed comparison
+    template <typename U>
+    static reg cmpgt(reg a, reg b)
+    {
+        if constexpr (sizeof(U) == 1)
+        {
+            return _mm_cmpgt_epi8(a, b);
+        }
+        else if constexpr (sizeof(U) == 2)
+        {
+            return _mm_cmpgt_epi16(a, b);
+        }
+        else
+        {
+            return _mm_cmpgt_epi32(a, b);
+        }
+    }
+};
+
+} // namespace sse2
+
+SPEUDO_STD_BEGIN_TARGET_AVX2
+
+namespace avx2 {
+
+struct vec
+{
+    using reg = __m256i;
+    static constexpr std::size_t size = 32;
+
+    static reg load(const void* p)
+    {
+        return _mm256_loadu_si256(static_cast<const __m256i*>(p));
+    }
+    static void store(void* p, reg x)
+    {
+        _mm256_storeu_si256(static_cast<__m256i*>(p), x);
+    }
+    static std::uint32_t mask(reg x)
+    {
+        return static_cast<std::uint32_t>(_mm256_movemask_epi8(x));
+    }
+    static reg bit_or(reg a, reg b)
+    {
+        return _mm256_or_si256(a, b);
+    }
+    static reg bit_and(reg a, reg b)
+    {
+        return _mm256_and_si256(a, b);
+    }
+    static reg bit_xor(reg a, reg b)
+    {
+        return _mm256_xor_si256(a, b);
+    }
+    // the operations on 64 bits lanes
+    static reg add64(reg a, reg b)
+    {
+        return _mm256_add_epi64(a, b);
+    }
+    // the products of the low halves
+    static reg mul_low32(reg a, reg b)
+    {
+        return _mm256_mul_epu32(a, b);
+    }
+    static reg high_half64(reg x)
+    {
+        return _mm256_srli_epi64(x, 32);
+    }
+    template <typename U>
+    static reg broadcast(U ch)
+    {
+        if constexpr (sizeof(U) == 1)
+        {
+            return _mm256_set1_epi8(static_cast<char>(ch));
+        }
+        else if constexpr (sizeof(U) == 2)
+        {
+            return _mm256_set1_epi16(static_cast<short>(ch));
+        }
+        else
+        {
+            return _mm256_set1_epi32(static_cast<int>(ch));
+        }
+    }
+    template <typename U>
+    static reg cmpeq(reg a, reg b)
+    {
+        if constexpr (sizeof(U) == 1)
+        {
+            return _mm256_cmpeq_epi8(a, b);
+        }
+        else if constexpr (sizeof(U) == 2)
+        {
+            return _mm256_cmpeq_epi16(a, b);
+        }
+        else
+        {
+            return _mm256_cmpeq_epi32(a, b);
+        }
+    }
+    // signed comparison
+    template <typename U>
+    static reg cmpgt(reg a, reg b)
+    {
+        if constexpr (sizeof(U) == 1)
+        {
+            return _mm256_cmpgt_epi8(a, b);
+        }
+        else if constexpr (sizeof(U) == 2)
+        {
+            return _mm256_cmpgt_epi16(a, b);
+        }
+        else
+        {
+            return _mm256_cmpgt_epi32(a, b);
+        }
+    }
+};
+
+} // namespace avx2
+
+SPEUDO_STD_END_TARGET
+
+#endif // defined(SPEUDO_STD_SIMD_X86)
+
+} // unnamed namespace
+} // namespace _detail
+} // namespace speudo_std
+
+#endif
@@ -0,0 +1,629 @@
+#include <api_string_utf.hpp>
+#include <detail/api_string_memory.hpp>
+#include "api_string_simd.hpp"
+#include <cstring>
+
+namespace speudo_std {
+namespace _detail {
+
+// ---------------------------------------------------------------------
+// UTF validation and transcoding
+// ---------------------------------------------------------------------
+//
+// The code units are handled as unsigned integers, the encoding being
+// given by their size. The transcoding validates the input and computes
+// the length of the output in a first pass, then allocates the result
+// and converts without any further check. Each pass has three
+// implementations: the portable one, one with SSE2 and one with AVX2.
+
+namespace {
+
+constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+// Validates the code point that starts at `str[i]`, and moves `i` after it.
+
+inline bool valid_step(const std::uint8_t* str, std::size_t len, std::size_t& i)
+{
+    const unsigned c = str[i];
+    if (c < 0x80)
+    {
+        ++i;
+        return true;
+    }
+    // the number of continuation bytes, and the range of the first one,
+    // which excludes the overlong encodings, the surrogates and the code
+    // points beyond U+10FFFF
+    std::size_t n;
+    unsigned low = 0x80, high = 0xBF;
+    if (c >= 0xC2 && c <= 0xDF)
+    {
+        n = 1;
+    }
+    else if (c >= 0xE0 && c <= 0xEF)
+    {
+        n = 2;
+        low  = c == 0xE0 ? 0xA0 : 0x80;
+        high = c == 0xED ? 0x9F : 0xBF;
+    }
+    else if (c >= 0xF0 && c <= 0xF4)
+    {
+        n = 3;
+        low  = c == 0xF0 ? 0x90 : 0x80;
+        high = c == 0xF4 ? 0x8F : 0xBF;
+    }
+    else
+    {
+        return false;
+    }
+    if (len - i <= n || str[i + 1] < low || str[i + 1] > high)
+    {
+        return false;
+    }
+    for (std::size_t k = 2; k <= n; ++k)
+    {
+        if ((str[i + k] & 0xC0) != 0x80)
+        {
+            return false;
+        }
+    }
+    i += n + 1;
+    return true;
+}
+
+inline bool valid_step(const std::uint16_t* str, std::size_t len, std::size_t& i)
+{
+    const unsigned u = str[i];
+    if ((u & 0xF800) != 0xD800)
+    {
+        ++i;
+        return true;
+    }
+    if (u < 0xDC00 && i + 1 < len && (str[i + 1] & 0xFC00) == 0xDC00)
+    {
+        i += 2;
+        return true;
+    }
+    return false;
+}
+
+inline bool valid_step(const std::uint32_t* str, std::size_t, std::size_t& i)
+{
+    const std::uint32_t u = str[i++];
+    return u < 0x110000 && (u & 0xFFFFF800) != 0xD800;
+}
+
+// Decodes the valid code point that starts at `str[i]`, and moves `i` after it.
+
+inline char32_t decode(const std::uint8_t* str, std::size_t& i)
+{
+    const char32_t c = str[i];
+    if (c < 0x80)
+    {
+        i += 1;
+        return c;
+    }
+    if (c < 0xE0)
+    {
+        const char32_t cp = ((c & 0x1F) << 6) | (str[i + 1] & 0x3F);
+        i += 2;
+        return cp;
+    }
+    if (c < 0xF0)
+    {
+        const char32_t cp = ((c & 0x0F) << 12)
+                          | ((str[i + 1] & 0x3F) << 6)
+                          | (str[i + 2] & 0x3F);
+        i += 3;
+        return cp;
+    }
+    const char32_t cp = ((c & 0x07) << 18)
+                      | ((str[i + 1] & 0x3F) << 12)
+                      | ((str[i + 2] & 0x3F) << 6)
+                      | (str[i + 3] & 0x3F);
+    i += 4;
+    return cp;
+}
+
+inline char32_t decode(const std::uint16_t* str, std::size_t& i)
+{
+    const char32_t u = str[i];
+    if ((u & 0xFC00) == 0xD800)
+    {
+        const char32_t cp = 0x10000 + ((u - 0xD800) << 10) + (str[i + 1] - 0xDC00);
+        i += 2;
+        return cp;
+    }
+    i += 1;
+    return u;
+}
+
+inline char32_t decode(const std::uint32_t* str, std::size_t& i)
+{
+    return str[i++];
+}
+
+// Encodes `cp` and returns the end of the written code units
+
+inline std::uint8_t* encode(char32_t cp, std::uint8_t* out)
+{
+    if (cp < 0x80)
+    {
+        *out++ = static_cast<std::uint8_t>(cp);
+    }
+    else if (cp < 0x800)
+    {
+        *out++ = static_cast<std::uint8_t>(0xC0 | (cp >> 6));
+        *out++ = static_cast<std::uint8_t>(0x80 | (cp & 0x3F));
+    }
+    else if (cp < 0x10000)
+    {
+        *out++ = static_cast<std::uint8_t>(0xE0 | (cp >> 12));
+        *out++ = static_cast<std::uint8_t>(0x80 | ((cp >> 6) & 0x3F));
+        *out++ = static_cast<std::uint8_t>(0x80 | (cp & 0x3F));
+    }
+    else
+    {
+        *out++ = static_cast<std::uint8_t>(0xF0 | (cp >> 18));
+        *out++ = static_cast<std::uint8_t>(0x80 | ((cp >> 12) & 0x3F));
+        *out++ = static_cast<std::uint8_t>(0x80 | ((cp >> 6) & 0x3F));
+        *out++ = static_cast<std::uint8_t>(0x80 | (cp & 0x3F));
+    }
+    return out;
+}
+
+inline std::uint16_t* encode(char32_t cp, std::uint16_t* out)
+{
+    if (cp < 0x10000)
+    {
+        *out++ = static_cast<std::uint16_t>(cp);
+    }
+    else
+    {
+        *out++ = static_cast<std::uint16_t>(0xD800 + ((cp - 0x10000) >> 10));
+        *out++ = static_cast<std::uint16_t>(0xDC00 + ((cp - 0x10000) & 0x3FF));
+    }
+    return out;
+}
+
+inline std::uint32_t* encode(char32_t cp, std::uint32_t* out)
+{
+    *out++ = cp;
+    return out;
+}
+
+// The contribution of a code unit of a valid string to the length of
+// the converted string. It does not depend on the other code units, so
+// that a string can be measured from any position: for instance, in
+// UTF-8, only the first byte of a code point counts, and in UTF-16,
+// each half of a surrogate pair counts for two bytes of UTF-8.
+template <typename UF, typename UT>
+inline std::size_t unit_weight(UF u)
+{
+    if constexpr (sizeof(UF) == sizeof(UT))
+    {
+        return 1;
+    }
+    else if constexpr (sizeof(UF) == 1)
+    {
+        return (u & 0xC0) == 0x80 ? 0 : 1 + (sizeof(UT) == 2 && u >= 0xF0);
+    }
+    else if constexpr (sizeof(UF) == 2 && sizeof(UT) == 1)
+    {
+        return 1 + (u >= 0x80) + (u >= 0x800) - ((u & 0xF800) == 0xD800);
+    }
+    else if constexpr (sizeof(UF) == 2)
+    {
+        return (u & 0xFC00) != 0xDC00;
+    }
+    else if constexpr (sizeof(UT) == 1)
+    {
+        return 1 + (u >= 0x80) + (u >= 0x800) + (u >= 0x10000);
+    }
+    else
+    {
+        return 1 + (u >= 0x10000);
+    }
+}
+
+template <typename U>
+bool scalar_validate(const U* str, std::size_t len)
+{
+    for (std::size_t i = 0; i < len; )
+    {
+        if ( ! valid_step(str, len, i))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename UF, typename UT>
+std::size_t scalar_length(const UF* str, std::size_t len)
+{
+    std::size_t result = 0;
+    for (std::size_t i = 0; i < len; ++i)
+    {
+        result += unit_weight<UF, UT>(str[i]);
+    }
+    return result;
+}
+
+template <typename UF, typename UT>
+void scalar_convert(const UF* str, std::size_t len, UT* out, std::size_t)
+{
+    for (std::size_t i = 0; i < len; )
+    {
+        out = encode(decode(str, i), out);
+    }
+}
+
+template <typename UF, typename UT>
+struct utf_functions
+{
+    bool (*validate)(const UF*, std::size_t);
+    std::size_t (*length)(const UF*, std::size_t);
+    void (*convert)(const UF*, std::size_t, UT*, std::size_t out_len);
+};
+
+template <typename UF, typename UT>
+constexpr utf_functions<UF, UT> scalar_utf_functions =
+    { scalar_validate<UF>, scalar_length<UF, UT>, scalar_convert<UF, UT> };
+
+#if defined(SPEUDO_STD_SIMD_X86)
+
+namespace sse2 {
+
+// `pshufb` is not part of SSE2
+constexpr bool has_byte_shuffle = false;
+
+#include "api_string_utf.inc"
+
+} // namespace sse2
+
+SPEUDO_STD_BEGIN_TARGET_AVX2
+
+namespace avx2 {
+
+constexpr bool has_byte_shuffle = true;
+
+// The validation of UTF-8 by table lookups of J. Keiser and D. Lemire
+// ( "Validating UTF-8 in less than one instruction per byte", 2021 ).
+// Each pair of consecutive bytes is classified by three lookups ( of the
+// high and of the low nibbles of the first byte, and of the high nibble
+// of the second one ), the errors being the bits common to the three
+// results. Then the bytes that follow a leading byte of three or four
+// bytes sequence are checked to be continuation bytes.
+class utf8_checker
+{
+public:
+
+    // explicit, since an implicit constructor would not be compiled for AVX2
+    utf8_checker()
+        : _error(_mm256_setzero_si256())
+        , _prev_input(_mm256_setzero_si256())
+        , _prev_incomplete(_mm256_setzero_si256())
+    {
+    }
+
+    void check(__m256i input)
+    {
+        if (_mm256_movemask_epi8(input) == 0)
+        {
+            _error = _mm256_or_si256(_error, _prev_incomplete);
+        }
+        else
+        {
+            _error = _mm256_or_si256(_error, _check_lengths(input, _classify(input)));
+            // the last bytes that start a sequence that does not end
+            // before the end of the register
+            const __m256i max_value = _mm256_setr_epi8
+                ( -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+                , -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+                , static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1)
+                , static_cast<char>(0xC0 - 1) );
+            _prev_incomplete = _mm256_subs_epu8(input, max_value);
+        }
+        _prev_input = input;
+    }
+
+    bool valid()
+    {
+        _error = _mm256_or_si256(_error, _prev_incomplete);
+        return _mm256_testz_si256(_error, _error) != 0;
+    }
+
+private:
+
+    // the bytes of `input` shifted by `N` positions, the first ones
+    // being the last ones of the previous register
+    template <int N>
+    __m256i _prev(__m256i input) const
+    {
+        return _mm256_alignr_epi8
+            ( input, _mm256_permute2x128_si256(_prev_input, input, 0x21), 16 - N );
+    }
+
+    static __m256i _lookup(__m256i nibbles, const std::uint8_t (&table)[16])
+    {
+        const __m256i t = _mm256_broadcastsi128_si256
+            ( _mm_loadu_si128(reinterpret_cast<const __m128i*>(table)) );
+        return _mm256_shuffle_epi8(t, nibbles);
+    }
+
+    static __m256i _high_nibbles(__m256i x)
+    {
+        return _mm256_and_si256(_mm256_srli_epi16(x, 4), _mm256_set1_epi8(0x0F));
+    }
+
+    __m256i _classify(__m256i input) const
+    {
+        constexpr std::uint8_t too_short   = 1 << 0; // 11______ 0_______ or 11______ 11______
+        constexpr std::uint8_t too_long    = 1 << 1; // 0_______ 10______
+        constexpr std::uint8_t overlong_3  = 1 << 2; // 11100000 100_____
+        constexpr std::uint8_t too_large   = 1 << 3; // 11110100 1001____ and above
+        constexpr std::uint8_t surrogate   = 1 << 4; // 11101101 101_____
+        constexpr std::uint8_t overlong_2  = 1 << 5; // 1100000_ 10______
+        constexpr std::uint8_t large_1000  = 1 << 6; // 11110101 1000____ and above
+        constexpr std::uint8_t overlong_4  = 1 << 6; // 11110000 1000____
+        constexpr std::uint8_t two_conts   = 1 << 7; // 10______ 10______
+        constexpr std::uint8_t carry = too_short | too_long | two_conts;
+
+        static constexpr std::uint8_t first_high[16] =
+            { too_long, too_long, too_long, too_long     // ASCII
+            , too_long, too_long, too_long, too_long
+            , two_conts, two_conts, two_conts, two_conts // continuation
+            , too_short | overlong_2                     // 1100____
+            , too_short                                  // 1101____
+            , too_short | overlong_3 | surrogate         // 1110____
+            , too_short | too_large | large_1000 | overlong_4 };
+        static constexpr std::uint8_t first_low[16] =
+            { carry | overlong_3 | overlong_2 | overlong_4 // ____0000
+            , carry | overlong_2                           // ____0001
+            , carry
+            , carry
+            , carry | too_large                            // ____0100
+            , carry | too_large | large_1000
+            , carry | too_large | large_1000
+            , carry | too_large | large_1000
+            , carry | too_large | large_1000
+            , carry | too_large | large_1000
+            , carry | too_large | large_1000
+            , carry | too_large | large_1000
+            , carry | too_large | large_1000
+            , carry | too_large | large_1000 | surrogate   // ____1101
+            , carry | too_large | large_1000
+            , carry | too_large | large_1000 };
+        static constexpr std::uint8_t second_high[16] =
+            { too_short, too_short, too_short, too_short // ASCII
+            , too_short, too_short, too_short, too_short
+            , too_long | overlong_2 | two_conts | overlong_3 | large_1000 | overlong_4 // 1000____
+            , too_long | overlong_2 | two_conts | overlong_3 | too_large               // 1001____
+            , too_long | overlong_2 | two_conts | surrogate | too_large                // 101_____
+            , too_long | overlong_2 | two_conts | surrogate | too_large
+            , too_short, too_short, too_short, too_short }; // 11______
+
+        const __m256i prev1 = _prev<1>(input);
+        return _mm256_and_si256
+            ( _mm256_and_si256
+                ( _lookup(_high_nibbles(prev1), first_high)
+                , _lookup(_mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)), first_low) )
+            , _lookup(_high_nibbles(input), second_high) );
+    }
+
+    // The bytes that must be continuation bytes of a sequence of three or
+    // four bytes are the only ones whose `two_conts` error is expected
+    __m256i _check_lengths(__m256i input, __m256i special) const
+    {
+        const __m256i third = _mm256_subs_epu8(_prev<2>(input), _mm256_set1_epi8(0xE0 - 0x80));
+        const __m256i fourth = _mm256_subs_epu8(_prev<3>(input), _mm256_set1_epi8(0xF0 - 0x80));
+        const __m256i expected = _mm256_and_si256
+            ( _mm256_or_si256(third, fourth)
+            , _mm256_set1_epi8(static_cast<char>(0x80)) );
+        return _mm256_xor_si256(expected, special);
+    }
+
+    __m256i _error;
+    __m256i _prev_input;
+    __m256i _prev_incomplete;
+};
+
+bool lookup_validate_utf8(const std::uint8_t* str, std::size_t len)
+{
+    utf8_checker checker;
+    std::size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        checker.check(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(str + i)));
+    }
+    if (i < len)
+    {
+        // padded with ASCII characters, which end any pending sequence
+        alignas(32) std::uint8_t last[32] = {};
+        std::memcpy(last, str + i, len - i);
+        checker.check(_mm256_load_si256(reinterpret_cast<const __m256i*>(last)));
+    }
+    return checker.valid();
+}
+
+// The `pshufb` controls that move the 16 bits lanes whose bits are set
+// in the index to the beginning of the register
+struct compress_table
+{
+    alignas(16) std::uint8_t controls[256][16] = {};
+
+    constexpr compress_table()
+    {
+        for (unsigned m = 0; m < 256; ++m)
+        {
+            unsigned n = 0;
+            for (unsigned lane = 0; lane < 8; ++lane)
+            {
+                if (m & (1u << lane))
+                {
+                    controls[m][2 * n] = static_cast<std::uint8_t>(2 * lane);
+                    controls[m][2 * n + 1] = static_cast<std::uint8_t>(2 * lane + 1);
+                    ++n;
+                }
+            }
+            for (n *= 2; n < 16; ++n)
+            {
+                controls[m][n] = 0x80;
+            }
+        }
+    }
+};
+
+constexpr compress_table compress_16{};
+
+template <typename UT>
+inline void store_compressed(__m128i units, unsigned keep, UT*& out)
+{
+    const __m128i packed = _mm_shuffle_epi8
+        ( units
+        , _mm_load_si128(reinterpret_cast<const __m128i*>(compress_16.controls[keep])) );
+    if constexpr (sizeof(UT) == 2)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), packed);
+    }
+    else
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_cvtepu16_epi32(packed));
+    }
+    out += __builtin_popcount(keep);
+}
+
+// Converts the valid UTF-8 code points that start in `str[0, 16)`, made
+// only of ASCII characters and of sequences of two bytes, except the one
+// that starts at the last byte, if any. Each byte is widened to 16 bits,
+// and combined with the previous byte if it is a continuation byte, then
+// the leading bytes are removed with a table of shuffles. Up to 16 code
+// units are written after `out`. Returns the number of bytes converted.
+template <typename UT>
+inline std::size_t convert_two_bytes_16(const std::uint8_t* str, UT*& out)
+{
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str));
+    const __m256i units = _mm256_cvtepu8_epi16(bytes);
+    const __m256i prev = _mm256_cvtepu8_epi16(_mm_slli_si128(bytes, 1));
+    const __m256i low6 = _mm256_set1_epi16(0x3F);
+    const __m256i is_cont = _mm256_cmpeq_epi16
+        ( _mm256_and_si256(units, _mm256_set1_epi16(0xC0))
+        , _mm256_set1_epi16(0x80) );
+    const __m256i combined = _mm256_or_si256
+        ( _mm256_slli_epi16(_mm256_and_si256(prev, _mm256_set1_epi16(0x1F)), 6)
+        , _mm256_and_si256(units, low6) );
+    const __m256i values = _mm256_blendv_epi8(units, combined, is_cont);
+
+    const __m128i lead_bits = _mm_set1_epi8(static_cast<char>(0xC0));
+    const unsigned leads = static_cast<unsigned>
+        ( _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(bytes, lead_bits), lead_bits)) );
+    const unsigned keep = ~leads & 0xFFFF;
+    store_compressed(_mm256_castsi256_si128(values), keep & 0xFF, out);
+    store_compressed(_mm256_extracti128_si256(values, 1), keep >> 8, out);
+    return 16 - (leads >> 15);
+}
+
+// The same for the code points that start in `str[0, 32)`, writing up
+// to 32 code units, of which at least 30 are converted.
+template <typename UT>
+std::size_t convert_two_bytes_utf8(const std::uint8_t* str, UT*& out)
+{
+    const std::size_t first = convert_two_bytes_16(str, out);
+    return first + convert_two_bytes_16(str + first, out);
+}
+
+#include "api_string_utf.inc"
+
+} // namespace avx2
+
+SPEUDO_STD_END_TARGET
+
+#endif // defined(SPEUDO_STD_SIMD_X86)
+
+template <typename UF, typename UT>
+const utf_functions<UF, UT>& get_utf_functions()
+{
+#if defined(SPEUDO_STD_SIMD_X86)
+    switch (selected_simd_isa())
+    {
+        case 2: return avx2::functions<UF, UT>;
+        case 1: return sse2::functions<UF, UT>;
+    }
+#endif
+    return scalar_utf_functions<UF, UT>;
+}
+
+} // unnamed namespace
+
+template <typename CharT>
+bool utf_validate(const CharT* str, std::size_t len) noexcept
+{
+    using unit = code_unit<CharT>;
+    return get_utf_functions<unit, unit>().validate(to_code_units(str), len);
+}
+
+template <typename To, typename From>
+std::size_t utf_transcoded_length(const From* str, std::size_t len) noexcept
+{
+    auto& f = get_utf_functions<code_unit<From>, code_unit<To>>();
+    if ( ! f.validate(to_code_units(str), len))
+    {
+        return npos;
+    }
+    return f.length(to_code_units(str), len);
+}
+
+template <typename To, typename From>
+speudo_std::basic_api_string<To> utf_transcode(const From* str, std::size_t len)
+{
+    const std::size_t result_len = speudo_std::_detail::utf_transcoded_length<To>(str, len);
+    if (result_len == npos)
+    {
+        speudo_std::_detail::throw_std_invalid_argument("invalid UTF sequence");
+    }
+    if constexpr (sizeof(To) == sizeof(From))
+    {
+        return speudo_std::basic_api_string<To>(reinterpret_cast<const To*>(str), len);
+    }
+    else
+    {
+        auto& f = get_utf_functions<code_unit<From>, code_unit<To>>();
+        using data_type = speudo_std::abi::api_string_data<To>;
+        if (result_len <= data_type::small_capacity())
+        {
+            To buff[data_type::small_capacity() + 1];
+            f.convert(to_code_units(str), len, to_code_units(buff), result_len);
+            return speudo_std::basic_api_string<To>(buff, result_len);
+        }
+        auto mem = speudo_std::_detail::api_string_mem<std::allocator<To>>::create
+            ( std::allocator<To>{}, (result_len + 1) * sizeof(To) );
+        To* result = reinterpret_cast<To*>(mem.pool);
+        f.convert(to_code_units(str), len, to_code_units(result), result_len);
+        result[result_len] = To{};
+        return speudo_std::_detail::basic_string_helper::adopt(mem.manager, result, result_len);
+    }
+}
+
+#define SPEUDO_STD_INSTANTIATE_UTF(TO, FROM)                                   \
+    template std::size_t utf_transcoded_length<TO, FROM>                      \
+        (const FROM*, std::size_t) noexcept;                                  \
+    template speudo_std::basic_api_string<TO> utf_transcode<TO, FROM>         \
+        (const FROM*, std::size_t);
+
+#define SPEUDO_STD_INSTANTIATE_UTF_FROM(FROM)                                  \
+    template bool utf_validate<FROM>(const FROM*, std::size_t) noexcept;      \
+    SPEUDO_STD_INSTANTIATE_UTF(char, FROM)                                    \
+    SPEUDO_STD_INSTANTIATE_UTF(wchar_t, FROM)                                 \
+    SPEUDO_STD_INSTANTIATE_UTF(char16_t, FROM)                                \
+    SPEUDO_STD_INSTANTIATE_UTF(char32_t, FROM)
+
+SPEUDO_STD_INSTANTIATE_UTF_FROM(char)
+SPEUDO_STD_INSTANTIATE_UTF_FROM(wchar_t)
+SPEUDO_STD_INSTANTIATE_UTF_FROM(char16_t)
+SPEUDO_STD_INSTANTIATE_UTF_FROM(char32_t)
+
+#undef SPEUDO_STD_INSTANTIATE_UTF_FROM
+#undef SPEUDO_STD_INSTANTIATE_UTF
+
+} // namespace _detail
+} // namespace speudo_std
@@ -0,0 +1,190 @@
+#include <gtest/gtest.h>
+#include <api_string_atomic.hpp>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+using speudo_std::string_literals::operator""_as;
+
+const char* long_text = "a string that is long enough not to fit in the small string optimization";
+
+static bool fail_allocations = false;
+
+void* operator new(std::size_t size)
+{
+    void* p = fail_allocations ? nullptr : std::malloc(size != 0 ? size : 1);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+TEST(atomic_api_string, load_store_exchange)
+{
+    speudo_std::api_string_test::reset();
+    {
+        speudo_std::atomic_api_string a;
+        EXPECT_TRUE(a.load().empty());
+        EXPECT_TRUE(a.is_lock_free());
+
+        a.store(speudo_std::api_string{long_text});
+        EXPECT_EQ(a.load(), long_text);
+
+        auto old = a.exchange("short"_as);
+        EXPECT_EQ(old, long_text);
+        EXPECT_EQ(a.load(), "short");
+
+        a = speudo_std::api_string{"another string that is long enough to be allocated"};
+        speudo_std::api_string s = a;
+        EXPECT_EQ(s, "another string that is long enough to be allocated");
+    }
+    EXPECT_EQ( speudo_std::api_string_test::allocations_count()
+             , speudo_std::api_string_test::deallocations_count() );
+}
+
+TEST(atomic_api_string, compare_exchange)
+{
+    speudo_std::atomic_api_string a{speudo_std::api_string{long_text}};
+
+    speudo_std::api_string expected = "wrong"_as;
+    EXPECT_FALSE(a.compare_exchange_strong(expected, "new"_as));
+    EXPECT_EQ(expected, long_text);
+
+    EXPECT_TRUE(a.compare_exchange_strong(expected, "new"_as));
+    EXPECT_EQ(a.load(), "new");
+
+    speudo_std::atomic_api_string empty;
+    speudo_std::api_string nothing;
+    EXPECT_TRUE(empty.compare_exchange_weak(nothing, "x"_as));
+    EXPECT_EQ(empty.load(), "x");
+}
+
+TEST(atomic_api_string, concurrent_readers_and_writers)
+{
+    std::vector<speudo_std::api_string> values;
+    for (int i = 0; i < 8; ++i)
+    {
+        values.emplace_back((std::string(long_text) + std::to_string(i)).c_str());
+    }
+    speudo_std::atomic_api_string a{values[0]};
+    std::atomic<bool> stop{false};
+    std::atomic<int> errors{0};
+
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t)
+    {
+        readers.emplace_back([&]
+        {
+            while ( ! stop.load())
+            {
+                auto s = a.load();
+                bool found = false;
+                for (const auto& v : values)
+                {
+                    found = found || s == v;
+                }
+                errors += found ? 0 : 1;
+            }
+        });
+    }
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 2; ++t)
+    {
+        writers.emplace_back([&, t]
+        {
+            for (int i = 0; i < 20000; ++i)
+            {
+                a.store(values[(i + t) % values.size()]);
+            }
+        });
+    }
+    for (auto& w : writers)
+    {
+        w.join();
+    }
+    stop = true;
+    for (auto& r : readers)
+    {
+        r.join();
+    }
+    EXPECT_EQ(errors.load(), 0);
+}
+
+TEST(atomic_api_string, concurrent_compare_exchange)
+{
+    speudo_std::atomic_api_string a{""_as};
+    const int threads = 4;
+    const int iterations = 500;
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&]
+        {
+            for (int i = 0; i < iterations; ++i)
+            {
+                auto expected = a.load();
+                while (true)
+                {
+                    std::string next{expected.data(), expected.size()};
+                    next += 'x';
+                    if (a.compare_exchange_weak(expected, speudo_std::api_string{next.c_str()}))
+                    {
+                        break;
+                    }
+                }
+            }
+        });
+    }
+    for (auto& w : workers)
+    {
+        w.join();
+    }
+    EXPECT_EQ(a.load().size(), threads * iterations);
+}
+
+TEST(atomic_api_string, compare_exchange_failing_allocation)
+{
+    speudo_std::api_string_test::reset();
+    {
+        speudo_std::atomic_api_string a{speudo_std::api_string{long_text}};
+        speudo_std::api_string expected = a.load();
+        bool thrown = false;
+        fail_allocations = true;
+        try
+        {
+            a.compare_exchange_strong(expected, "new"_as);
+        }
+        catch (const std::bad_alloc&)
+        {
+            thrown = true;
+        }
+        fail_allocations = false;
+        EXPECT_TRUE(thrown);
+        EXPECT_EQ(a.load(), long_text);
+
+        // the node of the previous value must still be freed
+        expected = speudo_std::api_string{};
+        a.store("new"_as);
+    }
+    EXPECT_EQ( speudo_std::api_string_test::allocations_count()
+             , speudo_std::api_string_test::deallocations_count() );
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,239 @@
+#include <gtest/gtest.h>
+#include <api_string_batch_builder.hpp>
+#include "custom_allocator.hpp"
+#include <stdexcept>
+#include <vector>
+
+template <typename CharT>
+class basic_fixture: public ::testing::Test
+{
+public:
+
+    basic_fixture()
+    {
+        speudo_std::api_string_test::reset();
+        fill(m_small_buff, small_string_len());
+        fill(m_big_buff, big_string_len());
+    }
+
+    using char_type = CharT;
+    using data_type = speudo_std::abi::api_string_data<CharT>;
+    using builder_type = speudo_std::basic_api_string_batch_builder<CharT>;
+
+    constexpr static std::size_t small_string_len()
+    {
+        return data_type::small_capacity();
+    }
+    constexpr static std::size_t big_string_len()
+    {
+        return 3 * data_type::small_capacity() + 1;
+    }
+
+    const CharT* small_string() const
+    {
+        return m_small_buff;
+    }
+
+    const CharT* big_string() const
+    {
+        return m_big_buff;
+    }
+
+private:
+    CharT m_small_buff[small_string_len() + 1];
+    CharT m_big_buff[big_string_len() + 1];
+
+    static void fill(CharT* str, std::size_t len)
+    {
+        CharT c = ' ';
+        for (std::size_t i = 0; i < len; ++i)
+        {
+            str[i] = c;
+            c = (c == 'z') ? ' ' : c + 1;
+        }
+        str[len] = 0;
+    }
+};
+
+using all_char_types = ::testing::Types<char, wchar_t, char16_t, char32_t>;
+
+TYPED_TEST_CASE(basic_fixture, all_char_types);
+
+TYPED_TEST(basic_fixture, empty_batch)
+{
+    typename TestFixture::builder_type builder;
+    auto v = builder.build();
+
+    EXPECT_TRUE(v.empty());
+    EXPECT_EQ(speudo_std::api_string_test::allocations_count(), 0);
+    EXPECT_EQ(speudo_std::api_string_test::deallocations_count(), 0);
+}
+
+TYPED_TEST(basic_fixture, one_allocation_per_batch)
+{
+    using char_type = typename TestFixture::char_type;
+    {
+        typename TestFixture::builder_type builder;
+        builder.reserve(3 * this->big_string_len() + this->small_string_len() - 1, 5);
+        builder.append(this->big_string());
+        builder.append(this->small_string());
+        builder.append(this->big_string(), this->big_string_len() - 1);
+        builder.append(this->big_string(), 0);
+        builder.append(speudo_std::basic_api_string<char_type>(this->big_string()));
+        EXPECT_EQ(builder.size(), 5);
+        EXPECT_EQ(speudo_std::api_string_test::allocations_count(), 2);
+
+        auto v = builder.build();
+        EXPECT_TRUE(builder.empty());
+        ASSERT_EQ(v.size(), 5);
+        EXPECT_EQ(v[0], this->big_string());
+        EXPECT_EQ(v[1], this->small_string());
+        EXPECT_EQ(v[2].size(), this->big_string_len() - 1);
+        EXPECT_EQ(v[2].c_str()[this->big_string_len() - 1], char_type{});
+        EXPECT_TRUE(v[3].empty());
+        EXPECT_EQ(v[4], this->big_string());
+        // the small strings are not stored in the block
+        EXPECT_EQ(v[2].data(), v[0].data() + this->big_string_len() + 1);
+
+        // the temporary api_string and the batch block
+        EXPECT_EQ(speudo_std::api_string_test::allocations_count(), 2);
+        EXPECT_EQ(speudo_std::api_string_test::deallocations_count(), 1);
+
+        v[0].clear();
+        v[2].clear();
+        EXPECT_EQ(speudo_std::api_string_test::deallocations_count(), 1);
+    }
+    EXPECT_EQ(speudo_std::api_string_test::allocations_count(), 2);
+    EXPECT_EQ(speudo_std::api_string_test::deallocations_count(), 2);
+}
+
+TYPED_TEST(basic_fixture, growth_keeps_content)
+{
+    typename TestFixture::builder_type builder;
+    for (int i = 0; i < 20; ++i)
+    {
+        builder.append(this->big_string());
+        builder.append(this->small_string());
+    }
+    auto v = builder.build();
+    ASSERT_EQ(v.size(), 40);
+    for (std::size_t i = 0; i < v.size(); i += 2)
+    {
+        EXPECT_EQ(v[i], this->big_string());
+        EXPECT_EQ(v[i + 1], this->small_string());
+    }
+    auto allocations = speudo_std::api_string_test::allocations_count();
+    v.clear();
+    EXPECT_EQ(speudo_std::api_string_test::deallocations_count(), allocations);
+
+    // the next batch reuses the previous capacity
+    for (int i = 0; i < 20; ++i)
+    {
+        builder.append(this->big_string());
+    }
+    v = builder.build();
+    EXPECT_EQ(speudo_std::api_string_test::allocations_count(), allocations + 1);
+}
+
+TYPED_TEST(basic_fixture, only_small_strings)
+{
+    typename TestFixture::builder_type builder;
+    builder.append(this->small_string());
+    builder.append(this->small_string(), 1);
+    auto v = builder.build();
+
+    ASSERT_EQ(v.size(), 2);
+    EXPECT_EQ(v[0], this->small_string());
+    EXPECT_EQ(v[1].size(), 1);
+    EXPECT_EQ(speudo_std::api_string_test::allocations_count(), 0);
+
+    // a reserved block is kept for the next batch
+    builder.reserve(2 * this->big_string_len(), 2);
+    builder.append(this->small_string());
+    v = builder.build();
+    EXPECT_EQ(v[0], this->small_string());
+    builder.append(this->big_string());
+    v = builder.build();
+    EXPECT_EQ(v[0], this->big_string());
+    EXPECT_EQ(speudo_std::api_string_test::allocations_count(), 1);
+}
+
+// An output iterator that throws when `limit` strings have been written
+template <typename CharT>
+struct throwing_output
+{
+    std::vector<speudo_std::basic_api_string<CharT>>* strings;
+    std::size_t limit;
+
+    throwing_output& operator*()
+    {
+        return *this;
+    }
+    throwing_output& operator++()
+    {
+        return *this;
+    }
+    throwing_output& operator=(speudo_std::basic_api_string<CharT>&& s)
+    {
+        if (strings->size() == limit)
+        {
+            throw std::runtime_error("full");
+        }
+        strings->push_back(std::move(s));
+        return *this;
+    }
+};
+
+TYPED_TEST(basic_fixture, output_throws)
+{
+    using char_type = typename TestFixture::char_type;
+    for (std::size_t limit : {0, 1, 2, 3})
+    {
+        speudo_std::api_string_test::reset();
+        std::vector<speudo_std::basic_api_string<char_type>> v;
+        {
+            typename TestFixture::builder_type builder;
+            builder.reserve(3 * this->big_string_len() + this->small_string_len(), 4);
+            builder.append(this->big_string());
+            builder.append(this->small_string());
+            builder.append(this->big_string());
+            builder.append(this->big_string());
+            EXPECT_THROW(builder.build(throwing_output<char_type>{&v, limit}), std::runtime_error);
+            EXPECT_TRUE(builder.empty());
+        }
+        ASSERT_EQ(v.size(), limit);
+        for (std::size_t i = 0; i < v.size(); ++i)
+        {
+            EXPECT_EQ(v[i], i == 1 ? this->small_string() : this->big_string());
+        }
+        EXPECT_EQ(speudo_std::api_string_test::deallocations_count(), limit == 0 ? 1 : 0);
+        v.clear();
+        EXPECT_EQ(speudo_std::api_string_test::allocations_count(), 1);
+        EXPECT_EQ(speudo_std::api_string_test::deallocations_count(), 1);
+    }
+}
+
+TYPED_TEST(basic_fixture, custom_allocator)
+{
+    using char_type = typename TestFixture::char_type;
+    allocator_log log;
+    custom_allocator<char_type> a(log);
+    {
+        speudo_std::basic_api_string_batch_builder
+            < char_type
+            , std::char_traits<char_type>
+            , custom_allocator<char_type> > builder(a);
+
+        builder.append(this->big_string());
+        builder.append(this->big_string());
+        auto v = builder.build();
+        EXPECT_EQ(log.allocations_count(), 1);
+        EXPECT_EQ(log.deallocations_count(), 0);
+    }
+    EXPECT_EQ(log.deallocations_count(), 1);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
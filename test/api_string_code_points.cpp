@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include <api_string_code_points.hpp>
+#include <api_string_io.hpp>
+#include <string.hpp>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// A UTF-8 string of `count` code points, with the positions of each one
+static std::string make_text(std::size_t count, std::vector<std::size_t>& offsets)
+{
+    const char* samples[] = {"a", "z", " ", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80"};
+    std::mt19937 gen(5);
+    std::string text;
+    offsets.clear();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        offsets.push_back(text.size());
+        text += samples[gen() % 6];
+    }
+    return text;
+}
+
+static speudo_std::abi::api_string_mem_base* manager_of(const speudo_std::api_string& s)
+{
+    return speudo_std::_detail::basic_string_helper::get_data(s).big.mem_manager;
+}
+
+TEST(code_points, offsets_and_count)
+{
+    for (std::size_t count : {0, 1, 10, 63, 64, 65, 300, 1000, 5000})
+    {
+        std::vector<std::size_t> offsets;
+        const std::string text = make_text(count, offsets);
+        const speudo_std::api_string s{text.data(), text.size()};
+
+        EXPECT_EQ(speudo_std::code_points_count(s), count);
+        for (std::size_t cp = 0; cp < count; ++cp)
+        {
+            ASSERT_EQ(speudo_std::code_point_offset(s, cp), offsets[cp]) << count << " " << cp;
+        }
+        EXPECT_EQ(speudo_std::code_point_offset(s, count), text.size());
+        EXPECT_EQ(speudo_std::code_point_offset(s, count + 10), text.size());
+
+        EXPECT_EQ( (speudo_std::_detail::cached_code_point_index(s) != nullptr)
+                 , text.size() >= speudo_std::code_point_index_min_length );
+
+        for (std::size_t pos = 0; pos <= count; pos += 1 + count / 7)
+        {
+            for (std::size_t n : {std::size_t{0}, std::size_t{1}, std::size_t{70}, std::size_t(-1)})
+            {
+                auto sub = speudo_std::substr_code_points(s, pos, n);
+                const std::size_t end = n >= count - pos ? text.size() : offsets[pos + n];
+                const std::size_t begin = pos == count ? text.size() : offsets[pos];
+                ASSERT_EQ(std::string(sub.data(), sub.size()), text.substr(begin, end - begin));
+            }
+        }
+        EXPECT_THROW(speudo_std::substr_code_points(s, count + 1), std::out_of_range);
+    }
+}
+
+TEST(code_points, index_shared_by_copies)
+{
+    std::vector<std::size_t> offsets;
+    const std::string text = make_text(3000, offsets);
+    speudo_std::api_string_test::reset();
+    {
+        const speudo_std::api_string s{text.data(), text.size()};
+        const speudo_std::api_string copy = s;
+        EXPECT_EQ(manager_of(s)->get_aux(), nullptr);
+
+        auto* index = speudo_std::_detail::cached_code_point_index(copy);
+        ASSERT_NE(index, nullptr);
+        EXPECT_EQ(index->code_points_count(), 3000);
+        EXPECT_NE(manager_of(s)->get_aux(), nullptr);
+        EXPECT_EQ(speudo_std::_detail::cached_code_point_index(s), index);
+
+        // a suffix shares the memory block, but not the index
+        auto suffix = speudo_std::substr_code_points(s, 1000);
+        EXPECT_EQ(manager_of(suffix), manager_of(s));
+        EXPECT_EQ(speudo_std::_detail::cached_code_point_index(suffix), nullptr);
+        EXPECT_EQ(speudo_std::code_points_count(suffix), 2000);
+        EXPECT_EQ(speudo_std::code_point_offset(suffix, 10), offsets[1010] - offsets[1000]);
+    }
+    EXPECT_EQ(speudo_std::api_string_test::allocations_count(), 1);
+    EXPECT_EQ(speudo_std::api_string_test::deallocations_count(), 1);
+}
+
+TEST(code_points, index_dropped_when_modified)
+{
+    std::vector<std::size_t> offsets;
+    const std::string text = make_text(2000, offsets);
+    speudo_std::api_string s{text.data(), text.size()};
+    EXPECT_EQ(speudo_std::code_points_count(s), 2000);
+
+    // the memory is unique, so `basic_string` takes it over and modifies
+    // it in place, without changing its address nor its length
+    const char* data = s.data();
+    speudo_std::string str{std::move(s)};
+    str.replace(0, offsets[10], offsets[10], 'x');
+    s = std::move(str);
+    ASSERT_EQ(s.data(), data);
+    ASSERT_EQ(s.size(), text.size());
+    EXPECT_EQ(speudo_std::code_points_count(s), 2000 - 10 + offsets[10]);
+    EXPECT_EQ(speudo_std::code_point_offset(s, offsets[10] + 1), offsets[11]);
+}
+
+TEST(code_points, index_dropped_when_line_reader_reuses_chunk)
+{
+    // the line reader writes the following lines over the chunks that
+    // are no longer referenced, so that lines of the same length, but
+    // not of the same number of code points, are read at the same address
+    std::string text;
+    for (int i = 0; i < 40; ++i)
+    {
+        for (int k = 0; k < 1000; ++k)
+        {
+            text += i % 3 == 0 ? "\xC3\xA9" : "aa";
+        }
+        text += '\n';
+    }
+    std::istringstream is{text};
+    speudo_std::api_string_line_reader reader{is, 4096};
+    speudo_std::api_string line;
+    for (int i = 0; i < 40; ++i)
+    {
+        ASSERT_TRUE(reader.getline(line));
+        ASSERT_EQ(line.size(), 2000);
+        EXPECT_EQ(speudo_std::code_points_count(line), i % 3 == 0 ? 1000 : 2000) << i;
+        EXPECT_EQ(speudo_std::code_point_offset(line, 999), i % 3 == 0 ? 1998 : 999) << i;
+    }
+    EXPECT_FALSE(reader.getline(line));
+}
+
+TEST(code_points, utf16)
+{
+    std::u16string text;
+    std::vector<std::size_t> offsets;
+    for (int i = 0; i < 2000; ++i)
+    {
+        offsets.push_back(text.size());
+        if (i % 3 == 0)
+        {
+            text += u"\U0001F600";
+        }
+        else
+        {
+            text += static_cast<char16_t>(u'a' + i % 26);
+        }
+    }
+    const speudo_std::api_u16string s{text.data(), text.size()};
+    EXPECT_EQ(speudo_std::code_points_count(s), 2000);
+    for (std::size_t cp = 0; cp < 2000; ++cp)
+    {
+        ASSERT_EQ(speudo_std::code_point_offset(s, cp), offsets[cp]);
+    }
+    auto sub = speudo_std::substr_code_points(s, 3, 2);
+    EXPECT_EQ(sub, speudo_std::api_u16string{u"\U0001F600e"});
+
+    const speudo_std::api_u32string s32{U"a\U0001F600b"};
+    EXPECT_EQ(speudo_std::code_points_count(s32), 3);
+    EXPECT_EQ(speudo_std::substr_code_points(s32, 1, 1), speudo_std::api_u32string{U"\U0001F600"});
+}
+
+TEST(code_points, concurrent_first_use)
+{
+    std::vector<std::size_t> offsets;
+    const std::string text = make_text(20000, offsets);
+    const speudo_std::api_string s{text.data(), text.size()};
+    std::vector<std::thread> threads;
+    std::vector<std::size_t> results(8);
+    for (std::size_t t = 0; t < results.size(); ++t)
+    {
+        threads.emplace_back([&, t, copy = s]
+        {
+            results[t] = speudo_std::code_point_offset(copy, 1000 * t + 7);
+        });
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    for (std::size_t t = 0; t < results.size(); ++t)
+    {
+        EXPECT_EQ(results[t], offsets[1000 * t + 7]);
+    }
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
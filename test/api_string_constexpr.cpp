@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <api_string.hpp>
+#include <unordered_set>
+
+// compiled as C++20, where basic_api_string is a literal type
+
+using speudo_std::string_literals::operator""_as;
+
+static_assert("abc"_as.size() == 3);
+static_assert("abc"_as == "abc"_as);
+static_assert("abc"_as != "abd"_as);
+static_assert("abc"_as < "abd"_as);
+static_assert("ab"_as < "abc"_as);
+static_assert("abc"_as > "ab"_as);
+static_assert(""_as < "a"_as);
+static_assert("\xff"_as > "a"_as); // compared as unsigned char, like std::char_traits
+static_assert("abc"_as == "abc");
+static_assert("abc" != "abcd"_as);
+static_assert("abc"_as.compare("abd") < 0);
+static_assert("abcdef"_as.starts_with("abc"_as));
+static_assert( ! "ab"_as.starts_with("abc"_as));
+static_assert(u"abc"_as == u"abc" && U"abc"_as < U"abd" && L"abc"_as == L"abc");
+static_assert(speudo_std::api_string_ref("abc").size() == 3);
+static_assert(speudo_std::api_string_hash{}("abc"_as) != speudo_std::api_string_hash{}("abd"_as));
+static_assert(speudo_std::api_string{}.empty());
+
+SPEUDO_STD_CONSTINIT speudo_std::api_string greeting = "hello world"_as;
+SPEUDO_STD_CONSTINIT speudo_std::api_u16string u16_greeting = u"hello world"_as;
+
+struct entry
+{
+    speudo_std::api_string key;
+    int value;
+};
+
+SPEUDO_STD_CONSTINIT entry table[] =
+    { { "one"_as, 1 }
+    , { "two"_as, 2 }
+    , { "three"_as, 3 } };
+
+TEST(constexpr_api_string, constant_initialized)
+{
+    EXPECT_EQ(greeting, "hello world");
+    EXPECT_EQ(u16_greeting.size(), 11);
+    EXPECT_EQ(table[2].key, "three");
+}
+
+TEST(constexpr_api_string, runtime_matches_compile_time)
+{
+    constexpr std::size_t h = speudo_std::api_string_hash{}("hello world"_as);
+    speudo_std::api_string managed{"hello world"};
+    EXPECT_EQ(speudo_std::api_string_hash{}(managed), h);
+    EXPECT_EQ(speudo_std::api_string_hash{}(greeting), h);
+
+    constexpr std::size_t u16_hash = speudo_std::api_string_hash{}(u"hello world"_as);
+    EXPECT_EQ(speudo_std::api_string_hash{}(speudo_std::api_u16string{u"hello world"}), u16_hash);
+
+    constexpr int cmp = "abc"_as.compare("\xff"_as);
+    EXPECT_EQ(speudo_std::api_string{"abc"}.compare(speudo_std::api_string{"\xff"}), cmp);
+}
+
+TEST(constexpr_api_string, vectorized_hash_matches_compile_time)
+{
+    constexpr auto text = "a string of more than one block of 32 bytes, "
+                          "whose end is not a whole block"_as;
+    constexpr std::size_t h = speudo_std::api_string_hash{}(text);
+    constexpr auto u32_text = U"a string of more than one block of 32 bytes"_as;
+    constexpr std::size_t u32_hash = speudo_std::api_string_hash{}(u32_text);
+
+    std::u16string u16;
+    for (int i = 0; i < 200; ++i)
+    {
+        u16.push_back(static_cast<char16_t>(0x3B1 + i * 977 % 7000));
+    }
+    for (int isa: {0, 1, 2})
+    {
+        speudo_std::api_string_test::force_find_isa(isa);
+        EXPECT_EQ(speudo_std::api_string_hash{}(speudo_std::api_string{text.data()}), h);
+        EXPECT_EQ(speudo_std::api_string_hash{}(speudo_std::api_u32string{u32_text.data()}), u32_hash);
+        for (std::size_t len = 0; len <= u16.size(); ++len)
+        {
+            speudo_std::api_u16string s{u16.data(), len};
+            ASSERT_EQ( speudo_std::api_string_hash{}(s)
+                     , speudo_std::_detail::lanes_hash(u16.data(), len) );
+        }
+    }
+    speudo_std::api_string_test::force_find_isa(-1);
+}
+
+TEST(constexpr_api_string, hash_function_object)
+{
+    std::unordered_set<speudo_std::api_string, speudo_std::api_string_hash> set;
+    set.insert("one"_as);
+    set.insert(speudo_std::api_string{"a string long enough to be allocated"});
+    EXPECT_EQ(set.count(speudo_std::api_string{"one"}), 1);
+    EXPECT_EQ(set.count("a string long enough to be allocated"_as), 1);
+    EXPECT_EQ(set.count("two"_as), 0);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <string.hpp>
+#include <random>
+#include <string_view>
+#include <vector>
+
+template <typename CharT>
+class find_fixture: public ::testing::Test
+{
+public:
+
+    using string_view = std::basic_string_view<CharT>;
+
+    find_fixture()
+    {
+        // a small alphabet, so that partial matches are frequent, with
+        // characters that are negative as `char` or greater than 255
+        const unsigned alphabet[] = {'a', 'b', 'c', 0x80, 0xFF, 0x100, 0x1FF, 'a' + 0x100};
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<int> dist(0, 7);
+        for (std::size_t len: {0, 1, 5, 15, 16, 17, 31, 32, 33, 47, 64, 100, 257})
+        {
+            std::basic_string<CharT> str;
+            for (std::size_t i = 0; i < len; ++i)
+            {
+                str.push_back(static_cast<CharT>(alphabet[dist(gen)]));
+            }
+            m_strings.push_back(str);
+        }
+        for (std::size_t i = 0; i < 300; ++i)
+        {
+            std::basic_string<CharT> needle;
+            std::size_t len = i % 21;
+            for (std::size_t j = 0; j < len; ++j)
+            {
+                needle.push_back(static_cast<CharT>(alphabet[dist(gen)]));
+            }
+            m_needles.push_back(needle);
+        }
+    }
+
+    ~find_fixture()
+    {
+        speudo_std::api_string_test::force_find_isa(-1);
+    }
+
+    template <typename F>
+    void for_each_case(F f) const
+    {
+        for (int isa: {0, 1, 2})
+        {
+            speudo_std::api_string_test::force_find_isa(isa);
+            for (const auto& str: m_strings)
+            {
+                for (const auto& needle: m_needles)
+                {
+                    // needles taken from the string itself, too
+                    std::basic_string<CharT> sub = str.substr
+                        ( needle.size() % (str.size() + 1)
+                        , needle.size() % 7 );
+                    for (const auto& n: {needle, sub})
+                    {
+                        for (std::size_t pos: {std::size_t{0}, std::size_t{1}, std::size_t{15}, str.size() / 2, str.size(), string_view::npos})
+                        {
+                            f(string_view{str}, string_view{n}, pos);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+private:
+
+    std::vector<std::basic_string<CharT>> m_strings;
+    std::vector<std::basic_string<CharT>> m_needles;
+};
+
+using all_char_types = ::testing::Types<char, wchar_t, char16_t, char32_t>;
+
+TYPED_TEST_CASE(find_fixture, all_char_types);
+
+TYPED_TEST(find_fixture, same_as_string_view)
+{
+    using char_type = TypeParam;
+    using namespace speudo_std::_detail;
+
+    this->for_each_case([](auto str, auto s, std::size_t pos)
+    {
+        const char_type* p = str.data();
+        const std::size_t len = str.size();
+        ASSERT_EQ(str_find(p, len, s.data(), pos, s.size()), str.find(s, pos));
+        ASSERT_EQ(str_rfind(p, len, s.data(), pos, s.size()), str.rfind(s, pos));
+        ASSERT_EQ(str_find_first_of(p, len, s.data(), pos, s.size()), str.find_first_of(s, pos));
+        ASSERT_EQ(str_find_first_not_of(p, len, s.data(), pos, s.size()), str.find_first_not_of(s, pos));
+        ASSERT_EQ(str_find_last_of(p, len, s.data(), pos, s.size()), str.find_last_of(s, pos));
+        ASSERT_EQ(str_find_last_not_of(p, len, s.data(), pos, s.size()), str.find_last_not_of(s, pos));
+        if ( ! s.empty())
+        {
+            ASSERT_EQ(str_find(p, len, s[0], pos), str.find(s[0], pos));
+            ASSERT_EQ(str_rfind(p, len, s[0], pos), str.rfind(s[0], pos));
+        }
+    });
+}
+
+TYPED_TEST(find_fixture, member_functions)
+{
+    using char_type = TypeParam;
+    using api_string = speudo_std::basic_api_string<char_type>;
+    using string = speudo_std::basic_string<char_type>;
+
+    this->for_each_case([](auto view, auto s, std::size_t pos)
+    {
+        const api_string astr{view.data(), view.size()};
+        const api_string aneedle{s.data(), s.size()};
+        const string str{view.data(), view.size()};
+        const string needle{s.data(), s.size()};
+
+        ASSERT_EQ(astr.find(aneedle, pos), view.find(s, pos));
+        ASSERT_EQ(astr.rfind(s.data(), pos, s.size()), view.rfind(s, pos));
+        ASSERT_EQ(astr.find_first_of(aneedle, pos), view.find_first_of(s, pos));
+        ASSERT_EQ(astr.find_last_not_of(aneedle, pos), view.find_last_not_of(s, pos));
+        ASSERT_EQ(str.find(needle, pos), view.find(s, pos));
+        ASSERT_EQ(str.rfind(needle, pos), view.rfind(s, pos));
+        ASSERT_EQ(str.find_first_not_of(needle, pos), view.find_first_not_of(s, pos));
+        ASSERT_EQ(str.find_last_of(needle, pos), view.find_last_of(s, pos));
+        if ( ! s.empty())
+        {
+            ASSERT_EQ(astr.find(s[0], pos), view.find(s[0], pos));
+            ASSERT_EQ(astr.find_last_of(s[0], pos), view.find_last_of(s[0], pos));
+            ASSERT_EQ(str.rfind(s[0], pos), view.rfind(s[0], pos));
+            ASSERT_EQ(str.find_first_of(s[0], pos), view.find_first_of(s[0], pos));
+        }
+    });
+}
+
+TEST(find, null_terminated_arguments)
+{
+    speudo_std::api_string str = "key=value; other_key=other_value";
+    EXPECT_EQ(str.find("other"), 11);
+    EXPECT_EQ(str.find_first_of(";="), 3);
+    EXPECT_EQ(str.find_last_of(";="), 20);
+    EXPECT_EQ(str.find_first_not_of("aekyv"), 3);
+    EXPECT_EQ(str.rfind('='), 20);
+    EXPECT_EQ(str.find("absent"), speudo_std::api_string::npos);
+
+    speudo_std::api_string_view view = str;
+    EXPECT_EQ(view.find("value"), 4);
+    EXPECT_EQ(view.rfind("value"), 27);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
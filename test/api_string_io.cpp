@@ -0,0 +1,403 @@
+#include <gtest/gtest.h>
+#include <api_string_io.hpp>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+using speudo_std::string_literals::operator""_as;
+
+class temp_file
+{
+public:
+
+    temp_file()
+    {
+        _fd = ::mkstemp(_path);
+    }
+    ~temp_file()
+    {
+        ::close(_fd);
+        std::remove(_path);
+    }
+
+    int fd() const
+    {
+        return _fd;
+    }
+    const char* path() const
+    {
+        return _path;
+    }
+    std::string content() const
+    {
+        std::string s;
+        char buff[4096];
+        ssize_t n;
+        off_t off = 0;
+        while ((n = ::pread(_fd, buff, sizeof(buff), off)) > 0)
+        {
+            s.append(buff, n);
+            off += n;
+        }
+        return s;
+    }
+
+private:
+
+    char _path[32] = "/tmp/api_string_io_XXXXXX";
+    int _fd;
+};
+
+TEST(gather_write, range_of_api_strings)
+{
+    std::vector<speudo_std::api_string> fragments =
+        { "HTTP/1.1 200 OK\r\n"_as
+        , ""_as
+        , speudo_std::api_string{"Content-Type: text/plain\r\n\r\n"}
+        , "body"_as };
+
+    temp_file f;
+    auto n = speudo_std::gather_write(f.fd(), fragments.begin(), fragments.end());
+    EXPECT_EQ(n, 49);
+    EXPECT_EQ(f.content(), "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\n\r\nbody");
+}
+
+TEST(gather_write, range_of_strings)
+{
+    std::vector<speudo_std::u16string> fragments = { u"abc", u"defghijklmnopqrstuvwxyz" };
+
+    temp_file f;
+    auto n = speudo_std::gather_write(f.fd(), fragments.begin(), fragments.end());
+    EXPECT_EQ(n, 26 * sizeof(char16_t));
+    std::u16string expected = u"abcdefghijklmnopqrstuvwxyz";
+    EXPECT_EQ(f.content(), std::string( reinterpret_cast<const char*>(expected.data())
+                                      , expected.size() * sizeof(char16_t) ));
+}
+
+TEST(gather_write, more_fragments_than_iov_max)
+{
+#if defined(IOV_MAX)
+    const std::size_t count = 2 * IOV_MAX + 10;
+#else
+    const std::size_t count = 3000;
+#endif
+    std::vector<speudo_std::api_string> fragments(count, "0123456789"_as);
+
+    temp_file f;
+    auto n = speudo_std::gather_write(f.fd(), fragments.begin(), fragments.end());
+    EXPECT_EQ(n, 10 * count);
+    auto content = f.content();
+    ASSERT_EQ(content.size(), 10 * count);
+    EXPECT_EQ(content.substr(content.size() - 20), "01234567890123456789");
+}
+
+TEST(gather_write, pwrite_at_offset)
+{
+    std::vector<speudo_std::api_string> fragments = { "abc"_as, "def"_as };
+
+    temp_file f;
+    ASSERT_EQ(::write(f.fd(), "0123456789", 10), 10);
+    speudo_std::gather_pwrite(f.fd(), fragments.begin(), fragments.end(), 2);
+    EXPECT_EQ(f.content(), "01abcdef89");
+}
+
+TEST(gather_write, gather_list_keeps_fragments_alive)
+{
+    speudo_std::api_string_gather_list list;
+    {
+        speudo_std::api_string header{"a header that is long enough to be allocated\n"};
+        speudo_std::string body = "a body that is long enough to be allocated";
+        list.push_back(header);
+        list.push_back(std::move(body));
+        list.push_back("\n"_as);
+        EXPECT_TRUE(body.empty());
+    }
+    EXPECT_EQ(list.size(), 3);
+    EXPECT_EQ(list.bytes(), 88);
+    EXPECT_EQ(list.iovecs().size(), 3);
+
+    temp_file f;
+    EXPECT_EQ(list.write(f.fd()), 88);
+    EXPECT_EQ( f.content()
+             , "a header that is long enough to be allocated\n"
+               "a body that is long enough to be allocated\n" );
+
+    list.clear();
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(list.bytes(), 0);
+}
+
+TEST(gather_write, bad_file_descriptor)
+{
+    std::vector<speudo_std::api_string> fragments = { "abc"_as };
+    EXPECT_THROW( speudo_std::gather_write(-1, fragments.begin(), fragments.end())
+                , std::system_error );
+}
+
+class file_loader: public ::testing::TestWithParam<speudo_std::file_loader_backend>
+{
+public:
+
+    file_loader()
+    {
+        for (std::size_t size : {0, 1, 15, 16, 100, 4096, 70000})
+        {
+            std::string path = std::string(_dir) + "/f" + std::to_string(size);
+            std::string content;
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                content.push_back(static_cast<char>('a' + (i * 7 + size) % 26));
+            }
+            std::FILE* f = std::fopen(path.c_str(), "wb");
+            std::fwrite(content.data(), 1, content.size(), f);
+            std::fclose(f);
+            paths.emplace_back(path.c_str());
+            contents.push_back(content);
+        }
+    }
+
+    ~file_loader()
+    {
+        for (const auto& p : paths)
+        {
+            std::remove(p.c_str());
+        }
+        ::rmdir(_dir);
+    }
+
+    std::vector<speudo_std::api_string> paths;
+    std::vector<std::string> contents;
+
+private:
+
+    char _dir_template[32] = "/tmp/api_string_io_XXXXXX";
+    const char* _dir = ::mkdtemp(_dir_template);
+};
+
+TEST_P(file_loader, load_all)
+{
+    speudo_std::file_loader_options options;
+    options.backend = GetParam();
+    options.queue_depth = 2;
+
+    speudo_std::api_string_test::reset();
+    auto loaded = speudo_std::load_files(paths, options);
+
+    ASSERT_EQ(loaded.size(), paths.size());
+    for (std::size_t i = 0; i < paths.size(); ++i)
+    {
+        EXPECT_EQ(loaded[i].size(), contents[i].size());
+        EXPECT_EQ(std::string(loaded[i].data(), loaded[i].size()), contents[i]);
+        EXPECT_EQ(loaded[i].c_str()[loaded[i].size()], '\0');
+    }
+    // one allocation per non-empty file
+    EXPECT_EQ(speudo_std::api_string_test::allocations_count(), paths.size() - 1);
+    loaded.clear();
+    EXPECT_EQ(speudo_std::api_string_test::deallocations_count(), paths.size() - 1);
+}
+
+TEST_P(file_loader, errors)
+{
+    speudo_std::file_loader_options options;
+    options.backend = GetParam();
+
+    paths.insert(paths.begin() + 2, speudo_std::api_string{"/nonexistent/api_string_file"});
+    std::vector<speudo_std::api_string> loaded(paths.size());
+    std::vector<std::error_code> errors(paths.size());
+    speudo_std::load_files(paths.data(), paths.size(), loaded.data(), errors.data(), options);
+
+    EXPECT_EQ(errors[2], std::errc::no_such_file_or_directory);
+    EXPECT_TRUE(loaded[2].empty());
+    EXPECT_FALSE(errors[3]);
+    EXPECT_EQ(std::string(loaded[3].data(), loaded[3].size()), contents[2]);
+
+    EXPECT_THROW(speudo_std::load_files(paths, options), std::system_error);
+}
+
+INSTANTIATE_TEST_SUITE_P
+    ( backends
+    , file_loader
+    , ::testing::Values( speudo_std::file_loader_backend::automatic
+                       , speudo_std::file_loader_backend::thread_pool ) );
+
+std::vector<std::string> expected_lines(const std::string& input)
+{
+    std::vector<std::string> lines;
+    std::istringstream is(input);
+    std::string line;
+    while (std::getline(is, line))
+    {
+        if ( ! line.empty() && line.back() == '\r')
+        {
+            line.pop_back();
+        }
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+std::string sample_lines()
+{
+    std::string input;
+    for (int i = 0; i < 200; ++i)
+    {
+        input += std::string(static_cast<std::size_t>(i * 37 % 90), 'a' + i % 26);
+        input += (i % 3 == 0) ? "\r\n" : "\n";
+    }
+    input += "last line without new line character";
+    return input;
+}
+
+TEST(line_reader, from_istream)
+{
+    const std::string input = sample_lines();
+    const auto expected = expected_lines(input);
+
+    for (std::size_t chunk_size: {1, 16, 100, 1000, 100000})
+    {
+        std::istringstream is(input);
+        speudo_std::api_string_line_reader reader(is, chunk_size);
+        speudo_std::api_string line;
+        std::size_t i = 0;
+        while (reader.getline(line))
+        {
+            ASSERT_LT(i, expected.size());
+            EXPECT_EQ(std::string(line.data(), line.size()), expected[i]);
+            EXPECT_EQ(line.c_str()[line.size()], '\0');
+            ++i;
+        }
+        EXPECT_EQ(i, expected.size());
+        EXPECT_FALSE(reader.getline(line));
+    }
+}
+
+// A stream buffer that receives its input piece by piece, like a terminal
+class piecewise_buf: public std::streambuf
+{
+public:
+
+    std::vector<std::string> pieces;
+    std::size_t underflows = 0;
+
+protected:
+
+    int_type underflow() override
+    {
+        if (underflows == pieces.size())
+        {
+            return traits_type::eof();
+        }
+        std::string& p = pieces[underflows++];
+        setg(&p[0], &p[0], &p[0] + p.size());
+        return traits_type::to_int_type(p[0]);
+    }
+};
+
+TEST(line_reader, from_interactive_istream)
+{
+    piecewise_buf buf;
+    buf.pieces = {"first line\n", "second ", "line\n"};
+    std::istream is(&buf);
+    speudo_std::api_string_line_reader reader(is);
+    speudo_std::api_string line;
+
+    // a line is returned as soon as it is received
+    ASSERT_TRUE(reader.getline(line));
+    EXPECT_EQ(line, "first line");
+    EXPECT_EQ(buf.underflows, 1);
+    ASSERT_TRUE(reader.getline(line));
+    EXPECT_EQ(line, "second line");
+    EXPECT_EQ(buf.underflows, 3);
+    EXPECT_FALSE(reader.getline(line));
+
+    // the reading resumes when more input comes
+    buf.pieces.push_back("third line\n");
+    ASSERT_TRUE(reader.getline(line));
+    EXPECT_EQ(line, "third line");
+    EXPECT_FALSE(reader.getline(line));
+}
+
+TEST(line_reader, from_file_descriptor)
+{
+    const std::string input = sample_lines();
+    const auto expected = expected_lines(input);
+
+    temp_file f;
+    ASSERT_EQ(::pwrite(f.fd(), input.data(), input.size(), 0), (ssize_t)input.size());
+
+    speudo_std::api_string_test::reset();
+    std::vector<speudo_std::api_string> lines;
+    {
+        speudo_std::api_string_line_reader reader(f.fd());
+        speudo_std::api_string line;
+        while (reader.getline(line))
+        {
+            lines.push_back(line);
+        }
+    }
+    ASSERT_EQ(lines.size(), expected.size());
+    for (std::size_t i = 0; i < lines.size(); ++i)
+    {
+        EXPECT_EQ(std::string(lines[i].data(), lines[i].size()), expected[i]);
+    }
+    // the whole input fits in one chunk
+    EXPECT_EQ(speudo_std::api_string_test::allocations_count(), 1);
+    EXPECT_EQ(speudo_std::api_string_test::deallocations_count(), 0);
+    lines.clear();
+    EXPECT_EQ(speudo_std::api_string_test::deallocations_count(), 1);
+}
+
+TEST(line_reader, file_that_grows_after_a_partial_line)
+{
+    temp_file f;
+    const std::string first = "abcdefghijklmnopqrstuvwxyz";
+    ASSERT_EQ(::pwrite(f.fd(), first.data(), first.size(), 0), (ssize_t)first.size());
+
+    speudo_std::api_string_line_reader reader(f.fd());
+    speudo_std::api_string l1, l2;
+    ASSERT_TRUE(reader.getline(l1));
+    EXPECT_FALSE(reader.getline(l2));
+
+    const std::string more = "MORE DATA HERE\n";
+    ASSERT_EQ( ::pwrite(f.fd(), more.data(), more.size(), first.size())
+             , (ssize_t)more.size() );
+    ASSERT_TRUE(reader.getline(l2));
+    EXPECT_EQ(l2, "MORE DATA HERE");
+
+    // the line returned before is left untouched
+    EXPECT_EQ(l1, first.c_str());
+    EXPECT_EQ(std::strlen(l1.c_str()), first.size());
+    EXPECT_FALSE(reader.getline(l2));
+}
+
+TEST(line_reader, chunk_is_reused_when_not_referenced)
+{
+    std::string input;
+    for (int i = 0; i < 100; ++i)
+    {
+        input += "a line that is long enough not to fit in the small string optimization\n";
+    }
+    std::istringstream is(input);
+    speudo_std::api_string_test::reset();
+    speudo_std::api_string_line_reader reader(is, 1000);
+    speudo_std::api_string line;
+    std::size_t count = 0;
+    while (reader.getline(line))
+    {
+        ++count;
+    }
+    EXPECT_EQ(count, 100);
+    // `line` is the only one that keeps a chunk alive, so
+    // the reader alternates between two chunks
+    EXPECT_EQ(speudo_std::api_string_test::allocations_count(), 2);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include <api_string_multi_searcher.hpp>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <string_view>
+
+// The matches found by searching each pattern separately,
+// in the order of `for_each_match`
+template <typename CharT>
+std::vector<speudo_std::api_string_match> naive_find_all
+    ( const std::vector<std::basic_string<CharT>>& patterns
+    , std::basic_string_view<CharT> haystack )
+{
+    std::vector<speudo_std::api_string_match> matches;
+    for (std::size_t p = 0; p < patterns.size(); ++p)
+    {
+        if (patterns[p].empty())
+        {
+            continue;
+        }
+        for ( auto pos = haystack.find(patterns[p])
+            ; pos != haystack.npos
+            ; pos = haystack.find(patterns[p], pos + 1) )
+        {
+            matches.push_back({p, pos});
+        }
+    }
+    std::stable_sort( matches.begin(), matches.end()
+                    , [&](const auto& a, const auto& b)
+                      {
+                          auto end_a = a.position + patterns[a.pattern].size();
+                          auto end_b = b.position + patterns[b.pattern].size();
+                          return end_a != end_b ? end_a < end_b : a.position < b.position;
+                      } );
+    return matches;
+}
+
+template <typename CharT>
+class multi_searcher_fixture: public ::testing::Test
+{
+};
+
+using char_types = ::testing::Types<char, char16_t>;
+
+TYPED_TEST_CASE(multi_searcher_fixture, char_types);
+
+TYPED_TEST(multi_searcher_fixture, same_as_individual_searches)
+{
+    using char_type = TypeParam;
+    using string = std::basic_string<char_type>;
+
+    // characters of different pages, including ones whose low byte is
+    // the same as of a pattern character
+    const unsigned alphabet[] = {'a', 'b', 'c', 0xE9, 'a' + 0x100, 0x3042};
+    const int alphabet_size = sizeof(char_type) == 1 ? 4 : 6;
+    std::mt19937 gen(3);
+    std::uniform_int_distribution<int> dist(0, alphabet_size - 1);
+    auto random_string = [&](std::size_t len)
+    {
+        string str;
+        for (std::size_t i = 0; i < len; ++i)
+        {
+            str.push_back(static_cast<char_type>(alphabet[dist(gen)]));
+        }
+        return str;
+    };
+
+    for (int round = 0; round < 20; ++round)
+    {
+        std::vector<string> patterns;
+        std::vector<speudo_std::basic_api_string<char_type>> api_patterns;
+        for (int i = 0; i < 2 + round * 5; ++i)
+        {
+            patterns.push_back(random_string(1 + (i * 7 + round) % 6));
+            api_patterns.push_back({patterns.back().data(), patterns.back().size()});
+        }
+        patterns.push_back(patterns[0]); // duplicates are reported twice
+        api_patterns.push_back(api_patterns[0]);
+        patterns.push_back(string());    // empty patterns never match
+        api_patterns.push_back({});
+
+        speudo_std::basic_api_string_multi_searcher<char_type> searcher{api_patterns};
+        for (int h = 0; h < 5; ++h)
+        {
+            const string haystack = random_string(h * 50);
+            auto expected = naive_find_all<char_type>(patterns, haystack);
+            auto matches = searcher.find_all({haystack.data(), haystack.size()});
+            ASSERT_EQ(matches, expected) << "round " << round << ", haystack " << h;
+            EXPECT_EQ( searcher.found_in({haystack.data(), haystack.size()})
+                     , ! expected.empty() );
+        }
+    }
+}
+
+TEST(multi_searcher, log_lines)
+{
+    speudo_std::api_string_multi_searcher searcher{"error", "warning", "err", "fatal error"};
+    EXPECT_EQ(searcher.patterns().size(), 4);
+    EXPECT_LE(searcher.classes_count(), 13);
+
+    auto matches = searcher.find_all("[fatal error] then a warning");
+    std::vector<speudo_std::api_string_match> expected =
+        { {2, 7}, {3, 1}, {0, 7}, {1, 21} };
+    EXPECT_EQ(matches, expected);
+
+    EXPECT_TRUE(searcher.found_in("some error"));
+    EXPECT_FALSE(searcher.found_in("all is well"));
+    EXPECT_TRUE(searcher.find_all("").empty());
+
+    std::size_t count = 0;
+    searcher.for_each_match("error error error", [&](const speudo_std::api_string_match&)
+    {
+        return ++count < 3;
+    });
+    EXPECT_EQ(count, 3);
+}
+
+TEST(multi_searcher, utf16)
+{
+    speudo_std::api_u16string_multi_searcher searcher{u"あい", u"い"};
+    auto matches = searcher.find_all(u"xあいい䅂");
+    std::vector<speudo_std::api_string_match> expected = { {0, 1}, {1, 2}, {1, 3} };
+    EXPECT_EQ(matches, expected);
+}
+
+TEST(multi_searcher, no_patterns)
+{
+    speudo_std::api_string_multi_searcher searcher{std::vector<speudo_std::api_string>{}};
+    EXPECT_FALSE(searcher.found_in("anything"));
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include <api_string_pmr.hpp>
+#include <cstring>
+
+class counting_resource: public std::pmr::memory_resource
+{
+public:
+
+    std::size_t allocations = 0;
+    std::size_t deallocations = 0;
+
+private:
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+    {
+        ++deallocations;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+template <typename CharT>
+class pmr_fixture: public ::testing::Test
+{
+public:
+
+    pmr_fixture()
+    {
+        speudo_std::api_string_test::reset();
+        for (std::size_t i = 0; i < sizeof(m_long) / sizeof(CharT) - 1; ++i)
+        {
+            m_long[i] = static_cast<CharT>('a' + i % 26);
+        }
+        m_long[sizeof(m_long) / sizeof(CharT) - 1] = 0;
+        m_short[0] = 'a';
+        m_short[1] = 0;
+    }
+
+    const CharT* long_str() const
+    {
+        return m_long;
+    }
+
+    const CharT* short_str() const
+    {
+        return m_short;
+    }
+
+private:
+
+    CharT m_long[100];
+    CharT m_short[2];
+};
+
+using all_char_types = ::testing::Types<char, wchar_t, char16_t, char32_t>;
+
+TYPED_TEST_CASE(pmr_fixture, all_char_types);
+
+TYPED_TEST(pmr_fixture, api_string_init)
+{
+    counting_resource resource;
+    {
+        auto s = speudo_std::pmr::api_string_init(&resource, this->long_str());
+        EXPECT_EQ(s, this->long_str());
+        EXPECT_EQ(resource.allocations, 1);
+
+        auto copy = s;
+        EXPECT_EQ(resource.allocations, 1);
+
+        auto small = speudo_std::pmr::api_string_init(&resource, this->short_str(), 1);
+        EXPECT_EQ(small, this->short_str());
+        EXPECT_EQ(resource.allocations, 1);
+    }
+    EXPECT_EQ(resource.deallocations, 1);
+    EXPECT_EQ( speudo_std::api_string_test::allocations_count()
+             , speudo_std::api_string_test::deallocations_count() );
+}
+
+TYPED_TEST(pmr_fixture, conversions)
+{
+    using char_type = TypeParam;
+    using pmr_string = speudo_std::pmr::basic_string<char_type>;
+    using api_string = speudo_std::basic_api_string<char_type>;
+
+    counting_resource resource;
+    {
+        pmr_string str{this->long_str(), &resource};
+        EXPECT_EQ(resource.allocations, 1);
+        api_string s = std::move(str);
+        EXPECT_EQ(s, this->long_str());
+        EXPECT_EQ(resource.allocations, 1);
+
+        // taken over, since it is unique
+        pmr_string str2{std::move(s), &resource};
+        EXPECT_EQ(resource.allocations, 1);
+        str2.push_back('x');
+        api_string s2 = std::move(str2);
+        EXPECT_EQ(s2.size(), std::char_traits<char_type>::length(this->long_str()) + 1);
+
+        // shared, so copied
+        api_string s3 = s2;
+        pmr_string str3{std::move(s3), &resource};
+        EXPECT_EQ(resource.allocations, 2);
+        EXPECT_EQ(str3.get_allocator().resource(), &resource);
+    }
+    EXPECT_EQ(resource.allocations, resource.deallocations);
+}
+
+TEST(pmr, monotonic_buffer_resource)
+{
+    alignas(std::max_align_t) char buffer[4096];
+    std::pmr::monotonic_buffer_resource resource{buffer, sizeof(buffer)};
+    const char* text = "a string that is long enough not to fit in the small string optimization";
+    {
+        auto s = speudo_std::pmr::api_string_init(&resource, text);
+        EXPECT_GE(s.data(), buffer);
+        EXPECT_LT(s.data(), buffer + sizeof(buffer));
+        speudo_std::pmr::string str{s, &resource};
+        str.append(" and even longer");
+        speudo_std::api_string s2 = std::move(str);
+        EXPECT_EQ(std::strncmp(s2.data(), text, std::strlen(text)), 0);
+    }
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include <api_string_range.hpp>
+#include <api_string_batch_builder.hpp>
+#include <api_string_weak.hpp>
+#include <vector>
+
+const char* long_text = "a string that is long enough not to fit in the small string optimization";
+
+// A memory manager that counts the calls to its functions
+template <unsigned long AbiVersion>
+struct counting_mem: speudo_std::abi::api_string_mem_base
+{
+    counting_mem()
+        : speudo_std::abi::api_string_mem_base{get_table()}
+    {
+    }
+
+    std::size_t refcount = 1;
+    std::size_t single_calls = 0;
+    std::size_t bulk_calls = 0;
+
+    static std::size_t acquire(api_string_mem_base* m)
+    {
+        auto* self = static_cast<counting_mem*>(m);
+        ++self->single_calls;
+        return self->refcount++;
+    }
+    static void release(api_string_mem_base* m)
+    {
+        auto* self = static_cast<counting_mem*>(m);
+        ++self->single_calls;
+        --self->refcount;
+    }
+    static void acquire_n(api_string_mem_base* m, std::size_t n)
+    {
+        auto* self = static_cast<counting_mem*>(m);
+        ++self->bulk_calls;
+        self->refcount += n;
+    }
+    static void release_n(api_string_mem_base* m, std::size_t n)
+    {
+        auto* self = static_cast<counting_mem*>(m);
+        ++self->bulk_calls;
+        self->refcount -= n;
+    }
+    static bool unique(api_string_mem_base* m)
+    {
+        return static_cast<counting_mem*>(m)->refcount == 1;
+    }
+    static std::byte* nothing(api_string_mem_base*)
+    {
+        return nullptr;
+    }
+    static void weak(api_string_mem_base*)
+    {
+    }
+    static bool try_acquire(api_string_mem_base*)
+    {
+        return false;
+    }
+    static const speudo_std::abi::api_string_func_table* get_table()
+    {
+        static const speudo_std::abi::api_string_func_table table =
+            { AbiVersion, acquire, release, unique, nothing, nothing
+            , weak, weak, try_acquire, acquire_n, release_n };
+        return &table;
+    }
+
+    speudo_std::api_string make_string(const char* str)
+    {
+        ++refcount;
+        return speudo_std::_detail::basic_string_helper::adopt<char>
+            ( this, str, std::char_traits<char>::length(str) );
+    }
+};
+
+TEST(api_string_range, consecutive_strings_are_grouped)
+{
+    counting_mem<2> m1;
+    counting_mem<2> m2;
+    std::vector<speudo_std::api_string> v;
+    v.push_back(m1.make_string(long_text));
+    v.push_back(m1.make_string(long_text + 1));
+    v.emplace_back("small");
+    v.push_back(speudo_std::api_string_ref(long_text));
+    v.push_back(m1.make_string(long_text + 2));
+    v.push_back(m2.make_string(long_text + 3));
+    v.push_back(m2.make_string(long_text + 4));
+    EXPECT_EQ(m1.refcount, 4);
+    EXPECT_EQ(m2.refcount, 3);
+
+    std::vector<speudo_std::api_string> copy(v.size());
+    auto it = speudo_std::copy_api_strings(v.begin(), v.end(), copy.begin());
+    EXPECT_EQ(it, copy.end());
+    EXPECT_EQ(copy, v);
+    EXPECT_EQ(copy[0].data(), v[0].data());
+    EXPECT_EQ(m1.refcount, 7);
+    EXPECT_EQ(m2.refcount, 5);
+    EXPECT_EQ(m1.bulk_calls, 1);
+    EXPECT_EQ(m2.bulk_calls, 1);
+
+    speudo_std::release_api_strings(v.begin(), v.end());
+    for (const auto& s : v)
+    {
+        EXPECT_TRUE(s.empty());
+    }
+    EXPECT_EQ(m1.refcount, 4);
+    EXPECT_EQ(m2.refcount, 3);
+    EXPECT_EQ(m1.bulk_calls, 2);
+    EXPECT_EQ(m2.bulk_calls, 2);
+
+    // assigning over existing strings releases them
+    speudo_std::copy_api_strings(copy.begin(), copy.begin() + 2, copy.begin() + 4);
+    EXPECT_EQ(m1.refcount, 5);
+    EXPECT_EQ(m2.refcount, 2);
+    EXPECT_EQ(copy[4].data(), long_text);
+
+    // copying a range onto itself changes nothing
+    speudo_std::copy_api_strings(copy.begin(), copy.end(), copy.begin());
+    EXPECT_EQ(m1.refcount, 5);
+    EXPECT_EQ(m2.refcount, 2);
+
+    speudo_std::release_api_strings(copy.begin(), copy.end());
+    EXPECT_EQ(m1.refcount, 1);
+    EXPECT_EQ(m2.refcount, 1);
+    EXPECT_EQ(m1.single_calls, 0);
+    EXPECT_EQ(m2.single_calls, 0);
+}
+
+TEST(api_string_range, fallback_for_older_managers)
+{
+    counting_mem<0> m;
+    std::vector<speudo_std::api_string> v;
+    v.reserve(2);
+    v.push_back(m.make_string(long_text));
+    v.push_back(m.make_string(long_text));
+    std::vector<speudo_std::api_string> copy(2);
+    speudo_std::copy_api_strings(v.begin(), v.end(), copy.begin());
+    EXPECT_EQ(m.refcount, 5);
+    speudo_std::release_api_strings(v.begin(), v.end());
+    speudo_std::release_api_strings(copy.begin(), copy.end());
+    EXPECT_EQ(m.refcount, 1);
+    EXPECT_EQ(m.bulk_calls, 0);
+    EXPECT_EQ(m.single_calls, 6);
+}
+
+TEST(api_string_range, batch)
+{
+    speudo_std::api_string_test::reset();
+    {
+        speudo_std::api_string_batch_builder builder;
+        for (int i = 0; i < 10; ++i)
+        {
+            builder.append(long_text);
+        }
+        std::vector<speudo_std::api_string> v = builder.build();
+        speudo_std::weak_api_string w{v[0]};
+
+        std::vector<speudo_std::api_string> copy(v.size());
+        speudo_std::copy_api_strings(v.begin(), v.end(), copy.begin());
+        speudo_std::release_api_strings(v.begin(), v.end());
+        EXPECT_FALSE(w.expired());
+        EXPECT_EQ(copy[9], long_text);
+
+        speudo_std::release_api_strings(copy.begin(), copy.end());
+        EXPECT_TRUE(w.expired());
+    }
+    EXPECT_EQ( speudo_std::api_string_test::allocations_count()
+             , speudo_std::api_string_test::deallocations_count() );
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <api_string_realloc.hpp>
+#include <string>
+
+static_assert(speudo_std::string_growth_policy<>::next_capacity(10, 1) == 20);
+static_assert(speudo_std::string_growth_policy<150>::next_capacity(10, 1) == 15);
+static_assert(speudo_std::string_growth_policy<150, 64>::next_capacity(10, 1) == 74);
+static_assert(speudo_std::string_growth_policy<150, 64>::next_capacity(1000, 1) == 1500);
+static_assert(speudo_std::string_growth_policy<200, 0, 4096, 1024>::next_capacity(1100, 4) == 1356);
+static_assert(speudo_std::string_growth_policy<200, 0, 4096, 1024>::next_capacity(1000, 1) == 2000);
+
+static_assert(speudo_std::_detail::has_reallocate<speudo_std::realloc_allocator<char>>::value);
+static_assert( ! speudo_std::_detail::has_reallocate<std::allocator<char>>::value);
+
+using string_type = speudo_std::basic_string
+    < char, std::char_traits<char>, speudo_std::realloc_allocator<char> >;
+
+TEST(realloc_allocator, append_reallocates_the_block)
+{
+    speudo_std::api_string_test::reset();
+    std::string expected;
+    {
+        string_type str;
+        for (int i = 0; i < 10000; ++i)
+        {
+            str.append("0123456789");
+            expected.append("0123456789");
+        }
+        str.push_back('!');
+        expected.push_back('!');
+        EXPECT_EQ(std::string(str.data(), str.size()), expected);
+
+        // the first block is created, and then only resized
+        EXPECT_EQ(speudo_std::api_string_test::allocations_count(), 1);
+
+        speudo_std::api_string s = std::move(str);
+        EXPECT_EQ(std::string(s.data(), s.size()), expected);
+
+        string_type str2{std::move(s)};
+        str2.append(1000000, 'x');
+        EXPECT_EQ(str2.size(), expected.size() + 1000000);
+        EXPECT_EQ(str2[expected.size()], 'x');
+        EXPECT_EQ(str2.c_str()[str2.size()], '\0');
+        EXPECT_EQ(speudo_std::api_string_test::allocations_count(), 1);
+    }
+    EXPECT_EQ(speudo_std::api_string_test::deallocations_count(), 1);
+}
+
+TEST(realloc_allocator, shared_or_foreign_blocks_are_copied)
+{
+    speudo_std::api_string_test::reset();
+    const char* text = "a string that is long enough not to fit in the small string optimization";
+    {
+        // created with std::allocator
+        string_type str{speudo_std::api_string{text}};
+        str.append(text);
+        EXPECT_EQ(speudo_std::api_string_test::allocations_count(), 2);
+        EXPECT_EQ(speudo_std::api_string_test::deallocations_count(), 1);
+
+        speudo_std::api_string s = std::move(str);
+        speudo_std::api_string copy = s;
+        string_type str2{copy, speudo_std::copy_on_write};
+        str2.append(text);
+        EXPECT_EQ(speudo_std::api_string_test::allocations_count(), 3);
+        EXPECT_EQ(std::string(s.data(), s.size()), std::string(text) + text);
+    }
+    EXPECT_EQ( speudo_std::api_string_test::allocations_count()
+             , speudo_std::api_string_test::deallocations_count() );
+}
+
+TEST(string_growth_policy, linear_mode)
+{
+    using policy = speudo_std::string_growth_policy<200, 0, 1024, 256>;
+    using linear_string = speudo_std::basic_string
+        < char, std::char_traits<char>, speudo_std::realloc_allocator<char, policy> >;
+
+    linear_string str;
+    str.append(100, 'a');
+    EXPECT_EQ(str.size(), 100);
+    EXPECT_GE(str.capacity(), 200);
+
+    str.append(2000 - str.size(), 'b');
+    EXPECT_EQ(str.size(), 2000);
+    EXPECT_GE(str.capacity(), 2000 + 256);
+    EXPECT_LT(str.capacity(), 2000 + 256 + 64);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
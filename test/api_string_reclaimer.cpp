@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+#include <api_string_reclaimer.hpp>
+#include <string.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// A stateless allocator that records which thread deallocates
+struct deallocation_log
+{
+    static std::atomic<int> count;
+    static std::atomic<int> on_other_thread;
+    static std::thread::id main_thread;
+};
+std::atomic<int> deallocation_log::count{0};
+std::atomic<int> deallocation_log::on_other_thread{0};
+std::thread::id deallocation_log::main_thread;
+
+template <typename T>
+struct recording_allocator
+{
+    using value_type = T;
+
+    recording_allocator() = default;
+    template <typename U>
+    recording_allocator(const recording_allocator<U>&)
+    {
+    }
+
+    T* allocate(std::size_t n)
+    {
+        return std::allocator<T>{}.allocate(n);
+    }
+    void deallocate(T* p, std::size_t n)
+    {
+        ++deallocation_log::count;
+        if (std::this_thread::get_id() != deallocation_log::main_thread)
+        {
+            ++deallocation_log::on_other_thread;
+        }
+        std::allocator<T>{}.deallocate(p, n);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const recording_allocator<T>&, const recording_allocator<U>&)
+{
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const recording_allocator<T>&, const recording_allocator<U>&)
+{
+    return false;
+}
+
+using allocator_type = speudo_std::deferred_allocator<char, recording_allocator<char>>;
+using string_type = speudo_std::basic_string<char, std::char_traits<char>, allocator_type>;
+
+class reclaimer_fixture: public ::testing::Test
+{
+public:
+
+    reclaimer_fixture()
+    {
+        speudo_std::api_string_test::reset();
+        deallocation_log::count = 0;
+        deallocation_log::on_other_thread = 0;
+        deallocation_log::main_thread = std::this_thread::get_id();
+    }
+};
+
+TEST_F(reclaimer_fixture, large_strings_are_freed_by_the_reclaimer)
+{
+    speudo_std::api_string_reclaimer reclaimer{1024};
+    {
+        string_type str{allocator_type{reclaimer}};
+        str.append(std::string(4096, 'x').c_str());
+        speudo_std::api_string s = std::move(str);
+        speudo_std::api_string copy = s;
+        EXPECT_EQ(copy.size(), 4096);
+    }
+    reclaimer.drain();
+    EXPECT_EQ(deallocation_log::count, 1);
+    EXPECT_EQ(deallocation_log::on_other_thread, 1);
+    EXPECT_EQ( speudo_std::api_string_test::allocations_count()
+             , speudo_std::api_string_test::deallocations_count() );
+}
+
+TEST_F(reclaimer_fixture, small_strings_are_freed_immediately)
+{
+    speudo_std::api_string_reclaimer reclaimer{1024};
+    {
+        string_type str{allocator_type{reclaimer}};
+        str.append("a string that does not fit in the small string buffer");
+        speudo_std::api_string s = std::move(str);
+    }
+    EXPECT_EQ(deallocation_log::count, 1);
+    EXPECT_EQ(deallocation_log::on_other_thread, 0);
+}
+
+TEST_F(reclaimer_fixture, concurrent_releases)
+{
+    const int threads = 4;
+    const int strings_per_thread = 200;
+    {
+        speudo_std::api_string_reclaimer reclaimer{1024};
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&]
+            {
+                for (int i = 0; i < strings_per_thread; ++i)
+                {
+                    string_type str{allocator_type{reclaimer}};
+                    str.append(std::string(2000 + i, 'y').c_str());
+                    speudo_std::api_string s = std::move(str);
+                }
+            });
+        }
+        for (auto& w : workers)
+        {
+            w.join();
+        }
+        // the destructor frees what is still pending
+    }
+    EXPECT_EQ(deallocation_log::count, threads * strings_per_thread);
+    EXPECT_EQ( speudo_std::api_string_test::allocations_count()
+             , speudo_std::api_string_test::deallocations_count() );
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include <api_string_searcher.hpp>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <string_view>
+
+template <typename CharT>
+class searcher_fixture: public ::testing::Test
+{
+public:
+
+    using string = std::basic_string<CharT>;
+
+    // Strings on a tiny alphabet, so that partial matches are frequent.
+    // 'a' + 0x100 has the same low byte as 'a'.
+    static string random_string(std::mt19937& gen, std::size_t len, int alphabet_size)
+    {
+        const unsigned alphabet[] = {'a', 'b', 'a' + 0x100, 'c'};
+        std::uniform_int_distribution<int> dist(0, alphabet_size - 1);
+        string str;
+        for (std::size_t i = 0; i < len; ++i)
+        {
+            str.push_back(static_cast<CharT>(alphabet[dist(gen)]));
+        }
+        return str;
+    }
+
+    static void check(const string& haystack, const string& needle)
+    {
+        speudo_std::basic_api_string_searcher<CharT> searcher{{needle.data(), needle.size()}};
+        const std::basic_string_view<CharT> view{haystack};
+        for (std::size_t pos: {std::size_t{0}, std::size_t{1}, std::size_t{7}, haystack.size() / 3, haystack.size()})
+        {
+            ASSERT_EQ(searcher.find({haystack.data(), haystack.size()}, pos), view.find(needle, pos))
+                << "needle length: " << needle.size() << ", pos: " << pos;
+        }
+    }
+};
+
+using all_char_types = ::testing::Types<char, wchar_t, char16_t, char32_t>;
+
+TYPED_TEST_CASE(searcher_fixture, all_char_types);
+
+TYPED_TEST(searcher_fixture, algorithm_selection)
+{
+    using searcher = speudo_std::basic_api_string_searcher<TypeParam>;
+    using string = typename TestFixture::string;
+
+    EXPECT_EQ(searcher{string().c_str()}.algorithm(), speudo_std::searcher_algorithm::empty);
+    EXPECT_EQ(searcher{string(32, 'a').c_str()}.algorithm(), speudo_std::searcher_algorithm::simd);
+    EXPECT_EQ(searcher{string(33, 'a').c_str()}.algorithm(), speudo_std::searcher_algorithm::horspool);
+    EXPECT_EQ(searcher{string(256, 'a').c_str()}.algorithm(), speudo_std::searcher_algorithm::horspool);
+    EXPECT_EQ(searcher{string(257, 'a').c_str()}.algorithm(), speudo_std::searcher_algorithm::two_way);
+}
+
+TYPED_TEST(searcher_fixture, random_needles)
+{
+    std::mt19937 gen(7);
+    for (std::size_t needle_len: {1, 2, 20, 32, 33, 100, 256, 257, 400, 1000})
+    {
+        for (int alphabet_size: {1, 2, 3, 4})
+        {
+            for (int i = 0; i < 10; ++i)
+            {
+                auto haystack = this->random_string(gen, 3000, alphabet_size);
+                auto needle = this->random_string(gen, needle_len, alphabet_size);
+                this->check(haystack, needle);
+
+                // a needle that is present
+                std::size_t pos = (i * 997) % (haystack.size() - needle_len);
+                this->check(haystack, haystack.substr(pos, needle_len));
+            }
+        }
+    }
+}
+
+TYPED_TEST(searcher_fixture, periodic_needles)
+{
+    using string = typename TestFixture::string;
+    for (std::size_t len: {40, 300, 600})
+    {
+        string needle(len, 'a');
+        string haystack(5000, 'a');
+        this->check(haystack, needle);
+
+        needle.back() = 'b';
+        this->check(haystack, needle);
+        haystack[4000] = 'b';
+        this->check(haystack, needle);
+
+        string abab;
+        while (abab.size() < len)
+        {
+            abab += static_cast<TypeParam>('a');
+            abab += static_cast<TypeParam>('b');
+        }
+        string haystack2;
+        while (haystack2.size() < 5000)
+        {
+            haystack2 += abab.substr(0, len - 1);
+            haystack2 += static_cast<TypeParam>('c');
+        }
+        this->check(haystack2, abab);
+        this->check(haystack2 + abab, abab);
+    }
+}
+
+TEST(searcher, std_search_and_api_string_pattern)
+{
+    speudo_std::api_string pattern = "a needle that is longer than thirty-two characters";
+    speudo_std::api_string_searcher searcher{pattern};
+    EXPECT_EQ(searcher.needle().data(), pattern.data());
+
+    std::string text = "some text, " + std::string(pattern.data()) + ", more text";
+    const char* begin = text.c_str();
+    auto it = std::search(begin, begin + text.size(), searcher);
+    EXPECT_EQ(it - begin, 11);
+    EXPECT_TRUE(searcher.found_in(text.c_str()));
+    EXPECT_FALSE(searcher.found_in("some text"));
+}
+
+TEST(searcher, find_in)
+{
+    std::vector<speudo_std::api_string> payloads;
+    std::vector<std::size_t> expected;
+    for (std::size_t i = 0; i < 2000; ++i)
+    {
+        std::string payload(50 + i % 70, 'x');
+        if (i % 3 == 0)
+        {
+            std::size_t pos = i % 40;
+            payload.replace(pos, 6, "needle");
+            expected.push_back(pos);
+        }
+        else
+        {
+            expected.push_back(speudo_std::api_string_searcher::npos);
+        }
+        payloads.push_back({payload.data(), payload.size()});
+    }
+    speudo_std::api_string_searcher searcher{"needle"};
+    EXPECT_EQ(searcher.find_in(payloads, 4), expected);
+    EXPECT_EQ(searcher.find_in(payloads, 1), expected);
+    EXPECT_EQ(searcher.find_in(payloads), expected);
+    EXPECT_TRUE(searcher.find_in({}).empty());
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
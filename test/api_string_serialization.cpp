@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+#include <api_string_serialization.hpp>
+#include <api_string_io.hpp>
+#include <cstdio>
+#include <stdexcept>
+
+template <typename CharT>
+class basic_fixture: public ::testing::Test
+{
+public:
+
+    basic_fixture()
+    {
+        speudo_std::api_string_test::reset();
+        fill(m_small_buff, small_string_len());
+        fill(m_big_buff, big_string_len());
+    }
+
+    using char_type = CharT;
+    using api_string_type = speudo_std::basic_api_string<CharT>;
+    using data_type = speudo_std::abi::api_string_data<CharT>;
+
+    constexpr static std::size_t small_string_len()
+    {
+        return data_type::small_capacity();
+    }
+    constexpr static std::size_t big_string_len()
+    {
+        return 2 * data_type::small_capacity() + 3;
+    }
+
+    const CharT* small_string() const
+    {
+        return m_small_buff;
+    }
+
+    const CharT* big_string() const
+    {
+        return m_big_buff;
+    }
+
+    std::vector<api_string_type> sample() const
+    {
+        return { api_string_type{big_string()}
+               , api_string_type{}
+               , api_string_type{small_string()}
+               , api_string_type{big_string(), big_string_len() - 1}
+               , api_string_type{big_string()} };
+    }
+
+private:
+    CharT m_small_buff[small_string_len() + 1];
+    CharT m_big_buff[big_string_len() + 1];
+
+    static void fill(CharT* str, std::size_t len)
+    {
+        CharT c = ' ';
+        for (std::size_t i = 0; i < len; ++i)
+        {
+            str[i] = c;
+            c = (c == 'z') ? ' ' : c + 1;
+        }
+        str[len] = 0;
+    }
+};
+
+using all_char_types = ::testing::Types<char, wchar_t, char16_t, char32_t>;
+
+TYPED_TEST_CASE(basic_fixture, all_char_types);
+
+template <typename CharT>
+bool points_into(const speudo_std::basic_api_string<CharT>& s, const speudo_std::api_string& buff)
+{
+    auto p = reinterpret_cast<const char*>(s.data());
+    return p >= buff.data() && p < buff.data() + buff.size();
+}
+
+TYPED_TEST(basic_fixture, round_trip)
+{
+    using char_type = typename TestFixture::char_type;
+    const auto input = this->sample();
+    auto buff = speudo_std::serialize_api_strings(input.begin(), input.end());
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(buff.data()) % 8, 0);
+
+    auto allocations = speudo_std::api_string_test::allocations_count();
+    auto output = speudo_std::deserialize_api_strings<char_type>(buff);
+    EXPECT_EQ(speudo_std::api_string_test::allocations_count(), allocations);
+
+    ASSERT_EQ(output.size(), input.size());
+    for (std::size_t i = 0; i < input.size(); ++i)
+    {
+        EXPECT_EQ(output[i], input[i]);
+        EXPECT_EQ(output[i].c_str()[output[i].size()], char_type{});
+    }
+    EXPECT_TRUE(points_into(output[0], buff));
+    EXPECT_TRUE(points_into(output[3], buff));
+    EXPECT_FALSE(points_into(output[2], buff)); // small string optimization
+
+    // the strings keep the buffer alive
+    auto deallocations = speudo_std::api_string_test::deallocations_count();
+    buff.clear();
+    EXPECT_EQ(speudo_std::api_string_test::deallocations_count(), deallocations);
+    EXPECT_EQ(output[0], this->big_string());
+    output.clear();
+    EXPECT_EQ(speudo_std::api_string_test::deallocations_count(), deallocations + 1);
+}
+
+TYPED_TEST(basic_fixture, deduplication)
+{
+    using char_type = typename TestFixture::char_type;
+    const auto input = this->sample();
+    auto plain = speudo_std::serialize_api_strings(input.begin(), input.end());
+    auto dedup = speudo_std::serialize_api_strings(input.begin(), input.end(), true);
+    EXPECT_LT(dedup.size(), plain.size());
+
+    auto output = speudo_std::deserialize_api_strings<char_type>(dedup);
+    ASSERT_EQ(output.size(), input.size());
+    for (std::size_t i = 0; i < input.size(); ++i)
+    {
+        EXPECT_EQ(output[i], input[i]);
+    }
+    EXPECT_EQ(output[0].data(), output[4].data());
+}
+
+TYPED_TEST(basic_fixture, unmanaged_buffer)
+{
+    using char_type = typename TestFixture::char_type;
+    const auto input = this->sample();
+    auto buff = speudo_std::serialize_api_strings(input.begin(), input.end());
+    auto ref = speudo_std::api_string_ref(buff.data(), buff.size());
+
+    auto output = speudo_std::deserialize_api_strings<char_type>(ref);
+    ASSERT_EQ(output.size(), input.size());
+    EXPECT_EQ(output[0], input[0]);
+    EXPECT_TRUE(points_into(output[0], buff));
+}
+
+TYPED_TEST(basic_fixture, malformed_input)
+{
+    using char_type = typename TestFixture::char_type;
+    const auto input = this->sample();
+    auto buff = speudo_std::serialize_api_strings(input.begin(), input.end(), true);
+
+    speudo_std::string truncated{buff.data(), buff.size() - 8};
+    EXPECT_THROW( speudo_std::deserialize_api_strings<char_type>(std::move(truncated))
+                , std::invalid_argument );
+
+    speudo_std::string bad_magic{buff.data(), buff.size()};
+    bad_magic[0] = 'X';
+    EXPECT_THROW( speudo_std::deserialize_api_strings<char_type>(std::move(bad_magic))
+                , std::invalid_argument );
+
+    if (sizeof(char_type) != sizeof(char16_t))
+    {
+        EXPECT_THROW( speudo_std::deserialize_api_strings<char16_t>(buff)
+                    , std::invalid_argument );
+    }
+}
+
+TEST(serialization, memory_mapped_file)
+{
+    using speudo_std::string_literals::operator""_as;
+    std::vector<speudo_std::api_string> input =
+        { "a rather long string that does not fit in SSO"_as
+        , "short"_as
+        , "a rather long string that does not fit in SSO"_as };
+    auto buff = speudo_std::serialize_api_strings(input.begin(), input.end(), true);
+
+    char path[] = "/tmp/api_string_serialization_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    std::FILE* f = fdopen(fd, "wb");
+    std::fwrite(buff.data(), 1, buff.size(), f);
+    std::fclose(f);
+
+    std::vector<speudo_std::api_string> output;
+    {
+        auto mapped = speudo_std::map_file(path);
+        std::remove(path);
+        EXPECT_EQ(mapped.size(), buff.size());
+        EXPECT_EQ(mapped.c_str()[mapped.size()], '\0');
+        output = speudo_std::deserialize_api_strings<char>(mapped);
+        EXPECT_TRUE(points_into(output[0], mapped));
+    }
+    ASSERT_EQ(output.size(), 3);
+    EXPECT_EQ(output[0], input[0]);
+    EXPECT_EQ(output[1], input[1]);
+    EXPECT_EQ(output[2].data(), output[0].data());
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <api_string_shm.hpp>
+#include <stdexcept>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using speudo_std::string_literals::operator""_as;
+
+const char* long_text = "a string that is long enough not to fit in the small string optimization";
+
+template <typename CharT>
+bool unique(speudo_std::basic_api_string<CharT>& s)
+{
+    return speudo_std::_detail::basic_string_helper::get_data(s).big.mem_manager->unique();
+}
+
+TEST(shm_segment, make_share_and_adopt)
+{
+    auto seg = speudo_std::api_string_shm_segment::create(1 << 16);
+    auto other = speudo_std::api_string_shm_segment::attach(::dup(seg.fd()));
+    EXPECT_EQ(other.size(), seg.size());
+
+    speudo_std::api_string s = seg.make_string(long_text);
+    EXPECT_EQ(s, long_text);
+    EXPECT_EQ(s.c_str()[s.size()], '\0');
+    EXPECT_TRUE(unique(s));
+
+    auto handle = seg.share(s);
+    EXPECT_FALSE(unique(s));
+
+    auto received = other.adopt<char>(handle);
+    EXPECT_EQ(received, long_text);
+    EXPECT_NE(received.data(), s.data()); // different mapping of the same memory
+
+    auto copy = s;
+    s = speudo_std::api_string{};
+    EXPECT_FALSE(unique(copy));
+    received = speudo_std::api_string{};
+    EXPECT_TRUE(unique(copy));
+}
+
+TEST(shm_segment, strings_from_elsewhere_are_copied)
+{
+    auto seg = speudo_std::api_string_shm_segment::create(1 << 16);
+    speudo_std::api_u16string original{u"a utf-16 string that does not fit in the small string optimization"};
+
+    auto handle = seg.share(original);
+    auto received = seg.adopt<char16_t>(handle);
+    EXPECT_EQ(received, original);
+    EXPECT_NE(received.data(), original.data());
+
+    auto small_handle = seg.share("abc"_as);
+    auto small = seg.adopt<char>(small_handle);
+    EXPECT_EQ(small, "abc");
+}
+
+TEST(shm_segment, segment_outlives_its_object)
+{
+    speudo_std::api_string s;
+    {
+        auto seg = speudo_std::api_string_shm_segment::create(1 << 16);
+        s = seg.make_string(long_text);
+    }
+    EXPECT_EQ(s, long_text);
+}
+
+TEST(shm_segment, freed_blocks_are_reused)
+{
+    auto seg = speudo_std::api_string_shm_segment::create(4096);
+    const void* first;
+    {
+        auto s = seg.make_string(long_text);
+        first = s.data();
+    }
+    auto s = seg.make_string(long_text);
+    EXPECT_EQ(s.data(), first);
+
+    std::vector<speudo_std::api_string> strings;
+    EXPECT_THROW( while (true) strings.push_back(seg.make_string(long_text))
+                , std::bad_alloc );
+    EXPECT_FALSE(strings.empty());
+
+    auto handle = seg.share(strings.back());
+    strings.clear();
+    s = speudo_std::api_string{};
+    // the handle still holds a reference
+    EXPECT_EQ(seg.adopt<char>(handle), long_text);
+}
+
+TEST(shm_segment, invalid_handles)
+{
+    auto seg = speudo_std::api_string_shm_segment::create(1 << 16);
+    EXPECT_THROW(seg.adopt<char>(0), std::invalid_argument);
+    EXPECT_THROW(seg.adopt<char>(1 << 20), std::invalid_argument);
+    EXPECT_THROW(seg.adopt<char>(513), std::invalid_argument);
+
+    auto handle = seg.share(seg.make_string(long_text));
+    EXPECT_THROW(seg.adopt<char32_t>(handle), std::invalid_argument);
+    seg.discard(handle);
+}
+
+TEST(shm_segment, named_segment)
+{
+    std::string name = "/api_string_test_" + std::to_string(::getpid());
+    auto seg = speudo_std::api_string_shm_segment::create(1 << 16, name.c_str());
+    EXPECT_THROW( speudo_std::api_string_shm_segment::create(1 << 16, name.c_str())
+                , std::system_error );
+    auto other = speudo_std::api_string_shm_segment::open(name.c_str());
+    speudo_std::api_string_shm_segment::unlink(name.c_str());
+
+    auto handle = seg.share(seg.make_string(long_text));
+    EXPECT_EQ(other.adopt<char>(handle), long_text);
+    EXPECT_THROW( speudo_std::api_string_shm_segment::open(name.c_str())
+                , std::system_error );
+}
+
+TEST(shm_segment, across_processes)
+{
+    auto seg = speudo_std::api_string_shm_segment::create(1 << 16);
+    auto s = seg.make_string(long_text);
+    auto handle = seg.share(s);
+
+    int pipe_fds[2];
+    ASSERT_EQ(::pipe(pipe_fds), 0);
+    pid_t pid = ::fork();
+    ASSERT_GE(pid, 0);
+    if (pid == 0)
+    {
+        bool ok;
+        {
+            auto child_seg = speudo_std::api_string_shm_segment::attach(::dup(seg.fd()));
+            auto received = child_seg.adopt<char>(handle);
+            ok = received == long_text;
+            auto reply = child_seg.share(child_seg.make_string(u"sent by the child process, long enough"));
+            ok = ::write(pipe_fds[1], &reply, sizeof(reply)) == sizeof(reply) && ok;
+        }
+        ::_exit(ok ? 0 : 1);
+    }
+    speudo_std::api_string_shm_segment::handle_type reply;
+    ASSERT_EQ(::read(pipe_fds[0], &reply, sizeof(reply)), (ssize_t)sizeof(reply));
+    int status;
+    ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    ::close(pipe_fds[0]);
+    ::close(pipe_fds[1]);
+
+    // the child has released its reference
+    EXPECT_TRUE(unique(s));
+    EXPECT_EQ(seg.adopt<char16_t>(reply), u"sent by the child process, long enough");
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
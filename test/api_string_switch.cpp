@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include <api_string_switch.hpp>
+#include <algorithm>
+#include <string>
+
+using speudo_std::string_literals::operator""_as;
+
+constexpr auto methods = speudo_std::make_api_string_switch
+    ( "GET", "HEAD", "POST", "PUT", "DELETE", "CONNECT", "OPTIONS", "TRACE", "PATCH", "" );
+
+static_assert(methods.size() == 10);
+static_assert(methods("GET") == 0);
+static_assert(methods("PATCH") == 8);
+static_assert(methods("") == 9);
+static_assert(methods("GE") == methods.npos);
+static_assert(methods("GETS") == methods.npos);
+static_assert(methods.index("OPTIONS") == 6);
+
+int dispatch(const speudo_std::api_string& method)
+{
+    switch (methods(method))
+    {
+        case methods.index("GET"):    return 1;
+        case methods.index("POST"):   return 2;
+        case methods.index("DELETE"): return 3;
+        case methods.npos:            return -1;
+        default:                      return 0;
+    }
+}
+
+TEST(api_string_switch, dispatch)
+{
+    EXPECT_EQ(dispatch("GET"_as), 1);
+    EXPECT_EQ(dispatch(speudo_std::api_string{"POST"}), 2);
+    EXPECT_EQ(dispatch("DELETE"_as), 3);
+    EXPECT_EQ(dispatch("PUT"_as), 0);
+    EXPECT_EQ(dispatch("get"_as), -1);
+    EXPECT_EQ(dispatch(""_as), 0);
+}
+
+TEST(api_string_switch, all_char_types)
+{
+    constexpr auto u16 = speudo_std::make_api_string_switch(u"alpha", u"beta", u"gamma");
+    constexpr auto u32 = speudo_std::make_api_string_switch(U"alpha", U"beta", U"gamma");
+    constexpr auto w = speudo_std::make_api_string_switch(L"alpha", L"beta", L"gamma");
+    static_assert(u16(u"beta") == 1 && u32(U"gamma") == 2 && w(L"alpha") == 0);
+
+    EXPECT_EQ(u16(u"gamma"_as), 2);
+    EXPECT_EQ(u32(U"beta"_as), 1);
+    EXPECT_EQ(w(L"delta"_as), w.npos);
+}
+
+constexpr std::array<std::string_view, 64> many_keys()
+{
+    std::array<std::string_view, 64> keys{};
+    constexpr const char* names[] =
+        { "accept", "accept-charset", "accept-encoding", "accept-language"
+        , "accept-ranges", "access-control-allow-origin", "age", "allow"
+        , "authorization", "cache-control", "connection", "content-disposition"
+        , "content-encoding", "content-language", "content-length", "content-location"
+        , "content-range", "content-type", "cookie", "date", "etag", "expect"
+        , "expires", "from", "host", "if-match", "if-modified-since", "if-none-match"
+        , "if-range", "if-unmodified-since", "last-modified", "link", "location"
+        , "max-forwards", "proxy-authenticate", "proxy-authorization", "range"
+        , "referer", "refresh", "retry-after", "server", "set-cookie"
+        , "strict-transport-security", "transfer-encoding", "user-agent", "vary"
+        , "via", "www-authenticate", "a", "b", "c", "d", "e", "f", "g", "h"
+        , "ab", "ba", "abc", "acb", "bac", "bca", "cab", "cba" };
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        keys[i] = names[i];
+    }
+    return keys;
+}
+
+TEST(api_string_switch, many_strings)
+{
+    constexpr auto keys = many_keys();
+    constexpr auto headers = speudo_std::make_api_string_switch(keys);
+    static_assert(headers("www-authenticate") == 47);
+    for (std::size_t i = 0; i < keys.size(); ++i)
+    {
+        EXPECT_EQ(headers(keys[i]), i);
+        std::string s{keys[i]};
+        s += 'x';
+        EXPECT_EQ(headers(speudo_std::api_string{s.c_str()}), headers.npos);
+        s.pop_back();
+        s.pop_back();
+        auto it = std::find(keys.begin(), keys.end(), std::string_view{s});
+        std::size_t expected = it == keys.end() ? headers.npos : it - keys.begin();
+        EXPECT_EQ(headers(s.c_str(), s.size()), expected);
+    }
+}
+
+TEST(api_string_switch, duplicated_strings)
+{
+    std::array<std::string_view, 3> keys = {"a", "b", "a"};
+    EXPECT_THROW(speudo_std::make_api_string_switch(keys), std::invalid_argument);
+    EXPECT_THROW(methods.index("UNKNOWN"), std::invalid_argument);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+#include <api_string_table.hpp>
+#include <api_string_io.hpp>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+template <typename CharT>
+class basic_fixture: public ::testing::Test
+{
+public:
+
+    using char_type = CharT;
+    using api_string_type = speudo_std::basic_api_string<CharT>;
+
+    std::vector<api_string_type> sample() const
+    {
+        std::vector<api_string_type> v;
+        for (int i = 0; i < 300; ++i)
+        {
+            std::basic_string<CharT> s(static_cast<std::size_t>(i % 40), CharT('a' + i % 7));
+            s += CharT('A' + i % 26);
+            v.push_back(api_string_type{s.c_str(), s.size()});
+        }
+        v.push_back(api_string_type{});
+        v.push_back(v[3]);
+        return v;
+    }
+};
+
+using all_char_types = ::testing::Types<char, wchar_t, char16_t, char32_t>;
+
+TYPED_TEST_CASE(basic_fixture, all_char_types);
+
+TYPED_TEST(basic_fixture, lookup)
+{
+    using char_type = typename TestFixture::char_type;
+    using table_type = speudo_std::basic_api_string_table<char_type>;
+    const auto input = this->sample();
+    auto buff = speudo_std::make_api_string_table(input.begin(), input.end());
+
+    speudo_std::api_string_test::reset();
+    table_type table{buff};
+    ASSERT_FALSE(table.empty());
+    for (const auto& s : input)
+    {
+        auto i = table.find(s);
+        ASSERT_NE(i, table_type::npos);
+        EXPECT_EQ(table[i], s);
+        EXPECT_EQ(table[i].c_str()[s.size()], char_type{});
+        EXPECT_TRUE(table.contains(s.data(), s.size()));
+    }
+    const char_type absent[] = {'a', 'b', 'c', 0};
+    EXPECT_EQ(table.find(absent, 3), table_type::npos);
+    EXPECT_FALSE(table.contains(absent, 2));
+    EXPECT_EQ(speudo_std::api_string_test::allocations_count(), 0);
+}
+
+TYPED_TEST(basic_fixture, sorted_and_deduplicated)
+{
+    using char_type = typename TestFixture::char_type;
+    auto input = this->sample();
+    auto buff = speudo_std::make_api_string_table(input.begin(), input.end());
+    speudo_std::basic_api_string_table<char_type> table{buff};
+
+    std::sort(input.begin(), input.end());
+    input.erase(std::unique(input.begin(), input.end()), input.end());
+    ASSERT_EQ(table.size(), input.size());
+    for (std::size_t i = 0; i < input.size(); ++i)
+    {
+        EXPECT_EQ(table[i], input[i]);
+        EXPECT_EQ(table.find(input[i]), i);
+    }
+}
+
+TYPED_TEST(basic_fixture, strings_reference_the_buffer)
+{
+    using char_type = typename TestFixture::char_type;
+    const auto input = this->sample();
+    auto buff = speudo_std::make_api_string_table(input.begin(), input.end());
+    speudo_std::basic_api_string_table<char_type> table{buff};
+
+    auto s = table[table.size() - 1];
+    auto p = reinterpret_cast<const char*>(s.data());
+    EXPECT_TRUE(p >= buff.data() && p < buff.data() + buff.size());
+}
+
+TYPED_TEST(basic_fixture, malformed_input)
+{
+    using char_type = typename TestFixture::char_type;
+    using table_type = speudo_std::basic_api_string_table<char_type>;
+    const auto input = this->sample();
+    auto buff = speudo_std::make_api_string_table(input.begin(), input.end());
+
+    speudo_std::string bad_magic{buff.data(), buff.size()};
+    bad_magic[0] = 'X';
+    EXPECT_THROW(table_type{std::move(bad_magic)}, std::invalid_argument);
+
+    speudo_std::string truncated{buff.data(), 100};
+    EXPECT_THROW(table_type{std::move(truncated)}, std::invalid_argument);
+
+    speudo_std::string missing_strings{buff.data(), buff.size() - 8};
+    table_type table{std::move(missing_strings)};
+    EXPECT_THROW(table[table.size() - 1], std::invalid_argument);
+
+    if (sizeof(char_type) != sizeof(char16_t))
+    {
+        EXPECT_THROW(speudo_std::api_u16string_table{buff}, std::invalid_argument);
+    }
+}
+
+TEST(string_table, empty_table)
+{
+    std::vector<speudo_std::api_string> input;
+    speudo_std::api_string_table table{speudo_std::make_api_string_table(input.begin(), input.end())};
+    EXPECT_TRUE(table.empty());
+    EXPECT_EQ(table.find("a", 1), speudo_std::api_string_table::npos);
+}
+
+TEST(string_table, memory_mapped_file)
+{
+    using speudo_std::string_literals::operator""_as;
+    std::vector<speudo_std::api_string> input =
+        { "error: file not found"_as, "warning: unused variable"_as, "note"_as };
+    auto buff = speudo_std::make_api_string_table(input.begin(), input.end());
+
+    char path[] = "/tmp/api_string_table_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    std::FILE* f = fdopen(fd, "wb");
+    std::fwrite(buff.data(), 1, buff.size(), f);
+    std::fclose(f);
+
+    speudo_std::api_string_test::reset();
+    speudo_std::api_string_table table{speudo_std::map_file(path)};
+    std::remove(path);
+    EXPECT_EQ(speudo_std::api_string_test::allocations_count(), 0);
+    ASSERT_EQ(table.size(), 3);
+    EXPECT_EQ(table[0], "error: file not found");
+    EXPECT_EQ(table[table.find("note"_as)], "note");
+}
+
+TEST(string_table, immortal_strings_outlive_the_table)
+{
+    using speudo_std::string_literals::operator""_as;
+    std::vector<speudo_std::api_string> input = { "first"_as, "second"_as };
+    speudo_std::api_string s;
+    const char* buff_data = nullptr;
+    {
+        speudo_std::api_string_table table
+            { speudo_std::make_api_string_table(input.begin(), input.end()) };
+        table.make_immortal();
+        buff_data = table.buffer().data();
+        s = table[table.find("second"_as)];
+    }
+    EXPECT_EQ(s, "second");
+    EXPECT_TRUE(s.data() > buff_data);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,332 @@
+#include <gtest/gtest.h>
+#include <api_string_utf.hpp>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// The reference implementation, from the definitions of the encodings
+
+static std::string encode_utf8(const std::u32string& cps)
+{
+    std::string s;
+    for (char32_t cp : cps)
+    {
+        if (cp < 0x80)
+        {
+            s.push_back(static_cast<char>(cp));
+            continue;
+        }
+        int n = cp < 0x800 ? 1 : cp < 0x10000 ? 2 : 3;
+        const unsigned lead[] = {0, 0xC0, 0xE0, 0xF0};
+        s.push_back(static_cast<char>(lead[n] | (cp >> (6 * n))));
+        for (int k = n - 1; k >= 0; --k)
+        {
+            s.push_back(static_cast<char>(0x80 | ((cp >> (6 * k)) & 0x3F)));
+        }
+    }
+    return s;
+}
+
+static std::u16string encode_utf16(const std::u32string& cps)
+{
+    std::u16string s;
+    for (char32_t cp : cps)
+    {
+        if (cp < 0x10000)
+        {
+            s.push_back(static_cast<char16_t>(cp));
+        }
+        else
+        {
+            s.push_back(static_cast<char16_t>(0xD800 | ((cp - 0x10000) >> 10)));
+            s.push_back(static_cast<char16_t>(0xDC00 | ((cp - 0x10000) & 0x3FF)));
+        }
+    }
+    return s;
+}
+
+static bool reference_valid_utf8(const std::string& s)
+{
+    for (std::size_t i = 0; i < s.size(); )
+    {
+        const unsigned c = static_cast<unsigned char>(s[i]);
+        std::size_t n = c < 0x80 ? 0 : c >= 0xC0 && c < 0xE0 ? 1
+                      : c >= 0xE0 && c < 0xF0 ? 2 : c >= 0xF0 && c < 0xF8 ? 3 : 4;
+        if (n == 4 || (n != 0 && i + n >= s.size()))
+        {
+            return false;
+        }
+        char32_t cp = n == 0 ? c : c & (0x3F >> n);
+        for (std::size_t k = 1; k <= n; ++k)
+        {
+            const unsigned b = static_cast<unsigned char>(s[i + k]);
+            if ((b & 0xC0) != 0x80)
+            {
+                return false;
+            }
+            cp = (cp << 6) | (b & 0x3F);
+        }
+        const char32_t min[] = {0, 0x80, 0x800, 0x10000};
+        if (cp < min[n] || cp > 0x10FFFF || (cp >= 0xD800 && cp < 0xE000))
+        {
+            return false;
+        }
+        i += n + 1;
+    }
+    return true;
+}
+
+class utf_fixture: public ::testing::Test
+{
+public:
+
+    utf_fixture()
+    {
+        // runs of ASCII and of code points of each length, so that both
+        // the whole registers and the code points split between two
+        // registers are tested
+        std::mt19937 gen(7);
+        const char32_t ranges[][2] =
+            { {0x00, 0x7F}, {0x80, 0x7FF}, {0x800, 0xD7FF}
+            , {0xE000, 0xFFFF}, {0x10000, 0x10FFFF} };
+        for (int i = 0; i < 200; ++i)
+        {
+            std::u32string cps;
+            const std::size_t len = i < 70 ? i : gen() % 400;
+            while (cps.size() < len)
+            {
+                const auto& r = ranges[gen() % (i % 3 == 0 ? 1 : 5)];
+                const std::size_t run = 1 + gen() % 40;
+                for (std::size_t k = 0; k < run && cps.size() < len; ++k)
+                {
+                    cps.push_back(static_cast<char32_t>(r[0] + gen() % (r[1] - r[0] + 1)));
+                }
+            }
+            m_texts.push_back(cps);
+        }
+    }
+
+    ~utf_fixture()
+    {
+        speudo_std::api_string_test::force_find_isa(-1);
+    }
+
+    template <typename F>
+    void for_each_isa(F f)
+    {
+        for (int isa: {0, 1, 2})
+        {
+            speudo_std::api_string_test::force_find_isa(isa);
+            f();
+        }
+    }
+
+    std::vector<std::u32string> m_texts;
+};
+
+template <typename CharT>
+static std::basic_string<CharT> to_std(const speudo_std::basic_api_string<CharT>& s)
+{
+    return std::basic_string<CharT>(s.data(), s.size());
+}
+
+TEST_F(utf_fixture, transcoding_of_valid_strings)
+{
+    for_each_isa([&]
+    {
+        for (const auto& cps : m_texts)
+        {
+            const std::string u8 = encode_utf8(cps);
+            const std::u16string u16 = encode_utf16(cps);
+            const speudo_std::api_string a8{u8.data(), u8.size()};
+            const speudo_std::api_u16string a16{u16.data(), u16.size()};
+            const speudo_std::api_u32string a32{cps.data(), cps.size()};
+
+            ASSERT_TRUE(speudo_std::is_valid_utf(a8));
+            ASSERT_TRUE(speudo_std::is_valid_utf(a16));
+            ASSERT_TRUE(speudo_std::is_valid_utf(a32));
+
+            EXPECT_EQ(speudo_std::utf_transcoded_length<char16_t>(a8), u16.size());
+            EXPECT_EQ(speudo_std::utf_transcoded_length<char32_t>(a8), cps.size());
+            EXPECT_EQ(speudo_std::utf_transcoded_length<char>(a16), u8.size());
+            EXPECT_EQ(speudo_std::utf_transcoded_length<char32_t>(a16), cps.size());
+            EXPECT_EQ(speudo_std::utf_transcoded_length<char>(a32), u8.size());
+            EXPECT_EQ(speudo_std::utf_transcoded_length<char16_t>(a32), u16.size());
+
+            EXPECT_EQ(to_std(speudo_std::utf_transcode<char16_t>(a8)), u16);
+            EXPECT_EQ(to_std(speudo_std::utf_transcode<char32_t>(a8)), cps);
+            EXPECT_EQ(to_std(speudo_std::utf_transcode<char>(a16)), u8);
+            EXPECT_EQ(to_std(speudo_std::utf_transcode<char32_t>(a16)), cps);
+            EXPECT_EQ(to_std(speudo_std::utf_transcode<char>(a32)), u8);
+            EXPECT_EQ(to_std(speudo_std::utf_transcode<char16_t>(a32)), u16);
+            EXPECT_EQ(to_std(speudo_std::utf_transcode<char>(a8)), u8);
+
+            auto w = speudo_std::utf_transcode<wchar_t>(a8);
+            EXPECT_EQ(to_std(speudo_std::utf_transcode<char>(w)), u8);
+            EXPECT_EQ(w.size(), sizeof(wchar_t) == 2 ? u16.size() : cps.size());
+        }
+    });
+}
+
+TEST_F(utf_fixture, two_bytes_sequences)
+{
+    // Latin, Greek and Cyrillic text, whose code points take one or two
+    // bytes in UTF-8, with some code points of three or four bytes
+    std::mt19937 gen(5);
+    std::vector<std::u32string> texts;
+    for (int i = 0; i < 300; ++i)
+    {
+        std::u32string cps;
+        const std::size_t len = gen() % 300;
+        while (cps.size() < len)
+        {
+            const unsigned r = gen() % 40;
+            cps.push_back( r < 10 ? U' ' + gen() % 95
+                         : r < 38 ? 0x80 + gen() % 0x780
+                         : r == 38 ? 0x800 + gen() % 0x7000
+                         : 0x10000 + gen() % 0x1000 );
+        }
+        texts.push_back(cps);
+    }
+    for_each_isa([&]
+    {
+        for (const auto& cps : texts)
+        {
+            const std::string u8 = encode_utf8(cps);
+            const speudo_std::api_string a8{u8.data(), u8.size()};
+            ASSERT_TRUE(speudo_std::is_valid_utf(a8));
+            ASSERT_EQ(to_std(speudo_std::utf_transcode<char16_t>(a8)), encode_utf16(cps));
+            ASSERT_EQ(to_std(speudo_std::utf_transcode<char32_t>(a8)), cps);
+        }
+    });
+}
+
+TEST_F(utf_fixture, invalid_utf8)
+{
+    const char* invalid[] =
+        { "\x80", "\xBF", "\xC0\x80", "\xC1\xBF", "\xE0\x80\x80", "\xE0\x9F\xBF"
+        , "\xED\xA0\x80", "\xED\xBF\xBF", "\xF0\x80\x80\x80", "\xF0\x8F\xBF\xBF"
+        , "\xF4\x90\x80\x80", "\xF5\x80\x80\x80", "\xFF", "\xE2\x82", "\xE2\x82x"
+        , "\xC3", "\xF0\x9F\x98", "\xC3\xA9\xA9" };
+    const std::size_t offsets[] = {0, 1, 14, 15, 16, 30, 31, 32, 33, 62, 63};
+    for_each_isa([&]
+    {
+        for (const char* bad : invalid)
+        {
+            for (std::size_t offset : offsets)
+            {
+                for (std::size_t after : {0, 1, 40})
+                {
+                    std::string s = std::string(offset, 'a') + bad + std::string(after, 'z');
+                    speudo_std::api_string_view v{s.data(), s.size()};
+                    EXPECT_FALSE(speudo_std::is_valid_utf(v)) << offset << " " << after;
+                    EXPECT_EQ(speudo_std::utf_transcoded_length<char16_t>(v), std::size_t(-1));
+                    EXPECT_THROW(speudo_std::utf_transcode<char16_t>(v), std::invalid_argument);
+                }
+            }
+        }
+
+        // the boundaries of the valid ranges
+        const char* valid[] =
+            { "\xC2\x80", "\xDF\xBF", "\xE0\xA0\x80", "\xED\x9F\xBF", "\xEE\x80\x80"
+            , "\xF0\x90\x80\x80", "\xF4\x8F\xBF\xBF" };
+        for (const char* good : valid)
+        {
+            for (std::size_t offset : offsets)
+            {
+                std::string s = std::string(offset, 'a') + good;
+                EXPECT_TRUE(speudo_std::is_valid_utf(speudo_std::api_string_view{s.data(), s.size()}));
+            }
+        }
+    });
+}
+
+TEST_F(utf_fixture, random_bytes)
+{
+    std::mt19937 gen(11);
+    std::vector<std::string> samples;
+    for (int i = 0; i < 3000; ++i)
+    {
+        // mostly valid text, with a few random bytes
+        std::string s = encode_utf8(m_texts[i % m_texts.size()]);
+        for (int k = i % 3; k > 0 && ! s.empty(); --k)
+        {
+            s[gen() % s.size()] = static_cast<char>(gen());
+        }
+        samples.push_back(s);
+    }
+    for_each_isa([&]
+    {
+        for (const auto& s : samples)
+        {
+            ASSERT_EQ( speudo_std::is_valid_utf(speudo_std::api_string_view{s.data(), s.size()})
+                     , reference_valid_utf8(s) );
+        }
+    });
+}
+
+TEST_F(utf_fixture, invalid_utf16_and_utf32)
+{
+    for_each_isa([&]
+    {
+        for (std::size_t offset : {0, 1, 7, 8, 15, 16, 17, 40})
+        {
+            const std::u16string prefix(offset, u'a');
+            for (std::u16string bad : { std::u16string{0xD800}, std::u16string{0xDC00}
+                                      , std::u16string{0xDBFF, u'a'}
+                                      , std::u16string{0xDC00, 0xD800}
+                                      , std::u16string{0xD800, 0xD800} })
+            {
+                for (std::size_t after : {0, 1, 20})
+                {
+                    std::u16string s = prefix + bad + std::u16string(after, u'z');
+                    speudo_std::api_u16string_view v{s.data(), s.size()};
+                    EXPECT_FALSE(speudo_std::is_valid_utf(v));
+                    EXPECT_THROW(speudo_std::utf_transcode<char>(v), std::invalid_argument);
+                }
+            }
+            std::u16string pair = prefix + std::u16string{0xD83D, 0xDE00};
+            EXPECT_TRUE(speudo_std::is_valid_utf(speudo_std::api_u16string_view{pair.data(), pair.size()}));
+
+            const std::u32string prefix32(offset, U'a');
+            for (char32_t bad : {char32_t{0xD800}, char32_t{0xDFFF}, char32_t{0x110000}, char32_t{0xFFFFFFFF}})
+            {
+                std::u32string s = prefix32 + bad + std::u32string(5, U'z');
+                speudo_std::api_u32string_view v{s.data(), s.size()};
+                EXPECT_FALSE(speudo_std::is_valid_utf(v));
+                EXPECT_EQ(speudo_std::utf_transcoded_length<char>(v), std::size_t(-1));
+            }
+        }
+    });
+}
+
+TEST(utf, single_allocation)
+{
+    std::string text;
+    for (int i = 0; i < 1000; ++i)
+    {
+        text += "caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80 ";
+    }
+    speudo_std::api_string_test::reset();
+    {
+        auto u16 = speudo_std::utf_transcode<char16_t>(speudo_std::api_string_view{text.data(), text.size()});
+        EXPECT_EQ(speudo_std::api_string_test::allocations_count(), 1);
+        EXPECT_EQ(u16.c_str()[u16.size()], u'\0');
+
+        auto back = speudo_std::utf_transcode<char>(u16);
+        EXPECT_EQ(speudo_std::api_string_test::allocations_count(), 2);
+        EXPECT_EQ(std::string(back.data(), back.size()), text);
+
+        // small results use the small string optimization
+        auto small = speudo_std::utf_transcode<char16_t>(speudo_std::api_string_view{"caf\xC3\xA9"});
+        EXPECT_EQ(speudo_std::api_string_test::allocations_count(), 2);
+        EXPECT_EQ(small, speudo_std::api_u16string{u"café"});
+    }
+    EXPECT_EQ(speudo_std::api_string_test::deallocations_count(), 2);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,158 @@
+#include <gtest/gtest.h>
+#include <string.hpp>
+#include <type_traits>
+
+template <typename CharT>
+class basic_fixture: public ::testing::Test
+{
+public:
+
+    basic_fixture()
+    {
+        speudo_std::api_string_test::reset();
+        fill(m_small_buff, small_string_len());
+        fill(m_big_buff, big_string_len());
+    }
+
+    using char_type = CharT;
+    using api_string_type = speudo_std::basic_api_string<CharT>;
+    using view_type = speudo_std::basic_api_string_view<CharT>;
+    using data_type = speudo_std::abi::api_string_data<CharT>;
+
+    constexpr static std::size_t small_string_len()
+    {
+        return data_type::small_capacity();
+    }
+    constexpr static std::size_t big_string_len()
+    {
+        return 2 * data_type::small_capacity() + 3;
+    }
+
+    const CharT* small_string() const
+    {
+        return m_small_buff;
+    }
+
+    const CharT* big_string() const
+    {
+        return m_big_buff;
+    }
+
+private:
+    CharT m_small_buff[small_string_len() + 1];
+    CharT m_big_buff[big_string_len() + 1];
+
+    static void fill(CharT* str, std::size_t len)
+    {
+        CharT c = 'a';
+        for (std::size_t i = 0; i < len; ++i)
+        {
+            str[i] = c;
+            c = (c == 'z') ? 'a' : c + 1;
+        }
+        str[len] = 0;
+    }
+};
+
+using all_char_types = ::testing::Types<char, wchar_t, char16_t, char32_t>;
+
+TYPED_TEST_CASE(basic_fixture, all_char_types);
+
+static_assert(std::is_trivially_copyable<speudo_std::api_string_view>::value);
+static_assert(std::is_trivially_copyable<speudo_std::api_u32string_view>::value);
+
+TYPED_TEST(basic_fixture, views_do_not_touch_reference_counters)
+{
+    using view_type = typename TestFixture::view_type;
+    typename TestFixture::api_string_type str{this->big_string()};
+    view_type v = str;
+    EXPECT_EQ(v.data(), str.data());
+    EXPECT_EQ(v.size(), this->big_string_len());
+
+    auto& manager = *speudo_std::_detail::basic_string_helper::get_data(str).big.mem_manager;
+    EXPECT_TRUE(manager.unique());
+    view_type copy = v;
+    copy.remove_prefix(1);
+    EXPECT_TRUE(manager.unique());
+    EXPECT_EQ(copy.size(), v.size() - 1);
+}
+
+TYPED_TEST(basic_fixture, to_api_string_shares_memory)
+{
+    using view_type = typename TestFixture::view_type;
+    typename TestFixture::api_string_type str{this->big_string()};
+    auto allocations = speudo_std::api_string_test::allocations_count();
+    EXPECT_EQ(allocations, 1);
+
+    view_type v = str;
+    v.remove_prefix(2);
+    auto promoted = v.to_api_string();
+    EXPECT_EQ(promoted.data(), str.data() + 2);
+    EXPECT_EQ(promoted, this->big_string() + 2);
+    EXPECT_EQ(promoted.c_str()[promoted.size()], 0);
+    EXPECT_EQ(speudo_std::api_string_test::allocations_count(), allocations);
+
+    // the promoted string keeps the memory alive
+    str.clear();
+    EXPECT_EQ(speudo_std::api_string_test::deallocations_count(), 0);
+    promoted.clear();
+    EXPECT_EQ(speudo_std::api_string_test::deallocations_count(), 1);
+}
+
+TYPED_TEST(basic_fixture, to_api_string_copies_otherwise)
+{
+    using view_type = typename TestFixture::view_type;
+    typename TestFixture::api_string_type str{this->big_string()};
+
+    view_type prefix = view_type(str).substr(0, this->big_string_len() - 1);
+    auto promoted = prefix.to_api_string();
+    EXPECT_NE(promoted.data(), str.data());
+    EXPECT_EQ(promoted.size(), this->big_string_len() - 1);
+    EXPECT_EQ(promoted.c_str()[promoted.size()], 0);
+
+    view_type raw{this->big_string()};
+    auto copy = raw.to_api_string();
+    EXPECT_NE(copy.data(), raw.data());
+    EXPECT_EQ(copy, this->big_string());
+
+    typename TestFixture::api_string_type small{this->small_string()};
+    EXPECT_EQ(view_type(small).to_api_string(), small);
+
+    speudo_std::basic_string<typename TestFixture::char_type> bstr{this->big_string()};
+    view_type from_string = bstr;
+    EXPECT_EQ(from_string.data(), bstr.data());
+    EXPECT_NE(from_string.to_api_string().data(), bstr.data());
+}
+
+TYPED_TEST(basic_fixture, comparison)
+{
+    using char_type = typename TestFixture::char_type;
+    using view_type = typename TestFixture::view_type;
+    typename TestFixture::api_string_type str{this->big_string()};
+    view_type v = str;
+    const char_type abc[] = {'a', 'b', 'c', 0};
+    const char_type abd[] = {'a', 'b', 'd', 0};
+
+    EXPECT_TRUE(v == str);
+    EXPECT_TRUE(str == v);
+    EXPECT_TRUE(v == this->big_string());
+    EXPECT_TRUE(view_type(abc) < view_type(abd));
+    EXPECT_TRUE(view_type(abc) < abd);
+    EXPECT_TRUE(abd > view_type(abc));
+    EXPECT_TRUE(view_type(abc) != str);
+    EXPECT_TRUE(v.starts_with(abc));
+    EXPECT_TRUE(str.starts_with(abc));
+    EXPECT_TRUE(str.starts_with(view_type(abc)));
+    EXPECT_FALSE(str.starts_with(abd));
+    EXPECT_TRUE(str.ends_with(v.substr(v.size() / 2)));
+    EXPECT_TRUE(str.ends_with(this->big_string() + 3));
+    EXPECT_TRUE(str.ends_with(str.back()));
+    EXPECT_FALSE(str.ends_with(abc));
+    EXPECT_TRUE(view_type(abc).ends_with(char_type('c')));
+    EXPECT_THROW(v.substr(v.size() + 1), std::out_of_range);
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
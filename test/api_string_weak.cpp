@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include <api_string_weak.hpp>
+#include <string.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using speudo_std::string_literals::operator""_as;
+
+const char* long_text = "a string that is long enough not to fit in the small string optimization";
+
+TEST(weak_api_string, lock_and_expire)
+{
+    speudo_std::api_string_test::reset();
+    {
+        speudo_std::weak_api_string w;
+        EXPECT_TRUE(w.lock().empty());
+        EXPECT_FALSE(w.expired());
+        {
+            speudo_std::api_string s{long_text};
+            w = s;
+            EXPECT_FALSE(w.expired());
+            auto locked = w.lock();
+            EXPECT_EQ(locked, long_text);
+            EXPECT_EQ(locked.data(), s.data());
+        }
+        EXPECT_TRUE(w.expired());
+        EXPECT_TRUE(w.lock().empty());
+
+        // the memory is kept until the weak reference is released
+        EXPECT_EQ(speudo_std::api_string_test::allocations_count(), 1);
+        EXPECT_EQ(speudo_std::api_string_test::deallocations_count(), 0);
+        w.reset();
+        EXPECT_EQ(speudo_std::api_string_test::deallocations_count(), 1);
+    }
+    EXPECT_EQ(speudo_std::api_string_test::deallocations_count(), 1);
+}
+
+TEST(weak_api_string, copy_and_move)
+{
+    speudo_std::api_string_test::reset();
+    {
+        speudo_std::api_string s{long_text};
+        speudo_std::weak_api_string w1{s};
+        speudo_std::weak_api_string w2{w1};
+        speudo_std::weak_api_string w3{std::move(w1)};
+        EXPECT_TRUE(w1.lock().empty());
+        EXPECT_EQ(w2.lock(), long_text);
+        EXPECT_EQ(w3.lock(), long_text);
+        w1 = w3;
+        s = "other"_as;
+        EXPECT_TRUE(w1.expired());
+        EXPECT_TRUE(w2.expired());
+        EXPECT_TRUE(w3.expired());
+    }
+    EXPECT_EQ(speudo_std::api_string_test::allocations_count(), 1);
+    EXPECT_EQ(speudo_std::api_string_test::deallocations_count(), 1);
+}
+
+TEST(weak_api_string, unmanaged_strings_never_expire)
+{
+    speudo_std::weak_api_string w_small;
+    speudo_std::weak_api_string w_ref;
+    {
+        speudo_std::api_string small{"small"};
+        speudo_std::api_string ref = speudo_std::api_string_ref(long_text);
+        w_small = small;
+        w_ref = ref;
+    }
+    EXPECT_FALSE(w_small.expired());
+    EXPECT_EQ(w_small.lock(), "small");
+    EXPECT_FALSE(w_ref.expired());
+    EXPECT_EQ(w_ref.lock(), long_text);
+}
+
+TEST(weak_api_string, observed_string_is_not_stolen)
+{
+    speudo_std::api_string s{long_text};
+    const char* original = s.data();
+    speudo_std::weak_api_string w{s};
+
+    // basic_string must not take over a memory block that can still be locked
+    speudo_std::string str{std::move(s)};
+    EXPECT_NE(str.data(), original);
+    str[0] = 'A';
+    EXPECT_EQ(w.lock(), long_text);
+    s = speudo_std::api_string{};
+    EXPECT_TRUE(w.expired());
+}
+
+TEST(weak_api_string, concurrent_lock_and_release)
+{
+    for (int round = 0; round < 200; ++round)
+    {
+        auto s = std::make_unique<speudo_std::api_string>(long_text);
+        speudo_std::weak_api_string w{*s};
+        std::atomic<int> errors{0};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 3; ++t)
+        {
+            threads.emplace_back([&]
+            {
+                for (int i = 0; i < 100; ++i)
+                {
+                    auto locked = w.lock();
+                    errors += locked.empty() || locked == long_text ? 0 : 1;
+                }
+            });
+        }
+        s.reset();
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+        EXPECT_EQ(errors.load(), 0);
+        EXPECT_TRUE(w.expired());
+    }
+}
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
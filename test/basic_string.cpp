@@ -919,6 +919,376 @@ TYPED_TEST(basic_fixture, construct_from_const_api_string)
     }
 }
 
+TYPED_TEST(basic_fixture, construct_copy_on_write)
+{
+    // basic_string
+    //     ( const basic_api_string<CharT>& other
+    //     , copy_on_write_t
+    //     , const Allocator& alloc = Allocator{} )
+
+    using char_type = typename TestFixture::char_type;
+    using api_string_type = speudo_std::basic_api_string<char_type>;
+    using str_type = speudo_std::basic_string< char_type
+                                             , std::char_traits<char_type>
+                                             , custom_allocator<char_type> >;
+    const auto len = this->even_bigger_raw_string_len();
+    const char_type first = this->even_bigger_raw_string()[0];
+    {   // reading does not copy
+        allocator_log log;
+        custom_allocator<char_type> a(log);
+        api_string_type astr = this->even_bigger_raw_string();
+        const str_type str(astr, speudo_std::copy_on_write, a);
+        str_type str2 = str;
+        EXPECT_EQ(str.data(), astr.data());
+        EXPECT_EQ(str2.c_str(), astr.data());
+        EXPECT_EQ(str.size(), len);
+        EXPECT_EQ(str.capacity(), len);
+        EXPECT_EQ(str[0], first);
+        api_string_type back = str;
+        EXPECT_EQ(back.data(), astr.data());
+        EXPECT_EQ(log.allocations_count(), 0);
+    }
+    {   // modifications copy first
+        allocator_log log;
+        custom_allocator<char_type> a(log);
+        api_string_type astr = this->even_bigger_raw_string();
+        str_type str(astr, speudo_std::copy_on_write, a);
+        str_type str2 = str;
+        str[0] = 'X';
+        EXPECT_EQ(log.allocations_count(), 1);
+        EXPECT_NE(str.data(), astr.data());
+        EXPECT_EQ(str[0], 'X');
+        EXPECT_EQ(astr[0], first);
+        EXPECT_EQ(str2.c_str(), astr.data());
+
+        str2.push_back('Y');
+        EXPECT_EQ(log.allocations_count(), 2);
+        EXPECT_EQ(str2.size(), len + 1);
+        EXPECT_EQ(str2[len], 'Y');
+        EXPECT_EQ(astr.size(), len);
+    }
+    {
+        api_string_type astr = this->even_bigger_raw_string();
+        str_type str(astr, speudo_std::copy_on_write);
+        str.pop_back();
+        EXPECT_EQ(str.size(), len - 1);
+        EXPECT_EQ(str.c_str()[len - 1], char_type{});
+        EXPECT_EQ(astr.size(), len);
+        EXPECT_EQ(astr.c_str()[len - 1], this->even_bigger_raw_string()[len - 1]);
+
+        str_type str2(astr, speudo_std::copy_on_write);
+        str2.clear();
+        EXPECT_TRUE(str2.empty());
+        EXPECT_EQ(astr.size(), len);
+
+        str_type str3(astr, speudo_std::copy_on_write);
+        str3.resize(1);
+        EXPECT_EQ(str3.size(), 1);
+        EXPECT_EQ(astr.size(), len);
+    }
+    {   // small and unmanaged strings are copied immediately
+        allocator_log log;
+        custom_allocator<char_type> a(log);
+        api_string_type small = this->small_raw_string();
+        str_type str(small, speudo_std::copy_on_write, a);
+        EXPECT_EQ(log.allocations_count(), 0);
+        EXPECT_NE(str.data(), small.data());
+
+        api_string_type ref = speudo_std::api_string_ref(this->even_bigger_raw_string());
+        str_type str2(ref, speudo_std::copy_on_write, a);
+        EXPECT_EQ(log.allocations_count(), 1);
+        EXPECT_NE(str2.c_str(), ref.data());
+    }
+    EXPECT_EQ( speudo_std::api_string_test::allocations_count()
+             , speudo_std::api_string_test::deallocations_count() );
+}
+
+TYPED_TEST(basic_fixture, resize_and_overwrite)
+{
+    using char_type = typename TestFixture::char_type;
+    using api_string_type = speudo_std::basic_api_string<char_type>;
+    using str_type = speudo_std::basic_string<char_type>;
+
+    const auto len = this->even_bigger_raw_string_len();
+    str_type str = this->small_raw_string();
+    const char_type first = str[0];
+    str.resize_and_overwrite
+        ( len
+        , [&](char_type* p, std::size_t count)
+          {
+              EXPECT_EQ(count, len);
+              EXPECT_EQ(p[0], first);
+              for (std::size_t i = 1; i < count - 1; ++i)
+              {
+                  p[i] = 'x';
+              }
+              return count - 1;
+          } );
+    EXPECT_EQ(str.size(), len - 1);
+    EXPECT_EQ(str[0], first);
+    EXPECT_EQ(str[len - 2], 'x');
+    EXPECT_EQ(str.c_str()[len - 1], char_type{});
+
+    str.resize_and_overwrite(2, [](char_type* p, std::size_t) { p[1] = 'y'; return 2; });
+    EXPECT_EQ(str.size(), 2);
+    EXPECT_EQ(str[0], first);
+    EXPECT_EQ(str[1], 'y');
+    EXPECT_EQ(str.c_str()[2], char_type{});
+
+    // a shared string is copied first
+    api_string_type astr = this->even_bigger_raw_string();
+    str_type cow{astr, speudo_std::copy_on_write};
+    cow.resize_and_overwrite(1, [](char_type* p, std::size_t) { p[0] = 'z'; return 1; });
+    EXPECT_EQ(cow.size(), 1);
+    EXPECT_EQ(cow[0], 'z');
+    EXPECT_EQ(astr.size(), len);
+    EXPECT_EQ(astr[0], this->even_bigger_raw_string()[0]);
+}
+
+TYPED_TEST(basic_fixture, append_uninitialized)
+{
+    using char_type = typename TestFixture::char_type;
+    using str_type = speudo_std::basic_string<char_type>;
+
+    str_type str;
+    char_type* p = str.append_uninitialized(this->small_raw_string_len());
+    std::char_traits<char_type>::copy(p, this->small_raw_string(), this->small_raw_string_len());
+    EXPECT_EQ(str, this->small_raw_string());
+
+    const auto len = this->even_bigger_raw_string_len();
+    p = str.append_uninitialized(len);
+    EXPECT_EQ(p, str.data() + this->small_raw_string_len());
+    std::char_traits<char_type>::copy(p, this->even_bigger_raw_string(), len);
+    EXPECT_EQ(str.size(), this->small_raw_string_len() + len);
+    EXPECT_EQ(str.c_str()[str.size()], char_type{});
+    EXPECT_EQ(str[this->small_raw_string_len()], this->even_bigger_raw_string()[0]);
+}
+
+TYPED_TEST(basic_fixture, edit_api_string)
+{
+    using char_type = typename TestFixture::char_type;
+    using api_string_type = speudo_std::basic_api_string<char_type>;
+    using str_type = speudo_std::basic_string<char_type>;
+
+    auto set_first = [](str_type& str) { str[0] = 'X'; };
+    {   // unique: modified in place
+        api_string_type astr = this->even_bigger_raw_string();
+        const char_type* original = astr.data();
+        auto allocations = speudo_std::api_string_test::allocations_count();
+
+        api_string_type result = speudo_std::edit(std::move(astr), set_first);
+        EXPECT_TRUE(astr.empty());
+        EXPECT_EQ(result.data(), original);
+        EXPECT_EQ(result[0], 'X');
+        EXPECT_EQ(result.size(), this->even_bigger_raw_string_len());
+        EXPECT_EQ(speudo_std::api_string_test::allocations_count(), allocations);
+    }
+    {   // shared: copied
+        api_string_type astr_1 = this->even_bigger_raw_string();
+        api_string_type astr_2 = astr_1;
+        api_string_type result = speudo_std::edit(std::move(astr_2), set_first);
+        EXPECT_TRUE(astr_2.empty());
+        EXPECT_NE(result.data(), astr_1.data());
+        EXPECT_EQ(result[0], 'X');
+        EXPECT_EQ(astr_1[0], this->even_bigger_raw_string()[0]);
+    }
+    {   // not managed: copied
+        api_string_type astr = speudo_std::api_string_ref(this->even_bigger_raw_string());
+        api_string_type result = speudo_std::edit(std::move(astr), set_first);
+        EXPECT_EQ(result[0], 'X');
+        EXPECT_EQ(this->even_bigger_raw_string()[0], ' ');
+    }
+    {   // small string
+        api_string_type astr = this->small_raw_string();
+        api_string_type result = speudo_std::edit
+            ( std::move(astr)
+            , [](str_type& str) { str.push_back('X'); } );
+        EXPECT_EQ(result.size(), this->small_raw_string_len() + 1);
+        EXPECT_EQ(result[this->small_raw_string_len()], 'X');
+    }
+    EXPECT_EQ( speudo_std::api_string_test::allocations_count()
+             , speudo_std::api_string_test::deallocations_count() );
+}
+
+
+template <typename StringType, typename CharT>
+void test_same(const StringType& str, const std::basic_string<CharT>& expected)
+{
+    ASSERT_EQ(str.size(), expected.size());
+    EXPECT_TRUE(std::equal(str.begin(), str.end(), expected.begin()));
+    EXPECT_EQ(str.c_str()[str.size()], CharT{});
+}
+
+TYPED_TEST(basic_fixture, insert_erase_replace)
+{
+    using char_type = typename TestFixture::char_type;
+    using std_string = std::basic_string<char_type>;
+    using str_type = speudo_std::basic_string<char_type>;
+
+    const char_type* small = this->small_raw_string();
+    const char_type* bigger = this->even_bigger_raw_string();
+    {
+        str_type str = small;
+        std_string expected = small;
+        str.insert(1, 3, 'x');
+        expected.insert(1, 3, 'x');
+        test_same(str, expected);
+        str.insert(0, bigger, 5);
+        expected.insert(0, bigger, 5);
+        test_same(str, expected);
+        str.insert(str.size(), bigger);
+        expected.insert(expected.size(), bigger);
+        test_same(str, expected);
+        str.insert(str.cbegin() + 2, 'y');
+        expected.insert(expected.cbegin() + 2, 'y');
+        test_same(str, expected);
+        str.erase(3, 4);
+        expected.erase(3, 4);
+        test_same(str, expected);
+        expected.erase(expected.cbegin() + 1);
+        EXPECT_EQ(*str.erase(str.cbegin() + 1), expected[1]);
+        test_same(str, expected);
+        str.erase(str.cbegin() + 10, str.cend() - 10);
+        expected.erase(expected.cbegin() + 10, expected.cend() - 10);
+        test_same(str, expected);
+        str.replace(2, 3, small);
+        expected.replace(2, 3, small);
+        test_same(str, expected);
+        str.replace(str.cbegin(), str.cend() - 1, 2, 'z');
+        expected.replace(expected.cbegin(), expected.cend() - 1, 2, 'z');
+        test_same(str, expected);
+        str.erase();
+        EXPECT_TRUE(str.empty());
+    }
+    {   // shrinking or growing in place does not allocate
+        str_type str = bigger;
+        std_string expected = bigger;
+        str.reserve(2 * str.size());
+        const char_type* p = str.data();
+        auto allocations = speudo_std::api_string_test::allocations_count();
+        str.replace(1, 10, bigger, 20);
+        expected.replace(1, 10, bigger, 20);
+        str.erase(0, 5);
+        expected.erase(0, 5);
+        str.insert(3, small);
+        expected.insert(3, small);
+        test_same(str, expected);
+        EXPECT_EQ(str.data(), p);
+        EXPECT_EQ(speudo_std::api_string_test::allocations_count(), allocations);
+    }
+    {   // the inserted characters are part of the string
+        for (const char_type* input: {small, bigger})
+        {
+            const std::size_t len = std::char_traits<char_type>::length(input);
+            for (std::size_t pos: {0, 1, 3, 10, 20})
+            {
+                for (std::size_t count: {0, 1, 2, 8, 30})
+                {
+                    for (std::size_t src: {0, 1, 5, 12, 24})
+                    {
+                        for (std::size_t count2: {1, 3, 15})
+                        {
+                            pos = std::min(pos, len);
+                            src = std::min(src, len);
+                            count2 = std::min(count2, len - src);
+                            for (bool reserve: {false, true})
+                            {
+                                str_type str = input;
+                                std_string expected = input;
+                                if (reserve)
+                                {
+                                    str.reserve(3 * len);
+                                }
+                                str.replace(pos, count, str.c_str() + src, count2);
+                                expected.replace(pos, count, std_string(expected, src, count2));
+                                test_same(str, expected);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    {   // a shared string is copied
+        speudo_std::basic_api_string<char_type> astr = bigger;
+        str_type str{astr, speudo_std::copy_on_write};
+        str.erase(0, 1);
+        EXPECT_EQ(astr, bigger);
+        EXPECT_EQ(str.size(), astr.size() - 1);
+    }
+    {   // unless the result fits in the small string buffer
+        speudo_std::basic_api_string<char_type> astr = bigger;
+        str_type str{astr, speudo_std::copy_on_write};
+        const auto allocations = speudo_std::api_string_test::allocations_count();
+        str.erase(2);
+        EXPECT_EQ(speudo_std::api_string_test::allocations_count(), allocations);
+        test_same(str, std_string(bigger, 2));
+        EXPECT_EQ(astr, bigger);
+        str.insert(1, 1, 'x');
+        EXPECT_EQ(str.size(), 3);
+        EXPECT_EQ(str[1], 'x');
+        EXPECT_EQ(speudo_std::api_string_test::allocations_count(), allocations);
+    }
+    {
+        str_type str = small;
+        try
+        {
+            str.insert(str.size() + 1, 1, 'x');
+            ADD_FAILURE();
+        }
+        catch (const std::out_of_range& e)
+        {
+            EXPECT_STREQ(e.what(), "basic_string::insert: pos > size()");
+        }
+        try
+        {
+            str.erase(str.size() + 1);
+            ADD_FAILURE();
+        }
+        catch (const std::out_of_range& e)
+        {
+            EXPECT_STREQ(e.what(), "basic_string::erase: pos > size()");
+        }
+        EXPECT_THROW(str.insert(str.size() + 1, 1, 'x'), std::out_of_range);
+        EXPECT_THROW(str.erase(str.size() + 1), std::out_of_range);
+        EXPECT_THROW(str.replace(str.size() + 1, 1, small), std::out_of_range);
+    }
+    EXPECT_EQ( speudo_std::api_string_test::allocations_count()
+             , speudo_std::api_string_test::deallocations_count() );
+}
+
+TYPED_TEST(basic_fixture, substr_copy_find)
+{
+    using char_type = typename TestFixture::char_type;
+    using std_string = std::basic_string<char_type>;
+    using str_type = speudo_std::basic_string<char_type>;
+
+    const char_type* bigger = this->even_bigger_raw_string();
+    const str_type str = bigger;
+    const std_string expected = bigger;
+
+    test_same(str.substr(3, 7), expected.substr(3, 7));
+    test_same(str.substr(5), expected.substr(5));
+    EXPECT_THROW(str.substr(str.size() + 1), std::out_of_range);
+
+    char_type buff[10];
+    EXPECT_EQ(str.copy(buff, 10, 4), 10);
+    EXPECT_TRUE(std::equal(buff, buff + 10, bigger + 4));
+
+    const str_type needle = str.substr(str.size() / 2, 3);
+    const char_type* chars = needle.c_str();
+    EXPECT_EQ(str.find(needle), expected.find(chars));
+    EXPECT_EQ(str.find(needle, str.size() / 2 + 1), expected.find(chars, str.size() / 2 + 1));
+    EXPECT_EQ(str.find(chars, 0, 2), expected.find(chars, 0, 2));
+    EXPECT_EQ(str.find(char_type('a'), 10), expected.find(char_type('a'), 10));
+    EXPECT_EQ(str.find(char_type('~')), str_type::npos);
+    EXPECT_EQ(str.rfind(needle), expected.rfind(chars));
+    EXPECT_EQ(str.rfind(char_type('b')), expected.rfind(char_type('b')));
+    EXPECT_EQ(str.find_first_of(chars, 5), expected.find_first_of(chars, 5));
+    EXPECT_EQ(str.find_first_not_of(needle), expected.find_first_not_of(chars));
+    EXPECT_EQ(str.find_last_of(chars), expected.find_last_of(chars));
+    EXPECT_EQ(str.find_last_not_of(char_type('c'), 50), expected.find_last_not_of(char_type('c'), 50));
+}
 
 int main(int argc, char **argv) {
   ::testing::InitGoogleTest(&argc, argv);
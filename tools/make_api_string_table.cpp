@@ -0,0 +1,80 @@
+// Distributed under the Boost Software License, Version 1.0.
+//    (See accompanying file LICENSE_1_0.txt or copy at
+//          http://www.boost.org/LICENSE_1_0.txt)
+
+// Usage: make_api_string_table <input> <output>
+//
+// Writes the table of the distinct lines of <input> ( a text file with
+// one string per line ) into <output>, so that it can later be loaded with
+//
+//     speudo_std::api_string_table table{speudo_std::map_file(<output>)};
+
+#include <api_string_table.hpp>
+#include <api_string_io.hpp>
+#include <cstdio>
+#include <exception>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        std::fprintf(stderr, "usage: %s <input> <output>\n", argv[0]);
+        return 2;
+    }
+    try
+    {
+        int in = ::open(argv[1], O_RDONLY | O_CLOEXEC);
+        if (in < 0)
+        {
+            std::perror(argv[1]);
+            return 1;
+        }
+        std::vector<speudo_std::api_string> lines;
+        {
+            speudo_std::api_string_line_reader reader(in);
+            speudo_std::api_string line;
+            while (reader.getline(line))
+            {
+                lines.push_back(line);
+            }
+        }
+        ::close(in);
+
+        std::FILE* out = std::fopen(argv[2], "wb");
+        if (out == nullptr)
+        {
+            std::perror(argv[2]);
+            return 1;
+        }
+        bool write_failed = false;
+        speudo_std::write_api_string_table
+            ( lines.begin(), lines.end()
+            , [out, &write_failed](const char* bytes, std::size_t count)
+              {
+                  if ( ! write_failed && std::fwrite(bytes, 1, count, out) != count)
+                  {
+                      write_failed = true;
+                  }
+              } );
+        if (write_failed)
+        {
+            std::perror(argv[2]);
+            std::fclose(out);
+            return 1;
+        }
+        if (std::fclose(out) != 0)
+        {
+            std::perror(argv[2]);
+            return 1;
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}